@@ -0,0 +1,374 @@
+// anim.c - Reproductor de animaciones .ANI con regulador de fps
+//
+// Un fotograma RAW es una sola ventana del TFT; uno DELTA, una ventana por
+// segmento de teselas cambiadas. Los sectores llegan con CMD18 (un comando
+// por tramo contiguo del archivo) y se envan al TFT desde el buffer de
+// sector de fat_fs.c, alternando el bus entre los dos.
+
+#include "anim.h"
+#include "sd_spi.h"
+#include "tft_st7735.h"
+#include "cycles.h"
+#include "prof.h"
+
+#ifndef F_CPU
+#define F_CPU 8000000UL
+#endif
+
+ANIM_Stats g_anim_stats;
+
+static uint16_t ANIM_U16(const uint8_t *p)
+{
+	return p[0] | ((uint16_t)p[1] << 8);
+}
+
+// Sector del archivo -> LBA, y cuntos sectores contiguos quedan desde ah
+static uint32_t ANIM_SectorLBA(const ANIM_File *a, uint32_t sector, uint32_t *run)
+{
+	for (uint8_t i = 0; i < a->n_ext; i++) {
+		if (sector < a->ext[i].sectors) {
+			*run = a->ext[i].sectors - sector;
+			return a->ext[i].lba + sector;
+		}
+		sector -= a->ext[i].sectors;
+	}
+	*run = 0;
+	return 0;
+}
+
+uint8_t ANIM_Open(ANIM_File *a, const char *name)
+{
+	FAT_File f;
+	if (FAT_Open(&f, name) != 0) return ANIM_ERR_OPEN;
+
+	a->n_ext = FAT_GetExtents(&f, a->ext, ANIM_MAX_EXTENTS);
+	if (a->n_ext == 0) return ANIM_ERR_FRAG;
+
+	uint8_t *buf = FAT_SectorBuffer();
+	if (SD_ReadBlock(a->ext[0].lba, buf) != SD_OK) return ANIM_ERR_IO;
+
+	if (buf[0] != 'A' || buf[1] != 'N' || buf[2] != 'I' || buf[3] != '1')
+		return ANIM_ERR_FORMAT;
+
+	uint16_t w = ANIM_U16(&buf[4]);
+	uint16_t h = ANIM_U16(&buf[6]);
+	a->x = buf[8];
+	a->y = buf[9];
+	a->frames = ANIM_U16(&buf[10]);
+	a->fps = buf[12];
+	a->kind = buf[13];
+	a->frame_sectors = ANIM_U16(&buf[14]);
+
+	if (w == 0 || h == 0 || a->x + w > TFT_WIDTH || a->y + h > TFT_HEIGHT)
+		return ANIM_ERR_FORMAT;
+	a->w = (uint8_t)w;
+	a->h = (uint8_t)h;
+
+	uint32_t bytes = (uint32_t)w * h * 2;
+	if (a->frames == 0)
+		return ANIM_ERR_FORMAT;
+	if (a->kind == ANIM_KIND_RAW) {
+		if (a->frame_sectors < (bytes + 511) / 512 ||
+		    (1 + (uint32_t)a->frames * a->frame_sectors) * 512 > f.size_bytes)
+			return ANIM_ERR_FORMAT;
+	} else if (a->kind != ANIM_KIND_DELTA ||
+	           (1 + (uint32_t)a->frames) * 512 > f.size_bytes) {
+		return ANIM_ERR_FORMAT;
+	}
+
+	a->period = a->fps ? F_CPU / a->fps : 0;
+	ANIM_Rewind(a);
+	return ANIM_OK;
+}
+
+void ANIM_Rewind(ANIM_File *a)
+{
+	a->frame = 0;
+	a->next_sector = 1;
+	a->loop_shown = 0;
+	a->due = a->loop_t0 = CYC_Now();
+}
+
+// Fotograma f en su ventana; con scroll se parte en dos al dar la vuelta
+// la GRAM, igual que FCACHE_Replay.
+static uint8_t ANIM_Draw(const ANIM_File *a, uint16_t f)
+{
+	uint8_t *buf   = FAT_SectorBuffer();
+	uint32_t bytes = (uint32_t)a->w * a->h * 2;
+	uint32_t sector = 1 + (uint32_t)f * a->frame_sectors;
+	uint32_t sent = 0;
+
+	uint8_t  row0 = TFT_ScreenToGram(a->y);
+	uint8_t  fits = TFT_HEIGHT - row0;
+	uint32_t wrap_at = (a->h > fits) ? (uint32_t)fits * a->w * 2 : bytes;
+
+	TFT_SetAddrWindow(a->x, row0, a->x + a->w - 1,
+	                  (a->h > fits) ? TFT_HEIGHT - 1 : row0 + a->h - 1);
+
+	while (sent < bytes) {
+		uint32_t run;
+		uint32_t lba  = ANIM_SectorLBA(a, sector, &run);
+		uint32_t need = (bytes - sent + 511) / 512;
+		if (run == 0) return ANIM_ERR_IO;
+		if (run > need) run = need;
+
+		if (SD_ReadMultiStart(lba) != SD_OK) return ANIM_ERR_IO;
+
+		for (; run; run--, sector++) {
+			if (SD_ReadMultiNext(buf) != SD_OK) {
+				SD_ReadMultiStop();
+				return ANIM_ERR_IO;
+			}
+
+			uint16_t n = (bytes - sent > 512) ? 512 : (uint16_t)(bytes - sent);
+			uint16_t first = n;
+			if (sent < wrap_at && sent + n > wrap_at)
+				first = (uint16_t)(wrap_at - sent);
+
+			PROF_ENTER(PROF_TFT_WRITE);
+			TFT_StartWrite();
+			TFT_WriteBytes(buf, first);
+			TFT_EndWrite();
+
+			if (wrap_at < bytes && sent + first == wrap_at) {
+				TFT_SetAddrWindow(a->x, 0, a->x + a->w - 1, a->h - fits - 1);
+				if (first < n) {
+					TFT_StartWrite();
+					TFT_WriteBytes(buf + first, n - first);
+					TFT_EndWrite();
+				}
+			}
+			PROF_EXIT(PROF_TFT_WRITE);
+
+			sent += n;
+		}
+
+		if (SD_ReadMultiStop() != SD_OK) return ANIM_ERR_IO;
+	}
+
+	return ANIM_OK;
+}
+
+/* ---------- DELTA ---------- */
+
+// Lectura secuencial del fotograma en curso: un CMD18 abierto mientras
+// el tramo del archivo siga siendo contiguo.
+static uint32_t anim_sector;     // siguiente sector del archivo por leer
+static uint32_t anim_run;        // sectores que quedan en el CMD18 abierto
+static uint16_t anim_pos;        // bytes ya usados del buffer de sector
+static uint8_t  anim_reading;    // hay un CMD18 sin cerrar
+
+static void ANIM_StopRead(void)
+{
+	if (anim_reading) SD_ReadMultiStop();
+	anim_reading = 0;
+	anim_run = 0;
+}
+
+static uint8_t ANIM_NextSector(const ANIM_File *a)
+{
+	if (anim_run == 0) {
+		ANIM_StopRead();
+		uint32_t lba = ANIM_SectorLBA(a, anim_sector, &anim_run);
+		if (anim_run == 0 || SD_ReadMultiStart(lba) != SD_OK) {
+			anim_run = 0;
+			return ANIM_ERR_IO;
+		}
+		anim_reading = 1;
+	}
+
+	if (SD_ReadMultiNext(FAT_SectorBuffer()) != SD_OK) {
+		ANIM_StopRead();
+		return ANIM_ERR_IO;
+	}
+	anim_run--;
+	anim_sector++;
+	anim_pos = 0;
+	return ANIM_OK;
+}
+
+// Siguiente u16 (MSB primero); al acabarse el sector se lee otro
+static uint8_t ANIM_Get16(const ANIM_File *a, uint16_t *v)
+{
+	if (anim_pos == 512 && ANIM_NextSector(a) != ANIM_OK) return ANIM_ERR_IO;
+
+	const uint8_t *buf = FAT_SectorBuffer();
+	*v = (uint16_t)buf[anim_pos] << 8 | buf[anim_pos + 1];
+	anim_pos += 2;
+	return ANIM_OK;
+}
+
+// 'len' bytes de pxeles del fotograma al TFT (ventana ya fijada). Los
+// datos van alineados a 2 bytes, as que un pxel nunca queda partido
+// entre dos sectores.
+static uint8_t ANIM_Stream(const ANIM_File *a, uint16_t len)
+{
+	TFT_StartWrite();
+	while (len) {
+		if (anim_pos == 512) {
+			TFT_EndWrite();
+			if (ANIM_NextSector(a) != ANIM_OK) return ANIM_ERR_IO;
+			TFT_StartWrite();
+		}
+
+		uint16_t n = 512 - anim_pos;
+		if (n > len) n = len;
+
+		PROF_ENTER(PROF_TFT_WRITE);
+		TFT_WriteBytes(FAT_SectorBuffer() + anim_pos, n);
+		PROF_EXIT(PROF_TFT_WRITE);
+
+		anim_pos += n;
+		len -= n;
+	}
+	TFT_EndWrite();
+	return ANIM_OK;
+}
+
+// Un segmento: w x h en pantalla desde (x, y), partido en dos ventanas si
+// cruza la vuelta de la GRAM.
+static uint8_t ANIM_Segment(const ANIM_File *a, uint8_t x, uint8_t y,
+                            uint8_t w, uint8_t h, uint16_t head)
+{
+	uint16_t color = 0;
+	if ((head & ANIM_SEG_SOLID) && ANIM_Get16(a, &color) != ANIM_OK)
+		return ANIM_ERR_IO;
+
+	uint8_t row0 = TFT_ScreenToGram(y);
+	uint8_t fits = TFT_HEIGHT - row0;
+	uint8_t h0   = (h > fits) ? fits : h;
+
+	for (uint8_t part = 0; part < 2; part++) {
+		uint8_t gy = part ? 0 : row0;
+		uint8_t gh = part ? h - h0 : h0;
+		if (gh == 0) break;
+
+		if (head & ANIM_SEG_SOLID) {
+			TFT_FillRect(x, gy, w, gh, color);
+		} else {
+			TFT_SetAddrWindow(x, gy, x + w - 1, gy + gh - 1);
+			if (ANIM_Stream(a, (uint16_t)w * gh * 2) != ANIM_OK)
+				return ANIM_ERR_IO;
+		}
+	}
+	return ANIM_OK;
+}
+
+// Mapa de teselas: 132x162 -> 17x21 teselas, 45 bytes
+#define ANIM_TX_MAX    ((TFT_WIDTH  + ANIM_TILE - 1) / ANIM_TILE)
+#define ANIM_TY_MAX    ((TFT_HEIGHT + ANIM_TILE - 1) / ANIM_TILE)
+#define ANIM_MAP_MAX   ((ANIM_TX_MAX * ANIM_TY_MAX + 7) / 8)
+
+#define ANIM_MAP_BIT(map, t)  ((map)[(t) >> 3] & (1 << ((t) & 7)))
+
+// Recorre el mapa y dibuja los segmentos de cada tramo de teselas
+static uint8_t ANIM_DeltaTiles(const ANIM_File *a, const uint8_t *map,
+                               uint8_t ntx, uint8_t nty)
+{
+	uint16_t t = 0;
+
+	for (uint8_t ty = 0; ty < nty; ty++, t += ntx) {
+		uint8_t y = a->y + ty * ANIM_TILE;
+		uint8_t h = (a->h - ty * ANIM_TILE < ANIM_TILE) ? a->h - ty * ANIM_TILE : ANIM_TILE;
+
+		for (uint8_t tx = 0; tx < ntx; ) {
+			if (!ANIM_MAP_BIT(map, t + tx)) {
+				tx++;
+				continue;
+			}
+
+			// Tramo de teselas cambiadas: segmentos hasta cubrirlo
+			uint8_t end = tx + 1;
+			while (end < ntx && ANIM_MAP_BIT(map, t + end))
+				end++;
+
+			while (tx < end) {
+				uint16_t head;
+				if (ANIM_Get16(a, &head) != ANIM_OK) return ANIM_ERR_IO;
+
+				uint16_t n = head & ~ANIM_SEG_SOLID;
+				if (n == 0 || n > end - tx) return ANIM_ERR_FORMAT;
+
+				uint8_t x = tx * ANIM_TILE;
+				uint8_t w = (x + n * ANIM_TILE > a->w) ? a->w - x : n * ANIM_TILE;
+				if (ANIM_Segment(a, a->x + x, y, w, h, head) != ANIM_OK)
+					return ANIM_ERR_IO;
+				tx += n;
+			}
+		}
+	}
+	return ANIM_OK;
+}
+
+static uint8_t ANIM_DrawDelta(ANIM_File *a)
+{
+	uint8_t  map[ANIM_MAP_MAX];
+	uint8_t  ntx = (a->w + ANIM_TILE - 1) / ANIM_TILE;
+	uint8_t  nty = (a->h + ANIM_TILE - 1) / ANIM_TILE;
+	uint16_t map_len = ((uint16_t)ntx * nty + 7) / 8;
+
+	anim_sector = a->next_sector;
+	if (ANIM_NextSector(a) != ANIM_OK) return ANIM_ERR_IO;
+
+	// El mapa cabe siempre en el primer sector
+	for (uint8_t i = 0; i < map_len; i++)
+		map[i] = FAT_SectorBuffer()[i];
+	anim_pos = (map_len + 1) & ~1u;
+
+	uint8_t err = ANIM_DeltaTiles(a, map, ntx, nty);
+
+	ANIM_StopRead();
+	a->next_sector = anim_sector;
+	return err;
+}
+
+uint8_t ANIM_Step(ANIM_File *a)
+{
+	if (a->period) {
+		uint32_t now = CYC_Now();
+		if ((int32_t)(a->due - now) > 0) return ANIM_IDLE;
+
+		// Periodos enteros perdidos: esos fotogramas ya no se muestran.
+		// El ltimo de la vuelta se muestra siempre.
+		uint32_t late = (now - a->due) / a->period;
+		uint16_t left = a->frames - 1 - a->frame;
+		if (late > left) late = left;
+
+		if (a->kind == ANIM_KIND_DELTA) {
+			if (late) a->due = now;
+		} else {
+			a->frame += (uint16_t)late;
+			a->due   += late * a->period;
+			g_anim_stats.dropped += late;
+		}
+	}
+
+	uint8_t err;
+
+	PROF_ENTER(PROF_FRAME);
+	if (a->kind == ANIM_KIND_DELTA)
+		err = ANIM_DrawDelta(a);
+	else
+		err = ANIM_Draw(a, a->frame);
+	PROF_EXIT(PROF_FRAME);
+
+	if (err != ANIM_OK) return ANIM_ERROR;
+
+	g_anim_stats.shown++;
+	a->loop_shown++;
+	a->due += a->period;
+
+	if (++a->frame < a->frames) return ANIM_FRAME;
+
+	// Fin de vuelta: fps reales
+	uint32_t now = CYC_Now();
+	uint32_t ms  = (now - a->loop_t0) / (F_CPU / 1000UL);
+	g_anim_stats.fps_x10 = ms ? (uint16_t)((uint32_t)a->loop_shown * 10000UL / ms) : 0;
+
+	a->frame = 0;
+	a->next_sector = 1;
+	a->loop_shown = 0;
+	a->loop_t0 = now;
+	if (!a->period) a->due = now;
+	return ANIM_LOOP;
+}
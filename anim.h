@@ -0,0 +1,97 @@
+// anim.h - Animaciones RGB565 en crudo desde la SD (archivos .ANI)
+#ifndef ANIM_H_
+#define ANIM_H_
+
+#include <stdint.h>
+#include "fat_fs.h"
+
+// Formato .ANI (little endian), todo alineado a sector:
+//   sector 0, cabecera:
+//     0  "ANI1"
+//     4  u16 ancho, u16 alto      rectngulo de cada fotograma
+//     8  u8 x, u8 y               posicin en pantalla
+//     10 u16 fotogramas
+//     12 u8 fps objetivo (0 = lo ms rpido posible), u8 tipo
+//     14 u16 sectores por fotograma (en DELTA, el del fotograma ms largo)
+//
+// Tipo RAW: sector 1 + i * sectores_por_fotograma: fotograma i en RGB565
+// (MSB primero), fila a fila, tal cual se enva al TFT.
+//
+// Tipo DELTA: el rectngulo se divide en teselas de 8x8 (las del borde
+// derecho e inferior pueden ser menores) y cada fotograma solo lleva las
+// que cambian respecto al anterior. El fotograma 0 las lleva todas. Los
+// fotogramas van seguidos desde el sector 1, cada uno empezando en sector
+// nuevo; dentro de uno todo va alineado a 2 bytes y los u16 con el MSB
+// primero, como los pxeles:
+//   mapa de teselas cambiadas, 1 bit por tesela en orden de filas (bit 0
+//   del byte 0 = arriba a la izquierda), rellenado a tamao par;
+//   despus, por cada tramo horizontal de teselas cambiadas, segmentos
+//   que lo cubren de izquierda a derecha:
+//     u16 cabecera: bit 15 = slido, bits 0-14 = teselas
+//     slido: u16 color de todas ellas
+//     si no:  los pxeles de la ventana que forman, fila a fila
+// host/mkani.c los genera a partir de BMPs.
+
+#define ANIM_EXT          "ANI"
+#define ANIM_MAX_EXTENTS  8     // el archivo puede estar fragmentado
+
+#define ANIM_KIND_RAW     0
+#define ANIM_KIND_DELTA   1
+#define ANIM_TILE         8     // lado de las teselas DELTA
+#define ANIM_SEG_SOLID    0x8000
+
+#define ANIM_OK           0
+#define ANIM_ERR_OPEN     1
+#define ANIM_ERR_FORMAT   2
+#define ANIM_ERR_FRAG     3     // ms tramos que ANIM_MAX_EXTENTS
+#define ANIM_ERR_IO       4
+
+typedef struct {
+	uint8_t    x, y, w, h;
+	uint16_t   frames;
+	uint8_t    fps;
+	uint8_t    kind;
+	uint16_t   frame_sectors;
+	FAT_Extent ext[ANIM_MAX_EXTENTS];
+	uint8_t    n_ext;
+
+	// Reproduccin
+	uint16_t   frame;         // siguiente fotograma
+	uint32_t   next_sector;   // DELTA: donde empieza el siguiente
+	uint32_t   period;        // ciclos de CPU por fotograma (0 = sin lmite)
+	uint32_t   due;           // CYC_Now en que toca el siguiente
+	uint32_t   loop_t0;
+	uint16_t   loop_shown;
+} ANIM_File;
+
+// Contadores (para diagnstico, no se reinician)
+typedef struct {
+	uint32_t shown;
+	uint32_t dropped;         // saltados por ir tarde
+	uint16_t fps_x10;         // fps reales de la ltima vuelta completa
+} ANIM_Stats;
+
+extern ANIM_Stats g_anim_stats;
+
+// Lee la cabecera y resuelve los tramos del archivo. Requiere SD_Init(),
+// FAT_Init() y el Timer1 en marcha (CYC_Init).
+uint8_t ANIM_Open(ANIM_File *a, const char *name);
+
+// Vuelve al fotograma 0; el ritmo cuenta desde ahora
+void ANIM_Rewind(ANIM_File *a);
+
+// Resultado de ANIM_Step
+#define ANIM_IDLE   0     // todava no toca el siguiente fotograma
+#define ANIM_FRAME  1     // se present un fotograma
+#define ANIM_LOOP   2     // se present el ltimo de la vuelta
+#define ANIM_ERROR  3     // no se pudo leer el fotograma: hay que pararla
+
+// Presenta el siguiente fotograma si ya es su momento; si no, vuelve
+// enseguida. Si se va tarde ms de un periodo entero se saltan los
+// fotogramas atrasados (RAW); un DELTA no se puede saltar, as que se
+// muestra tarde y el ritmo vuelve a contar desde ah.
+// Tras ANIM_ERROR la animacin no avanza (un DELTA ya no tiene base
+// vlida): ANIM_Rewind o pasar a otra cosa.
+uint8_t ANIM_Step(ANIM_File *a);
+
+#endif /* ANIM_H_ */
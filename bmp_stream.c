@@ -1,11 +1,18 @@
 // bmp_stream.c
 #include "bmp_stream.h"
+#include "tft_st7735.h"
+#include "prof.h"
 #include <string.h>
 
 uint8_t BMP_Open(BMP_Image *bmp, const char *filename)
 {
 	if (FAT_Open(&bmp->file, filename) != 0) return 1;
 
+	// Las filas se piden con FAT_FileSector, que supone clsteres
+	// contiguos: de un BMP fragmentado leera sectores de otros archivos
+	FAT_Extent ext;
+	if (FAT_GetExtents(&bmp->file, &ext, 1) != 1) return 5;
+
 	uint8_t header[54];
 	if (FAT_Read(&bmp->file, header, 54) != 54) return 2;
 
@@ -32,7 +39,8 @@ uint8_t BMP_Open(BMP_Image *bmp, const char *filename)
 	return 0;
 }
 
-uint8_t BMP_ReadRow(BMP_Image *bmp, uint32_t y, uint16_t *line_buf)
+// Desplazamiento en el archivo del primer byte de la fila 'y' de pantalla
+static uint32_t BMP_RowOffset(const BMP_Image *bmp, uint32_t y)
 {
 	uint32_t row_index = y;
 	if (bmp->bottom_up) {
@@ -40,27 +48,69 @@ uint8_t BMP_ReadRow(BMP_Image *bmp, uint32_t y, uint16_t *line_buf)
 	}
 
 	uint32_t row_size_bytes = ((bmp->width * 3 + 3) / 4) * 4; // alineado a 4
-	uint32_t offset = bmp->data_offset + row_index * row_size_bytes;
-
-	// Mover puntero de archivo a offset deseado
-	bmp->file.current_pos = offset;
+	return bmp->data_offset + row_index * row_size_bytes;
+}
 
-	static uint8_t row_buf[512]; // suficiente para widths pequeas; para 128x160 ok (128*3=384)
-	if (row_size_bytes > sizeof(row_buf)) return 1; // muy grande para este ejemplo
+uint8_t BMP_PrefetchRow(BMP_Image *bmp, uint32_t y)
+{
+	uint32_t offset = BMP_RowOffset(bmp, y);
+	if (offset >= bmp->file.size_bytes) return 2;
 
-	if (FAT_Read(&bmp->file, row_buf, row_size_bytes) != (int16_t)row_size_bytes) return 2;
+	return FAT_LoadSector(FAT_FileSector(&bmp->file, offset)) ? 0 : 2;
+}
 
-	// Convertir BGR888 a RGB565
-	for (uint32_t x=0; x<bmp->width; x++) {
-		uint8_t b = row_buf[x*3 + 0];
-		uint8_t g = row_buf[x*3 + 1];
-		uint8_t r = row_buf[x*3 + 2];
+uint8_t BMP_StreamRow(BMP_Image *bmp, uint32_t y)
+{
+	uint32_t offset = BMP_RowOffset(bmp, y);
+	uint16_t left   = (uint16_t)(bmp->width * 3);             // sin el relleno
 
-		uint16_t r5 = (r >> 3) & 0x1F;
-		uint16_t g6 = (g >> 2) & 0x3F;
-		uint16_t b5 = (b >> 3) & 0x1F;
+	if (offset + left > bmp->file.size_bytes) {
+		TFT_WriteColorRun(0x0000, (uint16_t)bmp->width);
+		return 2;
+	}
 
-		line_buf[x] = (r5 << 11) | (g6 << 5) | b5;
+	const uint8_t *sec;
+	uint8_t  carry[3];   // pxel partido entre dos sectores (512 % 3 != 0)
+	uint8_t  nc = 0;
+
+	while (left > 0) {
+		uint16_t pos   = (uint16_t)(offset % 512);
+		uint16_t avail = 512 - pos;
+		if (avail > left) avail = left;
+
+		// Filas vecinas comparten sector: solo se lee si no est ya. La SD
+		// y el TFT comparten el bus: pausar la rfaga para leer.
+		uint32_t lba   = FAT_FileSector(&bmp->file, offset);
+		uint8_t  pause = !FAT_SectorLoaded(lba);
+
+		if (pause) TFT_EndWrite();
+		sec = FAT_LoadSector(lba);
+		if (pause) TFT_StartWrite();
+		if (!sec) {
+			// Completar la fila en negro para no desbordar la ventana
+			TFT_WriteColorRun(0x0000, (uint16_t)((left + nc) / 3));
+			return 2;
+		}
+
+		const uint8_t *p = sec + pos;
+		uint16_t k = avail;
+
+		PROF_ENTER(PROF_BMP_CONVERT);
+		if (nc) {
+			while (nc < 3) { carry[nc++] = *p++; k--; }
+			TFT_WriteBGR888(carry, 1);
+			nc = 0;
+		}
+
+		uint16_t whole = k / 3;
+		TFT_WriteBGR888(p, whole);
+		p += whole * 3;
+		k -= whole * 3;
+		while (k--) carry[nc++] = *p++;
+		PROF_EXIT(PROF_BMP_CONVERT);
+
+		offset += avail;
+		left   -= avail;
 	}
 
 	return 0;
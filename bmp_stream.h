@@ -14,11 +14,21 @@ typedef struct {
 	uint8_t bottom_up;
 } BMP_Image;
 
-// Abre un BMP 24-bit sin compresin
+// Abre un BMP 24-bit sin compresin. Devuelve 5 si el archivo no est
+// en un solo tramo de sectores (FAT_GetExtents): las filas se leen por
+// desplazamiento desde el primer clster.
 uint8_t BMP_Open(BMP_Image *bmp, const char *filename);
 
-// Lee una fila y la convierte a RGB565
-// y: 0 = fila superior en pantalla
-uint8_t BMP_ReadRow(BMP_Image *bmp, uint32_t y, uint16_t *line_buf);
+// Enva la fila 'y' (width pxeles) a la rfaga TFT abierta, convertida
+// al vuelo desde el buffer de sector, sin buffer de fila. Pausa la
+// rfaga (TFT_EndWrite / TFT_StartWrite) en cada lectura de la SD.
+// Si una lectura falla el resto de la fila sale en negro. Lee con
+// FAT_LoadSector(): el sector que ya est en el buffer no se vuelve a
+// pedir a la SD.
+uint8_t BMP_StreamRow(BMP_Image *bmp, uint32_t y);
+
+// Deja en el buffer de sector el primer sector de la fila 'y', para que
+// el BMP_StreamRow que la pida no tenga que esperar a la SD
+uint8_t BMP_PrefetchRow(BMP_Image *bmp, uint32_t y);
 
 #endif /* BMP_STREAM_H_ */
@@ -0,0 +1,90 @@
+// board.h - Conexionado de la placa (bus SPI, TFT, SD y botones)
+//
+// Una seccin por placa; se elige al compilar (-DBOARD_PORTB_ONLY...) y
+// sin nada se usa la del prototipo. Todo son constantes: las primitivas
+// de spi_hal.h quedan en SBI/CBI sobre el puerto, sin coste en tiempo
+// de ejecucin por cambiar de placa.
+//
+// Los CS, DC y RST tienen que ir a los puertos A-D (direcciones de E/S
+// bajas, donde existen SBI y CBI), y llevan la letra de su puerto en
+// _PORT_ID para que host/bench_avr.c los enganche en simavr. PB4 (SS)
+// sale como salida en SPI_Init aunque no sea un CS: como entrada a 0
+// pasara el SPI a esclavo.
+#ifndef BOARD_H_
+#define BOARD_H_
+
+#include <avr/io.h>
+
+// SPI por hardware del ATmega32: fijo en todas las placas
+#define SPI_DDR      DDRB
+#define SPI_PORT     PORTB
+#define SPI_PIN_REG  PINB
+
+#define SPI_SS       PB4
+#define SPI_MOSI     PB5
+#define SPI_MISO     PB6
+#define SPI_SCK      PB7
+
+#if defined(BOARD_PORTB_ONLY)
+// Todo el bus en el puerto B: la SD en PB3 deja PD2 (INT0) libre
+#define TFT_CS_DDR      DDRB
+#define TFT_CS_PORT     PORTB
+#define TFT_CS_PORT_ID  'B'
+#define TFT_CS_PIN      PB4
+
+#define SD_CS_DDR       DDRB
+#define SD_CS_PORT      PORTB
+#define SD_CS_PORT_ID   'B'
+#define SD_CS_PIN       PB3
+
+#define TFT_DC_DDR      DDRB
+#define TFT_DC_PORT     PORTB
+#define TFT_DC_PORT_ID  'B'
+#define TFT_DC_PIN      PB1
+
+#define TFT_RST_DDR     DDRB
+#define TFT_RST_PORT    PORTB
+#define TFT_RST_PORT_ID 'B'
+#define TFT_RST_PIN     PB0
+
+#else
+// Prototipo: TFT en PB4 (SS), PB1 y PB0; SD en PD2
+#define TFT_CS_DDR      DDRB
+#define TFT_CS_PORT     PORTB
+#define TFT_CS_PORT_ID  'B'
+#define TFT_CS_PIN      PB4
+
+#define SD_CS_DDR       DDRD
+#define SD_CS_PORT      PORTD
+#define SD_CS_PORT_ID   'D'
+#define SD_CS_PIN       PD2
+
+#define TFT_DC_DDR      DDRB
+#define TFT_DC_PORT     PORTB
+#define TFT_DC_PORT_ID  'B'
+#define TFT_DC_PIN      PB1
+
+#define TFT_RST_DDR     DDRB
+#define TFT_RST_PORT    PORTB
+#define TFT_RST_PORT_ID 'B'
+#define TFT_RST_PIN     PB0
+#endif
+
+// Botones, activos a nivel bajo con pull-up (buttons.c). PD0/PD1 son
+// RXD/TXD de la USART (uart_stream.c).
+#define BTN_MODE_DDR       DDRD     // visor <-> fractal
+#define BTN_MODE_PORT      PORTD
+#define BTN_MODE_PINREG    PIND
+#define BTN_MODE_BIT       PD3
+
+#define BTN_FRACTAL_DDR    DDRD     // Mandelbrot <-> Julia
+#define BTN_FRACTAL_PORT   PORTD
+#define BTN_FRACTAL_PINREG PIND
+#define BTN_FRACTAL_BIT    PD4
+
+// Pan / zoom y dems: los ocho en el mismo puerto, bit = evento (buttons.h)
+#define BTN_NAV_DDR        DDRA
+#define BTN_NAV_PORT       PORTA
+#define BTN_NAV_PINREG     PINA
+
+#endif /* BOARD_H_ */
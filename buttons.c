@@ -0,0 +1,106 @@
+// buttons.c - Botones muestreados por el Timer0, con cola de eventos
+#include "buttons.h"
+#include "board.h"
+#include <avr/io.h>
+#include <avr/interrupt.h>
+
+#ifndef F_CPU
+#define F_CPU 8000000UL
+#endif
+
+// clk/64 y CTC: F_CPU / 64 / (OCR0 + 1) = 1000 / BTN_TICK_MS
+#define BTN_OCR0       (F_CPU / 64UL / (1000UL / BTN_TICK_MS) - 1)
+#define BTN_QUEUE_MASK (BTN_QUEUE_SIZE - 1)
+#define BTN_NAV_MASK   0xFF
+
+static volatile uint16_t btn_ticks;
+static uint8_t  btn_div = BTN_SAMPLE_TICKS;
+static uint16_t btn_state;                 // estado ya filtrado, 1 = pulsado
+static uint16_t btn_ct0 = 0xFFFF, btn_ct1 = 0xFFFF;
+
+static volatile uint8_t btn_queue[BTN_QUEUE_SIZE];
+static volatile uint8_t btn_head;          // lo escribe la ISR
+static volatile uint8_t btn_tail;          // lo escribe BTN_GetEvent
+
+// Un bit por evento, 1 = pulsado ahora mismo (sin filtrar)
+static inline uint16_t BTN_Sample(void)
+{
+	uint16_t s = (uint8_t)~BTN_NAV_PINREG & BTN_NAV_MASK;
+
+	if (!(BTN_MODE_PINREG & (1<<BTN_MODE_BIT)))       s |= 1u << BTN_EV_MODE;
+	if (!(BTN_FRACTAL_PINREG & (1<<BTN_FRACTAL_BIT))) s |= 1u << BTN_EV_FRACTAL;
+	return s;
+}
+
+// Cola llena: la pulsacin se pierde (con 8 huecos no pasa a mano)
+static inline void BTN_Post(uint8_t ev)
+{
+	uint8_t head = btn_head;
+	uint8_t next = (head + 1) & BTN_QUEUE_MASK;
+
+	if (next != btn_tail) {
+		btn_queue[head] = ev;
+		btn_head = next;
+	}
+}
+
+ISR(TIMER0_COMP_vect)
+{
+	btn_ticks++;
+	if (--btn_div) return;
+	btn_div = BTN_SAMPLE_TICKS;
+
+	// Contador vertical: bit a bit, ct1:ct0 baja de 3 a 0 mientras la
+	// muestra difiere del estado filtrado y vuelve a 3 si coincide; al
+	// pasar de 0 el estado cambia
+	uint16_t i = btn_state ^ BTN_Sample();
+	btn_ct0 = ~(btn_ct0 & i);
+	btn_ct1 = btn_ct0 ^ (btn_ct1 & i);
+	i &= btn_ct0 & btn_ct1;
+	btn_state ^= i;
+
+	i &= btn_state;                        // los que acaban de bajar
+	for (uint8_t ev = 0; i; ev++, i >>= 1)
+		if (i & 1) BTN_Post(ev);
+}
+
+void BTN_Init(void)
+{
+	BTN_MODE_DDR     &= (uint8_t)~(1<<BTN_MODE_BIT);
+	BTN_MODE_PORT    |= (1<<BTN_MODE_BIT);
+	BTN_FRACTAL_DDR  &= (uint8_t)~(1<<BTN_FRACTAL_BIT);
+	BTN_FRACTAL_PORT |= (1<<BTN_FRACTAL_BIT);
+	BTN_NAV_DDR      &= (uint8_t)~BTN_NAV_MASK;
+	BTN_NAV_PORT     |= BTN_NAV_MASK;
+
+	btn_head = btn_tail = 0;
+
+	OCR0  = (uint8_t)BTN_OCR0;
+	TCNT0 = 0;
+	TCCR0 = (1<<WGM01) | (1<<CS01) | (1<<CS00);    // CTC, clk/64
+	TIMSK |= (1<<OCIE0);
+}
+
+uint8_t BTN_GetEvent(void)
+{
+	uint8_t tail = btn_tail;
+	if (tail == btn_head) return BTN_NONE;
+
+	uint8_t ev = btn_queue[tail];
+	btn_tail = (tail + 1) & BTN_QUEUE_MASK;
+	return ev;
+}
+
+uint8_t BTN_Pending(void)
+{
+	return btn_tail != btn_head;
+}
+
+uint16_t BTN_Ticks(void)
+{
+	uint8_t sreg = SREG;
+	cli();
+	uint16_t t = btn_ticks;
+	SREG = sreg;
+	return t;
+}
@@ -0,0 +1,42 @@
+// buttons.h - Botones muestreados por el Timer0, con cola de eventos
+#ifndef BUTTONS_H_
+#define BUTTONS_H_
+
+#include <stdint.h>
+
+// La ISR del Timer0 salta cada BTN_TICK_MS. Cada BTN_SAMPLE_TICKS lee
+// todos los botones y un contador por botn (vertical, de 2 bits) da por
+// bueno un cambio tras 4 muestras iguales seguidas: 20 ms, lo mismo que
+// esperaba antes el sondeo tras cada flanco. Cada pulsacin deja un
+// evento en la cola, aunque el bucle principal est a mitad de un dibujo.
+#define BTN_TICK_MS        1
+#define BTN_SAMPLE_TICKS   5
+#define BTN_QUEUE_SIZE     8    // potencia de 2
+
+// Eventos: los de navegacin son el bit de su pin en BTN_NAV_PINREG
+#define BTN_EV_UP          0
+#define BTN_EV_DOWN        1
+#define BTN_EV_LEFT        2
+#define BTN_EV_RIGHT       3
+#define BTN_EV_ZOOM_IN     4
+#define BTN_EV_ZOOM_OUT    5
+#define BTN_EV_PALETTE     6    // animacin de paleta
+#define BTN_EV_HUD         7    // banda de diagnstico (en los dos modos)
+#define BTN_EV_MODE        8
+#define BTN_EV_FRACTAL     9
+#define BTN_NONE           0xFF
+
+// Entradas con pull-up y Timer0 en CTC a 1 kHz. Hacen falta las
+// interrupciones (sei()).
+void BTN_Init(void);
+
+// Siguiente pulsacin, en orden, o BTN_NONE
+uint8_t BTN_GetEvent(void);
+
+// 1 si hay eventos en la cola (sin sacarlos)
+uint8_t BTN_Pending(void);
+
+// Milisegundos desde BTN_Init (de 16 bits: da la vuelta a los 65 s)
+uint16_t BTN_Ticks(void);
+
+#endif /* BUTTONS_H_ */
@@ -0,0 +1,40 @@
+// cycles.c
+#include "cycles.h"
+#include <avr/io.h>
+#include <avr/interrupt.h>
+
+static volatile uint16_t cyc_high;
+
+ISR(TIMER1_OVF_vect)
+{
+	cyc_high++;
+}
+
+void CYC_Init(void)
+{
+	TCCR1A = 0;
+	TCCR1B = 0;
+	TCNT1  = 0;
+	cyc_high = 0;
+
+	TIFR  = (1<<TOV1);          // limpiar un desborde pendiente
+	TIMSK |= (1<<TOIE1);
+	TCCR1B = (1<<CS10);         // clk/1
+}
+
+uint32_t CYC_Now(void)
+{
+	uint8_t sreg = SREG;
+	cli();
+
+	uint16_t low  = TCNT1;
+	uint16_t high = cyc_high;
+
+	// Desborde ocurrido con las interrupciones cortadas: la ISR todava
+	// no sum, pero TCNT1 ya dio la vuelta
+	if ((TIFR & (1<<TOV1)) && low < 0x8000)
+		high++;
+
+	SREG = sreg;
+	return ((uint32_t)high << 16) | low;
+}
@@ -0,0 +1,14 @@
+// cycles.h - Contador de ciclos de CPU con el Timer1
+#ifndef CYCLES_H_
+#define CYCLES_H_
+
+#include <stdint.h>
+
+// Timer1 sin prescaler + interrupcin de desborde: 32 bits de ciclos
+// (~536 s a 8 MHz). Necesita interrupciones habilitadas (sei()).
+void CYC_Init(void);
+
+// Ciclos desde CYC_Init
+uint32_t CYC_Now(void);
+
+#endif /* CYCLES_H_ */
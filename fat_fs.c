@@ -1,10 +1,12 @@
-// fat_fs.c - Versin SIMPLE para SD pequea en FAT (FAT12/16 con root fijo)
+// fat_fs.c - Versin SIMPLE para SD en FAT (FAT12/16 con root fijo o FAT32)
 // NOTA IMPORTANTE:
-//  - Asume archivos NO fragmentados (clsteres contiguos).
-//  - Root directory fijo (FAT12/16), como en una SD de 4MB de Proteus.
+//  - FAT_Read y FAT_FileSector asumen archivos NO fragmentados (clsteres
+//    contiguos); FAT_GetExtents s sigue la cadena.
+//  - Solo el root directory (fijo en FAT12/16, cadena de clsteres en FAT32).
 
 #include "fat_fs.h"
 #include "sd_spi.h"
+#include "prof.h"
 #include <string.h>
 #include <stdint.h>
 
@@ -12,49 +14,224 @@ FAT_Info g_fat;
 
 static uint8_t sector_buffer[512];
 
+// LBA cuyo contenido hay en sector_buffer. Quien pide el buffer con
+// FAT_SectorBuffer() puede escribir en l, as que eso lo invalida.
+#define FAT_NO_SECTOR  0xFFFFFFFFUL
+static uint32_t sector_lba = FAT_NO_SECTOR;
+
 // -----------------------------------------------------------------------------
-// Leer un sector fsico en sector_buffer
+// Leer un sector fsico en sector_buffer (si no est ya)
 // -----------------------------------------------------------------------------
 static uint8_t FAT_ReadSector(uint32_t lba)
 {
-	return SD_ReadBlock(lba, sector_buffer);
+	if (lba == sector_lba) return SD_OK;
+
+	uint8_t r = SD_ReadBlock(lba, sector_buffer);
+	sector_lba = (r == SD_OK) ? lba : FAT_NO_SECTOR;
+	return r;
 }
 
 // -----------------------------------------------------------------------------
-// Inicializacin FAT (FAT12/16 root fijo)
+// Inicializacin FAT
 // -----------------------------------------------------------------------------
+
+static uint16_t FAT_U16(const uint8_t *p)
+{
+	return p[0] | ((uint16_t)p[1] << 8);
+}
+
+static uint32_t FAT_U32(const uint8_t *p)
+{
+	return FAT_U16(p) | ((uint32_t)FAT_U16(p + 2) << 16);
+}
+
+// Es un boot sector FAT? Salto inicial y un BPB con sentido
+static uint8_t FAT_IsBoot(const uint8_t *b)
+{
+	uint8_t spc = b[13];
+	return (b[0] == 0xEB || b[0] == 0xE9) &&
+	       FAT_U16(&b[11]) == 512 &&
+	       spc != 0 && (spc & (spc - 1)) == 0 &&
+	       b[16] != 0;
+}
+
 uint8_t FAT_Init(void)
 {
-	// Leer sector 0 (boot sector, sin MBR)
+	uint32_t volume = 0;
+
+	// Sector 0: boot del volumen o MBR con la tabla de particiones
 	if (FAT_ReadSector(0) != SD_OK) return 1;
 
-	uint16_t bytes_per_sector    = sector_buffer[11] | ((uint16_t)sector_buffer[12] << 8);
+	if (!FAT_IsBoot(sector_buffer)) {
+		if (sector_buffer[510] != 0x55 || sector_buffer[511] != 0xAA) return 1;
+
+		// Primera particin FAT12/16/32
+		for (uint8_t i = 0; i < 4 && !volume; i++) {
+			const uint8_t *pe = &sector_buffer[0x1BE + i * 16];
+			uint8_t type = pe[4];
+			if (type == 0x01 || type == 0x04 || type == 0x06 ||
+			    type == 0x0B || type == 0x0C || type == 0x0E)
+				volume = FAT_U32(&pe[8]);
+		}
+		if (!volume) return 1;
+
+		if (FAT_ReadSector(volume) != SD_OK) return 1;
+		if (!FAT_IsBoot(sector_buffer)) return 1;
+	}
+
+	uint16_t bytes_per_sector    = FAT_U16(&sector_buffer[11]);
 	uint8_t  sectors_per_cluster = sector_buffer[13];
-	uint16_t reserved_sectors    = sector_buffer[14] | ((uint16_t)sector_buffer[15] << 8);
+	uint16_t reserved_sectors    = FAT_U16(&sector_buffer[14]);
 	uint8_t  num_fats            = sector_buffer[16];
-	uint16_t root_entries        = sector_buffer[17] | ((uint16_t)sector_buffer[18] << 8);
-	uint16_t fatsz16             = sector_buffer[22] | ((uint16_t)sector_buffer[23] << 8);
+	uint16_t root_entries        = FAT_U16(&sector_buffer[17]);
+	uint32_t total_sectors       = FAT_U16(&sector_buffer[19]);
+	uint32_t fat_size            = FAT_U16(&sector_buffer[22]);
+
+	if (total_sectors == 0) total_sectors = FAT_U32(&sector_buffer[32]);
+	if (fat_size == 0)      fat_size      = FAT_U32(&sector_buffer[36]);   // FAT32
 
 	g_fat.bytes_per_sector    = bytes_per_sector;
 	g_fat.sectors_per_cluster = sectors_per_cluster;
 	g_fat.root_entry_count    = root_entries;
+	g_fat.volume_start        = volume;
 
-	uint32_t fat_size = fatsz16;   // en tu SD de 4MB es FAT12/FAT16
-
-	// Sectores que ocupa el root dir
+	// Sectores que ocupa el root dir (0 en FAT32)
 	uint32_t root_dir_sectors =
 	((uint32_t)root_entries * 32 + (bytes_per_sector - 1)) / bytes_per_sector;
 
-	g_fat.fat_start_sector  = reserved_sectors;
-	g_fat.root_dir_sector   = reserved_sectors + (num_fats * fat_size);
+	g_fat.fat_start_sector  = volume + reserved_sectors;
+	g_fat.root_dir_sector   = g_fat.fat_start_sector + (num_fats * fat_size);
 	g_fat.first_data_sector = g_fat.root_dir_sector + root_dir_sectors;
 
-	// No necesitamos distinguir estrictamente FAT12/16 aqu
-	g_fat.fat_type = 16; // solo un marcador simblico
+	// El tipo lo decide el nmero de clsteres, no la etiqueta
+	g_fat.cluster_count =
+	(total_sectors - (g_fat.first_data_sector - volume)) / sectors_per_cluster;
+
+	if (g_fat.cluster_count < 4085)       g_fat.fat_type = 12;
+	else if (g_fat.cluster_count < 65525) g_fat.fat_type = 16;
+	else                                  g_fat.fat_type = 32;
+
+	g_fat.root_cluster  = 0;
+	g_fat.free_clusters = 0xFFFFFFFFUL;
+
+	if (g_fat.fat_type == 32) {
+		uint16_t fsinfo = FAT_U16(&sector_buffer[48]);
+
+		g_fat.root_cluster    = FAT_U32(&sector_buffer[44]);
+		g_fat.root_dir_sector = g_fat.first_data_sector +
+		(g_fat.root_cluster - 2) * sectors_per_cluster;
+
+		// FSInfo: clsteres libres, si la firma es buena (solo informativo)
+		if (fsinfo && fsinfo != 0xFFFF &&
+		    FAT_ReadSector(volume + fsinfo) == SD_OK &&
+		    FAT_U32(&sector_buffer[0])   == 0x41615252UL &&
+		    FAT_U32(&sector_buffer[484]) == 0x61417272UL)
+			g_fat.free_clusters = FAT_U32(&sector_buffer[488]);
+	}
 
 	return 0;
 }
 
+// -----------------------------------------------------------------------------
+// Cadenas de clsteres
+// -----------------------------------------------------------------------------
+
+// Clster de datos vlido? (ni libre, ni fin de cadena, ni malo)
+static uint8_t FAT_IsCluster(uint32_t cluster)
+{
+	return cluster >= 2 && cluster < g_fat.cluster_count + 2;
+}
+
+static uint32_t FAT_ClusterLBA(uint32_t cluster)
+{
+	return g_fat.first_data_sector + (cluster - 2) * g_fat.sectors_per_cluster;
+}
+
+// Deja en el buffer el sector de la FAT con el byte 'offset' (si no est
+// ya, segn *loaded) y devuelve en *i su posicin
+static uint8_t FAT_LoadFat(uint32_t offset, uint32_t *loaded, uint16_t *i)
+{
+	uint32_t sector = g_fat.fat_start_sector + offset / g_fat.bytes_per_sector;
+
+	if (sector != *loaded) {
+		if (FAT_ReadSector(sector) != SD_OK) {
+			*loaded = 0xFFFFFFFFUL;
+			return 1;
+		}
+		*loaded = sector;
+	}
+	*i = offset % g_fat.bytes_per_sector;
+	return 0;
+}
+
+// Siguiente clster de la cadena; 0 si hay error de lectura. *loaded es
+// el sector de la FAT que hay en el buffer (0xFFFFFFFF = ninguno).
+static uint32_t FAT_NextCluster(uint32_t cluster, uint32_t *loaded)
+{
+	uint16_t i;
+
+	if (g_fat.fat_type == 12) {
+		// 12 bits: la entrada puede quedar partida entre dos sectores
+		uint32_t offset = cluster + cluster / 2;
+		if (FAT_LoadFat(offset, loaded, &i)) return 0;
+		uint16_t v = sector_buffer[i];
+		if (FAT_LoadFat(offset + 1, loaded, &i)) return 0;
+		v |= (uint16_t)sector_buffer[i] << 8;
+		return (cluster & 1) ? (v >> 4) : (v & 0x0FFF);
+	}
+
+	if (g_fat.fat_type == 16) {
+		if (FAT_LoadFat(cluster * 2, loaded, &i)) return 0;
+		return FAT_U16(&sector_buffer[i]);
+	}
+
+	if (FAT_LoadFat(cluster * 4, loaded, &i)) return 0;
+	return FAT_U32(&sector_buffer[i]) & 0x0FFFFFFFUL;
+}
+
+// -----------------------------------------------------------------------------
+// Recorrido de los sectores del root
+// -----------------------------------------------------------------------------
+
+typedef struct {
+	uint32_t lba;         // sector actual
+	uint32_t cluster;     // FAT32: clster actual (0 = root fijo)
+	uint32_t left;        // sectores que quedan en el clster o en el root
+} FAT_DirPos;
+
+static void FAT_RootFirst(FAT_DirPos *d)
+{
+	d->lba = g_fat.root_dir_sector;
+
+	if (g_fat.fat_type == 32) {
+		d->cluster = g_fat.root_cluster;
+		d->left    = g_fat.sectors_per_cluster;
+	} else {
+		d->cluster = 0;
+		d->left = ((uint32_t)g_fat.root_entry_count * 32 + (g_fat.bytes_per_sector - 1)) /
+		g_fat.bytes_per_sector;
+	}
+}
+
+// Pasa al siguiente sector del root; 0 si se acab. Puede usar el buffer
+// de sector para leer la FAT.
+static uint8_t FAT_RootNext(FAT_DirPos *d)
+{
+	if (--d->left) {
+		d->lba++;
+		return 1;
+	}
+	if (!d->cluster) return 0;
+
+	uint32_t loaded = 0xFFFFFFFFUL;
+	d->cluster = FAT_NextCluster(d->cluster, &loaded);
+	if (!FAT_IsCluster(d->cluster)) return 0;
+
+	d->lba  = FAT_ClusterLBA(d->cluster);
+	d->left = g_fat.sectors_per_cluster;
+	return 1;
+}
+
 // -----------------------------------------------------------------------------
 // Utilidad: pasar "NAME.BMP" a nombre 8.3 de 11 bytes en maysculas
 // -----------------------------------------------------------------------------
@@ -83,19 +260,14 @@ uint8_t FAT_Open(FAT_File *file, const char *name_8_3)
 	char target[11];
 	FAT_MakeName83(name_8_3, target);
 
-	uint32_t sector = g_fat.root_dir_sector;
 	uint16_t entries_per_sector = g_fat.bytes_per_sector / 32;
 
-	// Sectores que ocupa el root dir
-	uint32_t root_dir_sectors =
-	((uint32_t)g_fat.root_entry_count * 32 + (g_fat.bytes_per_sector - 1)) /
-	g_fat.bytes_per_sector;
-
-	uint32_t last_sector = sector + root_dir_sectors;
+	FAT_DirPos d;
+	FAT_RootFirst(&d);
 
-	for (; sector < last_sector; sector++) {
+	do {
 
-		if (FAT_ReadSector(sector) != SD_OK) return 1;
+		if (FAT_ReadSector(d.lba) != SD_OK) return 1;
 
 		for (uint16_t i = 0; i < entries_per_sector; i++) {
 			uint8_t *e = &sector_buffer[i * 32];
@@ -127,7 +299,7 @@ uint8_t FAT_Open(FAT_File *file, const char *name_8_3)
 				return 0;
 			}
 		}
-	}
+	} while (FAT_RootNext(&d));
 
 	return 1;
 }
@@ -183,7 +355,9 @@ int16_t FAT_Read(FAT_File *file, uint8_t *buffer, uint16_t len)
 		uint16_t can_copy = bytes_per_sector - byte_in_sector;
 		if (can_copy > remaining) can_copy = remaining;
 
+		PROF_ENTER(PROF_FAT_COPY);
 		memcpy(&buffer[copied], &sector_buffer[byte_in_sector], can_copy);
+		PROF_EXIT(PROF_FAT_COPY);
 
 		copied      += can_copy;
 		remaining   -= can_copy;
@@ -197,6 +371,67 @@ int16_t FAT_Read(FAT_File *file, uint8_t *buffer, uint16_t len)
 	return copied;
 }
 
+// -----------------------------------------------------------------------------
+// Acceso directo a sectores (para quien quiera saltarse FAT_Read)
+// -----------------------------------------------------------------------------
+uint32_t FAT_FileSector(const FAT_File *file, uint32_t offset)
+{
+	uint32_t sector_index = offset / g_fat.bytes_per_sector;
+
+	return g_fat.first_data_sector +
+	(file->first_cluster - 2) * g_fat.sectors_per_cluster + sector_index;
+}
+
+uint8_t *FAT_SectorBuffer(void)
+{
+	sector_lba = FAT_NO_SECTOR;
+	return sector_buffer;
+}
+
+const uint8_t *FAT_LoadSector(uint32_t lba)
+{
+	return (FAT_ReadSector(lba) == SD_OK) ? sector_buffer : 0;
+}
+
+uint8_t FAT_SectorLoaded(uint32_t lba)
+{
+	return lba == sector_lba;
+}
+
+// -----------------------------------------------------------------------------
+// Tramos contiguos de un archivo (cadena de clsteres)
+// -----------------------------------------------------------------------------
+uint8_t FAT_GetExtents(const FAT_File *file, FAT_Extent *ext, uint8_t max)
+{
+	uint32_t cluster_size = (uint32_t)g_fat.sectors_per_cluster * g_fat.bytes_per_sector;
+	uint32_t clusters     = (file->size_bytes + cluster_size - 1) / cluster_size;
+	uint32_t cluster      = file->first_cluster;
+	uint32_t loaded       = 0xFFFFFFFFUL;   // sector de la FAT en el buffer
+	uint8_t  n = 0;
+
+	if (clusters == 0) return 0;
+
+	while (1) {
+		if (!FAT_IsCluster(cluster)) return 0;   // cadena rota
+
+		uint32_t lba = FAT_ClusterLBA(cluster);
+
+		// Clster contiguo al anterior: alargar el tramo
+		if (n && ext[n - 1].lba + ext[n - 1].sectors == lba) {
+			ext[n - 1].sectors += g_fat.sectors_per_cluster;
+		} else {
+			if (n == max) return 0;
+			ext[n].lba = lba;
+			ext[n].sectors = g_fat.sectors_per_cluster;
+			n++;
+		}
+
+		if (--clusters == 0) return n;
+
+		cluster = FAT_NextCluster(cluster, &loaded);
+	}
+}
+
 // -----------------------------------------------------------------------------
 // Utilidades para listar BMPs en el root
 // -----------------------------------------------------------------------------
@@ -227,8 +462,9 @@ static void FAT_Name11ToString(const uint8_t *src11, char *dst13)
 	dst13[pos] = '\0';
 }
 
-// Tiene extensin .BMP/.bmp?
-static uint8_t FAT_HasBmpExt(const char *name)
+// Tiene alguna de las extensiones de 'exts' (3 letras cada una,
+// en maysculas)? La comparacin no distingue maysculas.
+static uint8_t FAT_HasExt(const char *name, const char *exts)
 {
 	const char *dot = NULL;
 	const char *p = name;
@@ -236,34 +472,37 @@ static uint8_t FAT_HasBmpExt(const char *name)
 		if (*p == '.') dot = p;
 		p++;
 	}
-	if (!dot) return 0;
+	if (!dot || p - dot != 4) return 0;
 
-	if ((dot[1] == 'B' || dot[1] == 'b') &&
-	(dot[2] == 'M' || dot[2] == 'm') &&
-	(dot[3] == 'P' || dot[3] == 'p') &&
-	(dot[4] == '\0'))
-	{
-		return 1;
+	for (; exts[0]; exts += 3) {
+		uint8_t k;
+		for (k = 0; k < 3; k++) {
+			char c = dot[1 + k];
+			if (c >= 'a' && c <= 'z') c -= 32;
+			if (c != exts[k]) break;
+		}
+		if (k == 3) return 1;
 	}
 	return 0;
 }
 
 // Devuelve hasta max_files nombres BMP encontrados en el root
 uint8_t FAT_ListBMP(char names[][13], uint8_t max_files)
+{
+	return FAT_ListFiles(names, max_files, "BMP");
+}
+
+uint8_t FAT_ListFiles(char names[][13], uint8_t max_files, const char *exts)
 {
 	uint8_t  count = 0;
-	uint32_t sector = g_fat.root_dir_sector;
 	uint16_t entries_per_sector = g_fat.bytes_per_sector / 32;
 
-	uint32_t root_dir_sectors =
-	((uint32_t)g_fat.root_entry_count * 32 + (g_fat.bytes_per_sector - 1)) /
-	g_fat.bytes_per_sector;
-
-	uint32_t last_sector = sector + root_dir_sectors;
+	FAT_DirPos d;
+	FAT_RootFirst(&d);
 
-	for (; sector < last_sector; sector++) {
+	do {
 
-		if (FAT_ReadSector(sector) != SD_OK)
+		if (FAT_ReadSector(d.lba) != SD_OK)
 		return count;
 
 		for (uint16_t i = 0; i < entries_per_sector; i++) {
@@ -279,7 +518,7 @@ uint8_t FAT_ListBMP(char names[][13], uint8_t max_files)
 
 			char tmp[13];
 			FAT_Name11ToString(e, tmp);
-			if (!FAT_HasBmpExt(tmp)) continue;
+			if (!FAT_HasExt(tmp, exts)) continue;
 
 			if (count < max_files) {
 				uint8_t j = 0;
@@ -293,7 +532,7 @@ uint8_t FAT_ListBMP(char names[][13], uint8_t max_files)
 				return count;
 			}
 		}
-	}
+	} while (FAT_RootNext(&d));
 
 	return count;
 }
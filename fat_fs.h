@@ -7,12 +7,16 @@
 
 typedef struct {
 	uint32_t first_data_sector;
-	uint32_t root_dir_sector;
+	uint32_t root_dir_sector;     // FAT32: primer sector del root
 	uint16_t bytes_per_sector;
 	uint8_t  sectors_per_cluster;
 	uint32_t fat_start_sector;
-	uint32_t root_entry_count;
-	uint8_t  fat_type; // 16 o 32
+	uint32_t root_entry_count;    // FAT32: 0 (el root es una cadena)
+	uint8_t  fat_type; // 12, 16 o 32
+	uint32_t volume_start;        // sector del boot (0 sin MBR)
+	uint32_t cluster_count;
+	uint32_t root_cluster;        // solo FAT32
+	uint32_t free_clusters;       // FSInfo; 0xFFFFFFFF = desconocido
 } FAT_Info;
 
 typedef struct {
@@ -21,10 +25,44 @@ typedef struct {
 	uint32_t current_pos;
 } FAT_File;
 
+// Tramo de sectores consecutivos de un archivo
+typedef struct {
+	uint32_t lba;
+	uint32_t sectors;
+} FAT_Extent;
+
 extern FAT_Info g_fat;
 
+// Monta el primer volumen FAT12/16/32: el sector 0 puede ser su boot
+// ("superfloppy") o un MBR con la particin en la tabla.
 uint8_t FAT_Init(void);
 uint8_t FAT_Open(FAT_File *file, const char *name_8_3); // nombre 8.3 en maysculas
 int16_t FAT_Read(FAT_File *file, uint8_t *buffer, uint16_t len);
 
+// Sector fsico (LBA) que contiene el byte 'offset' del archivo.
+// Misma suposicin que FAT_Read: clsteres contiguos.
+uint32_t FAT_FileSector(const FAT_File *file, uint32_t offset);
+
+// Sigue la cadena de clsteres en la FAT y la resume en tramos
+// contiguos, en orden de archivo. Devuelve el nmero de tramos, o 0 si
+// la cadena est rota o no cabe en 'max'. Usa el buffer de sector.
+uint8_t FAT_GetExtents(const FAT_File *file, FAT_Extent *ext, uint8_t max);
+
+// Nombres "NAME.EXT" del root cuya extensin est en 'exts' (extensiones
+// de 3 letras seguidas, p.ej. "BMPANI"), en orden de directorio.
+uint8_t FAT_ListFiles(char names[][13], uint8_t max_files, const char *exts);
+
+// Buffer de sector interno (512 bytes). Se puede usar como memoria
+// de trabajo mientras no haya lecturas FAT en curso; FAT_Read y
+// FAT_Open lo sobrescriben. Pedirlo olvida qu sector tena.
+uint8_t *FAT_SectorBuffer(void);
+
+// Sector 'lba' en el buffer de sector, leyndolo solo si no es el que
+// ya hay (lo ltimo ledo por fat_fs.c o por aqu). NULL si falla la
+// lectura. Los datos valen hasta el siguiente FAT_SectorBuffer().
+const uint8_t *FAT_LoadSector(uint32_t lba);
+
+// Est ya el sector 'lba' en el buffer?
+uint8_t FAT_SectorLoaded(uint32_t lba);
+
 #endif /* FAT_FS_H_ */
@@ -0,0 +1,15 @@
+// font5x7.h
+#ifndef FONT5X7_H_
+#define FONT5X7_H_
+
+#include <stdint.h>
+#include <avr/pgmspace.h>
+
+#define FONT_WIDTH   5
+#define FONT_HEIGHT  7
+#define FONT_FIRST   0x20
+#define FONT_COUNT   95    // 0x20..0x7E
+
+extern const uint8_t font5x7[FONT_COUNT * FONT_WIDTH] PROGMEM;
+
+#endif /* FONT5X7_H_ */
@@ -0,0 +1,878 @@
+// fractal.c - Render de Mandelbrot / Julia en punto fijo
+//
+// Vistas con pan y zoom: el ncleo de iteracin (fractal_kernel.c) se
+// elige por nivel de zoom, el ms estrecho que siga siendo exacto.
+// host/fracref.c repite la rejilla, los ncleos y las paletas para
+// comparar con el simulador: un cambio aqu tiene que ir tambin all.
+
+#include "fractal.h"
+#include "fractal_kernel.h"
+#include "tft_st7735.h"
+#include "frame_cache.h"
+#include "fat_fs.h"
+#include "sd_spi.h"
+#include "prof.h"
+#include "scratch.h"
+#include <string.h>
+
+/* ==========================================================
+   COLORACIN MANDELBROT (paleta que ya tenas)
+   ========================================================== */
+
+static uint16_t color_from_iter_mandel(uint8_t iter, uint8_t max_iter)
+{
+    if (iter >= max_iter) {
+        // Interior del conjunto: negro para mximo contraste
+        return 0x0000;
+    }
+
+    // Normalizar iter a 0..255
+    uint16_t t0 = (uint16_t)iter * 255 / max_iter;  // 0..255
+    // Hacemos que el color "cicle" 3 veces a lo largo de las iteraciones
+    uint8_t t = (uint8_t)((t0 * 3) & 0xFF);         // 0..255, con 3 bandas
+
+    uint8_t r, g, b;
+
+    if (t < 85) {
+        // Azul (0,0,128) -> Cian (0,255,255)
+        r = 0;
+        g = (uint8_t)(3 * t);                      // ~0..255
+        b = 128 + (uint8_t)(t * 127 / 85);         // 128..255
+    }
+    else if (t < 170) {
+        uint8_t tt = t - 85;
+        // Cian (0,255,255) -> Amarillo (255,255,0)
+        r = (uint8_t)(3 * tt);                     // 0..255
+        g = 255;
+        b = (uint8_t)(255 - 3 * tt);               // 255..0
+    }
+    else {
+        uint8_t tt = t - 170;
+        // Amarillo (255,255,0) -> Blanco (255,255,255)
+        r = 255;
+        g = 255;
+        b = (uint8_t)(tt * 3);                     // 0..255
+    }
+
+    // Convertir a RGB565
+    uint16_t color =
+        ((r & 0xF8) << 8) |
+        ((g & 0xFC) << 3) |
+        ((b & 0xF8) >> 3);
+
+    return color;
+}
+
+/* ==========================================================
+   COLORACIN JULIA (paleta clsica distinta)
+   ========================================================== */
+
+static uint16_t color_from_iter_julia(uint8_t iter, uint8_t max_iter)
+{
+    if (iter >= max_iter)
+        return 0x0000; // interior negro
+
+    // Normalizar 0..255
+    uint16_t t = (uint16_t)iter * 255 / max_iter;
+
+    uint8_t r, g, b;
+
+    if (t < 32) {
+        // Negro -> violeta oscuro
+        r = 20;
+        g = 0;
+        b = (uint8_t)(t * 8);              // 0..255
+    }
+    else if (t < 64) {
+        // Violeta -> prpura brillante
+        uint8_t k = t - 32;
+        r = (uint8_t)(40 + k * 3);         // ~40..136
+        g = 0;
+        b = 255;
+    }
+    else if (t < 128) {
+        // Prpura -> rojo
+        uint8_t k = t - 64;
+        r = (uint8_t)(k * 4);              // 0..255
+        g = 0;
+        b = (uint8_t)(255 - k * 4);        // 255..0
+    }
+    else if (t < 192) {
+        // Rojo -> naranja -> amarillo
+        uint8_t k = t - 128;
+        r = 255;
+        g = (uint8_t)(k * 3);              // 0..192
+        b = 0;
+    }
+    else {
+        // Amarillo -> blanco
+        uint8_t k = t - 192;
+        r = 255;
+        g = 255;
+        b = (uint8_t)(k * 4);              // 0..255 (se satura a 255)
+        if (b > 255) b = 255;
+    }
+
+    // Pasar a RGB565
+    uint16_t color =
+        ((r & 0xF8) << 8) |
+        ((g & 0xFC) << 3) |
+        ((b & 0xF8) >> 3);
+
+    return color;
+}
+
+/* ==========================================================
+   PUNTO FIJO Q5.11
+   ========================================================== */
+
+#define Q      11
+#define Q_ONE  (1 << Q)
+
+// Solo para las vistas iniciales; el clculo est en fractal_kernel.c
+typedef int16_t q5_11_t;
+
+/* ==========================================================
+   PARMETROS DE FRACTAL: MANDELBROT Y JULIA
+   ========================================================== */
+
+typedef struct {
+    q5_11_t center_re;
+    q5_11_t center_im;
+    q5_11_t scale;
+    uint8_t max_iter;
+} FractalParams;
+
+// Mandelbrot: centrado en el cuerpo principal
+static const FractalParams FRACTAL_MANDEL_PARAMS = {
+    .center_re = (q5_11_t)(-1536),  // -0.75 * 2048
+    .center_im = (q5_11_t)(0),      // 0.0
+    .scale     = (q5_11_t)(3072),   // 1.5 * 2048
+    .max_iter  = 120
+};
+
+// Julia con C = -0.8 + 0.156i
+#define JULIA_C_RE  ((q5_11_t)-1638) // -0.8  * 2048
+#define JULIA_C_IM  ((q5_11_t)  319) //  0.156* 2048
+
+static const FractalParams FRACTAL_JULIA_PARAMS = {
+    .center_re = (q5_11_t)(0),      // centro 0+0i
+    .center_im = (q5_11_t)(0),
+    .scale     = (q5_11_t)(3072),   // +/-1.5
+    .max_iter  = 120
+};
+
+/* ==========================================================
+   REJILLA DE PXELES DE UNA VISTA
+   ========================================================== */
+
+// Lmite del centro de la vista: mantiene |c| y |z0| por debajo de 4
+#define FX_CENTER_LIMIT  ((fx_t)2 << FX_FRAC)
+
+// Q5.11 -> Q8.56
+#define FX_FROM_Q11(v)   ((fx_t)(v) * ((fx_t)1 << (FX_FRAC - Q)))
+
+// Subir cuando cambie el clculo o la coloracin: invalida la cach en SD
+#define FRACTAL_KERNEL_VERSION  2
+
+// Esquina superior izquierda y paso por pxel, en unidades del ncleo
+typedef struct {
+    int64_t re_min;
+    int64_t im_min;
+    int64_t re_step;
+    int64_t im_step;
+    uint8_t kernel;
+} FractalGrid;
+
+static const FractalParams *FRACTAL_Home(uint8_t type)
+{
+    return (type == FRACTAL_JULIA) ? &FRACTAL_JULIA_PARAMS : &FRACTAL_MANDEL_PARAMS;
+}
+
+static fx_t FRACTAL_Scale(uint8_t type, uint8_t zoom)
+{
+    return FX_FROM_Q11(FRACTAL_Home(type)->scale) >> zoom;
+}
+
+// Ncleo para un nivel de zoom: decide el paso vertical, el ms fino
+static uint8_t FRACTAL_KernelFor(uint8_t type, uint8_t zoom)
+{
+    return FK_Select((2 * FRACTAL_Scale(type, zoom)) / (TFT_HEIGHT - 1));
+}
+
+static void FRACTAL_Grid(const FractalView *v, FractalGrid *g)
+{
+    uint8_t k = FRACTAL_KernelFor(v->type, v->zoom);
+
+    // El centro y la escala se pasan primero al formato del ncleo, as
+    // en Q5.11 la vista inicial sale con los mismos pasos que siempre.
+    int64_t scale = FK_FromView(k, FRACTAL_Scale(v->type, v->zoom));
+    int64_t c_re  = FK_FromView(k, v->center_re);
+    int64_t c_im  = FK_FromView(k, v->center_im);
+
+    g->kernel  = k;
+    g->re_min  = c_re - scale;
+    g->im_min  = c_im - scale;
+    g->re_step = (2 * scale) / (TFT_WIDTH  - 1);
+    g->im_step = (2 * scale) / (TFT_HEIGHT - 1);
+}
+
+/* ==========================================================
+   RENDER DE FILAS (CON SCROLL VERTICAL)
+   ========================================================== */
+
+// Constante c de un pxel (Mandelbrot: el punto; Julia: fija)
+static void FRACTAL_PixelC(const FractalView *v, uint8_t kernel,
+                           int64_t px, int64_t py, int64_t *cx, int64_t *cy)
+{
+    if (v->type == FRACTAL_MANDEL) {
+        *cx = px;
+        *cy = py;
+    } else {
+        *cx = FK_FromView(kernel, FX_FROM_Q11(JULIA_C_RE));
+        *cy = FK_FromView(kernel, FX_FROM_Q11(JULIA_C_IM));
+    }
+}
+
+// Iteraciones calculadas desde el arranque (para diagnstico)
+static uint32_t frac_iters;
+
+// Filas de arriba de la pantalla tapadas por otra cosa (FRACTAL_SetOverlay)
+static uint8_t frac_overlay;
+
+// rbita de un pxel desde z0 hasta 'cap'; deja el ltimo z en *zx, *zy
+static uint8_t FRACTAL_Orbit(const FractalView *v, uint8_t kernel,
+                             int64_t px, int64_t py,
+                             int64_t *zx, int64_t *zy, uint8_t cap)
+{
+    int64_t cx, cy;
+    FRACTAL_PixelC(v, kernel, px, py, &cx, &cy);
+
+    // Mandelbrot: z0 = 0; Julia: z0 = el punto
+    *zx = (v->type == FRACTAL_MANDEL) ? 0 : px;
+    *zy = (v->type == FRACTAL_MANDEL) ? 0 : py;
+
+    uint8_t iter = FK_Resume(kernel, zx, zy, cx, cy, 0, cap);
+    frac_iters += iter;
+    return iter;
+}
+
+static uint16_t FRACTAL_PaletteColor(uint8_t palette, uint8_t iter, uint8_t max_iter)
+{
+    if (palette == FRACTAL_MANDEL)
+        return color_from_iter_mandel(iter, max_iter);
+    return color_from_iter_julia(iter, max_iter);
+}
+
+static uint16_t FRACTAL_Color(const FractalView *v, uint8_t iter)
+{
+    return FRACTAL_PaletteColor(v->type, iter, v->max_iter);
+}
+
+/* ==========================================================
+   PLANO DE ITERACIONES (FRACTAL_ITER_FILE)
+   ========================================================== */
+
+// Un byte por pxel, en orden de pantalla (fila 0 = arriba de la vista),
+// con el iter de la ltima vista calculada. Permite recolorear sin
+// recalcular ninguna rbita.
+
+#define FRACTAL_PIXELS      ((uint16_t)TFT_WIDTH * TFT_HEIGHT)
+#define IT_SECTORS          ((FRACTAL_PIXELS + 511) / 512)
+#define FRAME_SECTORS       (((uint32_t)FRACTAL_PIXELS * 2 + 511) / 512)
+
+static uint32_t it_base_lba;
+static uint8_t  it_ready;        // el archivo existe, es contiguo y tiene tamao suficiente
+static uint8_t  it_valid;        // el plano corresponde a it_view
+static FractalView it_view;
+
+// Escritura secuencial mientras se dibuja
+static uint16_t it_pos;
+static uint8_t  it_sector;
+static uint8_t  it_err;
+
+static uint8_t FRACTAL_SameView(const FractalView *a, const FractalView *b)
+{
+    return a->type == b->type && a->zoom == b->zoom &&
+           a->max_iter == b->max_iter &&
+           a->center_re == b->center_re && a->center_im == b->center_im;
+}
+
+// Igual que FCACHE_PutPixel: dentro de una rfaga TFT, en orden de envo
+static void FRACTAL_PlanePut(uint8_t iter)
+{
+    uint8_t *buf = FAT_SectorBuffer();
+
+    buf[it_pos++] = iter;
+    if (it_pos == 512) {
+        TFT_EndWrite();
+        if (SD_WriteBlock(it_base_lba + it_sector, buf) != SD_OK) it_err = 1;
+        TFT_StartWrite();
+        it_sector++;
+        it_pos = 0;
+    }
+}
+
+static uint8_t FRACTAL_PlaneEnd(void)
+{
+    if (it_pos > 0 &&
+        SD_WriteBlock(it_base_lba + it_sector, FAT_SectorBuffer()) != SD_OK)
+        it_err = 1;
+    return it_err;
+}
+
+// Llena la ranura de cach (ya buscada con FCACHE_Lookup) desde el plano.
+// Cada sector del fotograma son 256 pxeles: se leen sus 256 iter en la
+// mitad alta del buffer y se expanden hacia delante a 512 bytes RGB565.
+static void FRACTAL_CacheFromPlane(const FractalView *v)
+{
+    uint8_t *buf = FAT_SectorBuffer();
+
+    if (!FCACHE_Ready() || FCACHE_BeginWrite() != FCACHE_OK) return;
+
+    for (uint8_t s = 0; s < FRAME_SECTORS; s++) {
+        if (SD_ReadPartial(it_base_lba + s / 2, buf + 256, (s & 1) * 256, 256) != SD_OK)
+            return;   // la ranura queda invlida
+
+        for (uint16_t j = 0; j < 256; j++) {
+            uint16_t color = FRACTAL_Color(v, buf[256 + j]);
+            buf[2 * j]     = color >> 8;
+            buf[2 * j + 1] = color & 0xFF;
+        }
+
+        if (FCACHE_PutSector(buf) != FCACHE_OK) return;
+    }
+
+    FCACHE_EndWrite();
+}
+
+// Filas de pantalla [y0, y1). Cada fila va a la lnea de GRAM que el
+// scroll vertical muestra en esa posicin.
+// Qu se guarda adems de enviar cada pxel al TFT
+#define SINK_NONE   0
+#define SINK_CACHE  1   // color -> cach de fotogramas
+#define SINK_PLANE  2   // iter  -> plano de iteraciones
+
+static void FRACTAL_DrawRows(const FractalView *v, const FractalGrid *g,
+                             uint8_t y0, uint8_t y1, uint8_t sink)
+{
+    uint8_t scroll = TFT_GetScroll();
+
+    for (uint8_t py = y0; py < y1; py++)
+    {
+        uint8_t mem_row = (uint8_t)((scroll + py) % TFT_HEIGHT);
+        int64_t cy_pixel = g->im_min + g->im_step * py;
+        int64_t cx_pixel = g->re_min;
+
+        TFT_SetAddrWindow(0, mem_row, TFT_WIDTH - 1, mem_row);
+        TFT_StartWrite();
+
+        for (uint8_t px = 0; px < TFT_WIDTH; px++)
+        {
+            int64_t zx, zy;
+            PROF_ENTER(PROF_FRACTAL_ITER);
+            uint8_t iter = FRACTAL_Orbit(v, g->kernel, cx_pixel, cy_pixel,
+                                         &zx, &zy, v->max_iter);
+            PROF_EXIT(PROF_FRACTAL_ITER);
+            uint16_t color = FRACTAL_Color(v, iter);
+
+            TFT_WriteColor(color);
+            if (sink == SINK_CACHE)
+                FCACHE_PutPixel(color);
+            else if (sink == SINK_PLANE)
+                FRACTAL_PlanePut(iter);
+
+            cx_pixel += g->re_step;
+        }
+
+        TFT_EndWrite();
+    }
+}
+
+/* ==========================================================
+   PROFUNDIZACIN PROGRESIVA DE max_iter
+   ========================================================== */
+
+// Primera pasada con un tope bajo para ver la imagen enseguida; luego el
+// tope se duplica y solo se reanudan los pxeles que no escaparon, desde
+// el (zx, zy, iter) guardado. Solo se repintan los que escapan ahora: los
+// colores se calculan siempre contra el max_iter final, as un pxel ya
+// escapado no cambia de color y uno sin escapar sigue siendo "interior".
+//
+// El estado no cabe en SRAM (21384 pxeles): va a FRACTAL_STATE_FILE por
+// sectores. Cada sector guarda 'per' pxeles seguidos como
+//   [iter x per][zx x per][zy x per]
+// (zx, zy del ancho del ncleo activo). Los iter van juntos al principio
+// para poder armar el plano de iteraciones con lecturas parciales.
+
+static uint32_t st_base_lba;
+static uint32_t st_sectors;     // tamao del archivo de estado en sectores
+
+static void FRACTAL_PutInt(uint8_t *p, int64_t v, uint8_t n)
+{
+    for (uint8_t i = 0; i < n; i++) {
+        p[i] = (uint8_t)v;
+        v >>= 8;
+    }
+}
+
+static int64_t FRACTAL_GetInt(const uint8_t *p, uint8_t n)
+{
+    int64_t v = (p[n - 1] & 0x80) ? -1 : 0;   // extensin de signo
+    for (uint8_t i = n; i > 0; i--)
+        v = (v << 8) | p[i - 1];
+    return v;
+}
+
+static uint8_t FRACTAL_DeepenFirst(const FractalView *v, const FractalGrid *g,
+                                   uint8_t cap)
+{
+    uint8_t *buf    = FAT_SectorBuffer();
+    uint8_t  w      = FK_Bytes(g->kernel);
+    uint8_t  rec    = 2 * w + 1;
+    uint8_t  per    = 512 / rec;
+    uint8_t  n      = 0;
+    uint8_t  err    = 0;
+    uint32_t lba    = st_base_lba;
+    uint8_t  scroll = TFT_GetScroll();
+
+    for (uint8_t py = 0; py < TFT_HEIGHT; py++)
+    {
+        uint8_t mem_row = (uint8_t)((scroll + py) % TFT_HEIGHT);
+        int64_t cy_pixel = g->im_min + g->im_step * py;
+        int64_t cx_pixel = g->re_min;
+
+        TFT_SetAddrWindow(0, mem_row, TFT_WIDTH - 1, mem_row);
+        TFT_StartWrite();
+
+        for (uint8_t px = 0; px < TFT_WIDTH; px++)
+        {
+            int64_t zx, zy;
+            uint8_t iter = FRACTAL_Orbit(v, g->kernel, cx_pixel, cy_pixel,
+                                         &zx, &zy, cap);
+
+            // Sin escapar todava: color de interior hasta la prxima pasada
+            TFT_WriteColor(FRACTAL_Color(v, (iter < cap) ? iter : v->max_iter));
+
+            buf[n] = iter;
+            FRACTAL_PutInt(&buf[per + n * w], zx, w);
+            FRACTAL_PutInt(&buf[per + (per + n) * w], zy, w);
+
+            if (++n == per) {
+                // Misma pausa de rfaga que la cach: RAMWR sigue despus
+                TFT_EndWrite();
+                if (SD_WriteBlock(lba++, buf) != SD_OK) err = 1;
+                TFT_StartWrite();
+                n = 0;
+            }
+
+            cx_pixel += g->re_step;
+        }
+
+        TFT_EndWrite();
+    }
+
+    if (n > 0 && SD_WriteBlock(lba, buf) != SD_OK) err = 1;
+
+    return err;
+}
+
+static uint8_t FRACTAL_DeepenPass(const FractalView *v, const FractalGrid *g,
+                                  uint8_t prev_cap, uint8_t cap)
+{
+    uint8_t *buf    = FAT_SectorBuffer();
+    uint8_t  w      = FK_Bytes(g->kernel);
+    uint8_t  rec    = 2 * w + 1;
+    uint8_t  per    = 512 / rec;
+    uint16_t nsec   = (FRACTAL_PIXELS + per - 1) / per;
+    uint8_t  scroll = TFT_GetScroll();
+    uint8_t  last   = (cap >= v->max_iter);
+
+    for (uint16_t s = 0; s < nsec; s++)
+    {
+        if (SD_ReadBlock(st_base_lba + s, buf) != SD_OK) return 1;
+
+        uint8_t  dirty   = 0;
+        uint8_t  run     = 0;     // ventana de repintado abierta
+        uint16_t run_end = 0;     // ndice del siguiente pxel de la racha
+
+        for (uint8_t j = 0; j < per; j++)
+        {
+            uint16_t i = s * per + j;
+            if (i >= FRACTAL_PIXELS) break;
+
+            uint8_t *rx = &buf[per + j * w];
+            uint8_t *ry = &buf[per + (per + j) * w];
+            if (buf[j] != prev_cap) {
+                // Ya escap en una pasada anterior: nada que hacer
+                if (run) { TFT_EndWrite(); run = 0; }
+                continue;
+            }
+
+            uint8_t px = (uint8_t)(i % TFT_WIDTH);
+            uint8_t py = (uint8_t)(i / TFT_WIDTH);
+            int64_t zx = FRACTAL_GetInt(rx, w);
+            int64_t zy = FRACTAL_GetInt(ry, w);
+            int64_t cx, cy;
+
+            FRACTAL_PixelC(v, g->kernel, g->re_min + g->re_step * px,
+                           g->im_min + g->im_step * py, &cx, &cy);
+
+            uint8_t iter = FK_Resume(g->kernel, &zx, &zy, cx, cy, prev_cap, cap);
+            frac_iters += iter - prev_cap;
+
+            FRACTAL_PutInt(rx, zx, w);
+            FRACTAL_PutInt(ry, zy, w);
+            buf[j] = iter;
+            dirty = 1;
+
+            if (iter >= cap) {
+                // Sigue sin escapar: su color de interior no cambia
+                if (run) { TFT_EndWrite(); run = 0; }
+                continue;
+            }
+
+            // Escap en esta pasada: repintar, agrupando pxeles seguidos
+            // de la misma fila en una sola ventana
+            if (!run || run_end != i || px == 0) {
+                if (run) TFT_EndWrite();
+                uint8_t mem_row = (uint8_t)((scroll + py) % TFT_HEIGHT);
+                TFT_SetAddrWindow(px, mem_row, TFT_WIDTH - 1, mem_row);
+                TFT_StartWrite();
+                run = 1;
+            }
+            TFT_WriteColor(FRACTAL_Color(v, iter));
+            run_end = i + 1;
+        }
+
+        if (run) TFT_EndWrite();
+
+        // Tras la ltima pasada solo hacen falta los iter, y solo para
+        // armar el plano de iteraciones
+        if (dirty && (!last || it_ready) &&
+            SD_WriteBlock(st_base_lba + s, buf) != SD_OK)
+            return 1;
+    }
+
+    return 0;
+}
+
+static uint8_t FRACTAL_DrawProgressive(const FractalView *v, const FractalGrid *g)
+{
+    uint8_t per  = 512 / (2 * FK_Bytes(g->kernel) + 1);
+    uint16_t nsec = (FRACTAL_PIXELS + per - 1) / per;
+
+    if (nsec > st_sectors || v->max_iter <= FRACTAL_DEEPEN_FIRST) return 1;
+
+    uint8_t cap = FRACTAL_DEEPEN_FIRST;
+    if (FRACTAL_DeepenFirst(v, g, cap) != 0) return 1;
+
+    while (cap < v->max_iter) {
+        uint8_t next = (cap > v->max_iter / 2) ? v->max_iter : (uint8_t)(cap * 2);
+        if (FRACTAL_DeepenPass(v, g, cap, next) != 0) return 1;
+        cap = next;
+    }
+
+    // El ltimo repintado puede acabar en un pxel suelto
+    TFT_FlushHalf();
+    return 0;
+}
+
+// Plano de iteraciones a partir del estado de la ltima pasada: cada
+// sector del plano se arma leyendo solo el bloque de iter de los sectores
+// de estado que cubren sus 512 pxeles.
+static uint8_t FRACTAL_PlaneFromState(const FractalGrid *g)
+{
+    uint8_t *buf = FAT_SectorBuffer();
+    uint8_t  per = 512 / (2 * FK_Bytes(g->kernel) + 1);
+
+    for (uint8_t p = 0; p < IT_SECTORS; p++) {
+        uint16_t first = (uint16_t)p * 512;
+        uint16_t end   = (FRACTAL_PIXELS - first > 512) ? first + 512 : FRACTAL_PIXELS;
+
+        for (uint16_t i = first; i < end; ) {
+            uint8_t  off = (uint8_t)(i % per);
+            uint16_t n   = per - off;
+            if (n > end - i) n = end - i;
+
+            if (SD_ReadPartial(st_base_lba + i / per, buf + (i - first), off, n) != SD_OK)
+                return 1;
+            i += n;
+        }
+
+        if (SD_WriteBlock(it_base_lba + p, buf) != SD_OK) return 1;
+    }
+
+    return 0;
+}
+
+/* ==========================================================
+   API
+   ========================================================== */
+
+// Clave de la cach de fotogramas: todo lo que determina la imagen
+typedef struct {
+    uint8_t  type;
+    uint8_t  palette;
+    uint8_t  kernel;
+    uint8_t  max_iter;
+    uint8_t  zoom;
+    fx_t     center_re;
+    fx_t     center_im;
+    q5_11_t  c_re;
+    q5_11_t  c_im;
+} FractalCacheKey;
+
+void FRACTAL_InitStorage(void)
+{
+    FAT_File   f;
+    FAT_Extent ext;
+
+    // Los dos archivos se escriben por LBA desde su primer sector: si no
+    // son un nico tramo se pisaran otros archivos, as que se ignoran
+    st_sectors = 0;
+    if (FAT_Open(&f, FRACTAL_STATE_FILE) == 0 &&
+        FAT_GetExtents(&f, &ext, 1) == 1 && ext.sectors >= f.size_bytes / 512) {
+        st_base_lba = ext.lba;
+        st_sectors  = f.size_bytes / 512;
+    }
+
+    it_ready = 0;
+    it_valid = 0;
+    if (FAT_Open(&f, FRACTAL_ITER_FILE) != 0 || f.size_bytes / 512 < IT_SECTORS ||
+        FAT_GetExtents(&f, &ext, 1) != 1 || ext.sectors < IT_SECTORS)
+        return;
+
+    it_base_lba = ext.lba;
+    it_ready    = 1;
+}
+
+uint32_t FRACTAL_IterCount(void)
+{
+    return frac_iters;
+}
+
+void FRACTAL_SetOverlay(uint8_t rows)
+{
+    frac_overlay = rows;
+}
+
+void FRACTAL_InitView(FractalView *v, uint8_t type)
+{
+    const FractalParams *p = FRACTAL_Home(type);
+
+    v->type      = type;
+    v->zoom      = 0;
+    v->max_iter  = p->max_iter;
+    v->center_re = FX_FROM_Q11(p->center_re);
+    v->center_im = FX_FROM_Q11(p->center_im);
+}
+
+// Dibuja la vista. Con need_plane no vale reproducir desde la cach:
+// hace falta calcular para dejar el plano de iteraciones.
+static void FRACTAL_Render(const FractalView *v, uint8_t need_plane)
+{
+    FractalGrid g;
+    FRACTAL_Grid(v, &g);
+
+    // Ya se calcul esta vista? Reproducirla desde la SD.
+    FractalCacheKey key;
+    memset(&key, 0, sizeof(key));
+    key.type      = v->type;
+    key.palette   = v->type;   // cada tipo usa su paleta
+    key.kernel    = FRACTAL_KERNEL_VERSION;
+    key.max_iter  = v->max_iter;
+    key.zoom      = v->zoom;
+    key.center_re = v->center_re;
+    key.center_im = v->center_im;
+    if (v->type == FRACTAL_JULIA) {
+        key.c_re = JULIA_C_RE;
+        key.c_im = JULIA_C_IM;
+    }
+
+    if (FCACHE_Lookup(&key, sizeof(key)) && !need_plane &&
+        FCACHE_Replay(TFT_GetScroll()) == FCACHE_OK)
+        return;
+
+    it_valid = 0;
+
+    // Fallo de cach: con archivo de estado, imagen rpida y luego ms
+    // detalle. El fotograma llega a la cach a travs del plano.
+    if (st_sectors && FRACTAL_DrawProgressive(v, &g) == 0) {
+        if (it_ready && FRACTAL_PlaneFromState(&g) == 0) {
+            it_view  = *v;
+            it_valid = 1;
+            FRACTAL_CacheFromPlane(v);
+        }
+        return;
+    }
+
+    // Si no, calcular de una pasada guardando el plano (y de ah la
+    // cach) o, sin plano, escribiendo el fotograma a la vez
+    if (it_ready) {
+        it_pos = 0;
+        it_sector = 0;
+        it_err = 0;
+
+        FRACTAL_DrawRows(v, &g, 0, TFT_HEIGHT, SINK_PLANE);
+
+        if (FRACTAL_PlaneEnd() == 0) {
+            it_view  = *v;
+            it_valid = 1;
+            FRACTAL_CacheFromPlane(v);
+        }
+        return;
+    }
+
+    uint8_t caching = (FCACHE_Ready() && FCACHE_BeginWrite() == FCACHE_OK);
+
+    FRACTAL_DrawRows(v, &g, 0, TFT_HEIGHT, caching ? SINK_CACHE : SINK_NONE);
+
+    if (caching)
+        FCACHE_EndWrite();
+}
+
+void FRACTAL_Draw(const FractalView *v)
+{
+    FRACTAL_Render(v, 0);
+}
+
+uint8_t FRACTAL_Recolor(const FractalView *v, uint8_t palette, uint8_t phase)
+{
+    if (!it_ready || v->max_iter > FRACTAL_RECOLOR_MAX_ITER) return 1;
+
+    // Tras un acierto de cach o un pan el plano es de otra vista:
+    // recalcularla una vez (esta vez s deja el plano)
+    if (!it_valid || !FRACTAL_SameView(v, &it_view)) {
+        FRACTAL_Render(v, 1);
+        if (!it_valid) return 1;
+    }
+
+    // Colores de la paleta girada 'phase' pasos; el interior no gira.
+    // En 12 bits la tabla se guarda ya en RGB444.
+    uint8_t  c12 = (TFT_GetColorMode() == TFT_COLOR_444);
+    uint16_t *lut = g_scratch.fractal.lut;
+    SCRATCH_Claim(SCRATCH_FRACTAL);
+    for (uint8_t i = 0; i < v->max_iter; i++)
+        lut[i] = FRACTAL_PaletteColor(palette, (uint8_t)((i + phase) % v->max_iter),
+                                      v->max_iter);
+    lut[v->max_iter] = FRACTAL_PaletteColor(palette, v->max_iter, v->max_iter);
+    if (c12)
+        for (uint8_t i = 0; i <= v->max_iter; i++) lut[i] = TFT_To444(lut[i]);
+
+    // Misma partida en dos ventanas que FCACHE_Replay cuando hay scroll
+    uint8_t  row0 = TFT_GetScroll();
+    uint16_t wrap = (uint16_t)(TFT_HEIGHT - row0) * TFT_WIDTH;
+    uint16_t i    = 0;
+    uint8_t *buf  = FAT_SectorBuffer();
+
+    TFT_SetAddrWindow(0, row0, TFT_WIDTH - 1, TFT_HEIGHT - 1);
+
+    for (uint8_t s = 0; s < IT_SECTORS; s++) {
+        if (SD_ReadBlock(it_base_lba + s, buf) != SD_OK) return 1;
+
+        uint16_t n = (FRACTAL_PIXELS - i > 512) ? 512 : FRACTAL_PIXELS - i;
+
+        TFT_StartWrite();
+        for (uint16_t j = 0; j < n; j++, i++) {
+            if (row0 && i == wrap) {
+                TFT_EndWrite();
+                TFT_SetAddrWindow(0, 0, TFT_WIDTH - 1, row0 - 1);
+                TFT_StartWrite();
+            }
+            if (c12) TFT_WriteColor444(lut[buf[j]]);
+            else     TFT_WriteColor(lut[buf[j]]);
+        }
+        TFT_EndWrite();
+    }
+
+    return 0;
+}
+
+void FRACTAL_DrawBand(const FractalView *v, uint8_t y0, uint8_t y1)
+{
+    FractalGrid g;
+    FRACTAL_Grid(v, &g);
+    FRACTAL_DrawRows(v, &g, y0, y1, SINK_NONE);
+}
+
+void FRACTAL_ReadPixels(const FractalView *v, uint8_t x, uint8_t y, uint8_t w,
+                        uint16_t *out)
+{
+    FractalGrid g;
+    FRACTAL_Grid(v, &g);
+
+    int64_t cy_pixel = g.im_min + g.im_step * y;
+    int64_t cx_pixel = g.re_min + g.re_step * x;
+
+    for (uint8_t i = 0; i < w; i++) {
+        int64_t zx, zy;
+        out[i] = FRACTAL_Color(v, FRACTAL_Orbit(v, g.kernel, cx_pixel, cy_pixel,
+                                                &zx, &zy, v->max_iter));
+        cx_pixel += g.re_step;
+    }
+}
+
+void FRACTAL_Pan(FractalView *v, int8_t dx, int8_t dy)
+{
+    FractalGrid g;
+    FRACTAL_Grid(v, &g);
+
+    // El centro se mueve un nmero exacto de pasos del ncleo activo,
+    // as las filas nuevas encajan con las que ya estn en pantalla.
+    fx_t unit = (fx_t)1 << (FX_FRAC - FK_FracBits(g.kernel));
+    fx_t re = v->center_re + g.re_step * dx * unit;
+    fx_t im = v->center_im + g.im_step * dy * unit;
+
+    if (re > FX_CENTER_LIMIT || re < -FX_CENTER_LIMIT ||
+        im > FX_CENTER_LIMIT || im < -FX_CENTER_LIMIT)
+        return;
+
+    v->center_re = re;
+    v->center_im = im;
+
+    // En horizontal el ST7735 no tiene scroll: vista completa
+    if (dx != 0 || dy == 0) {
+        FRACTAL_Draw(v);
+        return;
+    }
+
+    uint8_t n = (uint8_t)((dy > 0) ? dy : -dy);
+    if (n >= TFT_HEIGHT) {
+        FRACTAL_Draw(v);
+        return;
+    }
+
+    FRACTAL_Grid(v, &g);
+
+    uint8_t scroll = TFT_GetScroll();
+    if (dy > 0) {
+        // El contenido sube: las filas nuevas aparecen abajo
+        TFT_ScrollTo((uint8_t)((scroll + n) % TFT_HEIGHT));
+        FRACTAL_DrawRows(v, &g, TFT_HEIGHT - n, TFT_HEIGHT, SINK_NONE);
+    } else {
+        TFT_ScrollTo((uint8_t)((scroll + TFT_HEIGHT - n) % TFT_HEIGHT));
+        FRACTAL_DrawRows(v, &g, 0, n, SINK_NONE);
+
+        // La banda superpuesta de arriba baj con el contenido: esas
+        // filas tienen texto viejo, no fractal
+        if (frac_overlay) {
+            uint8_t end = n + frac_overlay;
+            FRACTAL_DrawRows(v, &g, n, (end > TFT_HEIGHT) ? TFT_HEIGHT : end, SINK_NONE);
+        }
+    }
+}
+
+uint8_t FRACTAL_Zoom(FractalView *v, int8_t dir)
+{
+    if (dir > 0 && v->zoom < FRACTAL_MAX_ZOOM &&
+        FRACTAL_KernelFor(v->type, v->zoom + 1) != FK_NONE) {
+        v->zoom++;
+        return 1;
+    }
+    if (dir < 0 && v->zoom > 0) {
+        v->zoom--;
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,81 @@
+// fractal.h - Mandelbrot / Julia en punto fijo con pan y zoom
+#ifndef FRACTAL_H_
+#define FRACTAL_H_
+
+#include <stdint.h>
+
+#define FRACTAL_MANDEL 0
+#define FRACTAL_JULIA  1
+
+// Paso de desplazamiento (pxeles) y lmite de zoom
+#define FRACTAL_PAN_STEP   16
+#define FRACTAL_MAX_ZOOM   46
+
+// Render progresivo: primera pasada con este tope de iteraciones; el
+// estado de cada pxel se guarda en este archivo (contiguo, preasignado,
+// ~365 KB para el ncleo de 64 bits; 107 KB bastan para Q5.11).
+#define FRACTAL_DEEPEN_FIRST  32
+#define FRACTAL_STATE_FILE    "FRACTAL.TMP"
+
+// Plano de iteraciones de la ltima vista (1 byte por pxel, 21384 bytes)
+// para recolorear sin recalcular. Opcional, contiguo y preasignado.
+#define FRACTAL_ITER_FILE     "FRACTAL.ITR"
+#define FRACTAL_RECOLOR_MAX_ITER  128   // tamao de la tabla de colores (scratch.h)
+
+// Coordenadas de la vista en Q8.56 (rango +/-128, resolucin 2^-56)
+typedef int64_t fx_t;
+#define FX_FRAC  56
+
+typedef struct {
+    uint8_t type;        // FRACTAL_MANDEL / FRACTAL_JULIA
+    uint8_t zoom;        // 0 = vista inicial, cada nivel divide la escala por 2
+    uint8_t max_iter;
+    fx_t    center_re;
+    fx_t    center_im;
+} FractalView;
+
+// Abre los archivos de estado y del plano de iteraciones (opcionales;
+// fragmentados no se usan). Requiere SD_Init() y FAT_Init() previos.
+void FRACTAL_InitStorage(void);
+
+// Vista inicial (FRACTAL_MANDEL_PARAMS / FRACTAL_JULIA_PARAMS)
+void FRACTAL_InitView(FractalView *v, uint8_t type);
+
+// Dibuja la vista completa (usa la cach de fotogramas si est disponible;
+// si no, y existe el archivo de estado, en pasadas de max_iter creciente)
+void FRACTAL_Draw(const FractalView *v);
+
+// Vuelve a pintar la vista con otra paleta (FRACTAL_MANDEL / FRACTAL_JULIA)
+// girada 'phase' pasos, a partir del plano de iteraciones: solo lectura
+// de la SD y escritura al TFT. Si el plano es de otra vista la calcula
+// una vez. Devuelve 0 si pudo, 1 si no hay plano disponible.
+uint8_t FRACTAL_Recolor(const FractalView *v, uint8_t palette, uint8_t phase);
+
+// Iteraciones de rbita calculadas desde el arranque
+uint32_t FRACTAL_IterCount(void);
+
+// Las 'rows' filas de arriba de la pantalla se dibujan encima del fractal
+// (p.ej. el HUD). Un pan vertical repinta las filas que esa banda tapaba
+// cuando bajan con el contenido. 0 = sin banda.
+void FRACTAL_SetOverlay(uint8_t rows);
+
+// Recalcula y dibuja las filas de pantalla [y0, y1) de la vista actual
+// (p.ej. para tapar lo que haya quedado encima)
+void FRACTAL_DrawBand(const FractalView *v, uint8_t y0, uint8_t y1);
+
+// Colores RGB565 de 'w' pxeles de la fila 'y' de pantalla desde 'x', sin
+// dibujarlos (el fondo de un sprite, sprite.h). Se calculan otra vez: la
+// paleta es la normal de la vista, sin la animacin de FRACTAL_Recolor.
+void FRACTAL_ReadPixels(const FractalView *v, uint8_t x, uint8_t y, uint8_t w,
+                        uint16_t *out);
+
+// Desplaza la vista dx/dy pxeles y redibuja.
+// Un desplazamiento solo vertical usa el scroll por hardware del ST7735
+// y calcula nicamente las filas que quedan al descubierto.
+void FRACTAL_Pan(FractalView *v, int8_t dx, int8_t dy);
+
+// dir > 0 acerca, dir < 0 aleja. Devuelve 1 si la vista cambi
+// (el llamador debe redibujar con FRACTAL_Draw).
+uint8_t FRACTAL_Zoom(FractalView *v, int8_t dir);
+
+#endif /* FRACTAL_H_ */
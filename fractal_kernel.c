@@ -0,0 +1,258 @@
+// fractal_kernel.c - Familia de ncleos de iteracin (16 / 32 / 64 bits)
+//
+// Los productos se escriben como multiplicaciones "ensanchantes"
+// (16x16->32, 32x32->64), que avr-gcc resuelve con __mulhisi3 /
+// __mulsidi3 en lugar de la multiplicacin genrica del tipo ancho.
+// El de 64 bits se arma con cuatro productos 32x32->64.
+//
+// Los tres ncleos comparten el mismo esquema:
+//  - los cuadrados de la vuelta anterior sirven para el test de escape
+//    y para el paso siguiente (2 cuadrados + 1 producto por vuelta),
+//  - la parte nueva de z se calcula en el tipo ancho y se corta si
+//    |Re| o |Im| llega a 4, antes de que el formato estrecho desborde.
+//
+// En AVR el de 16 bits va en ensamblador (fractal_kernel_avr.S), con el
+// mismo resultado bit a bit que el bucle en C; -DFK_PORTABLE usa el C
+// tambin all. El benchmark (-DBENCH_BUILD) pasa los dos por las mismas
+// vistas y compara resultados y ciclos (FK_IterateQ511C).
+//
+// host/fkcheck.c compara los tres con una rbita en coma flotante.
+
+#include "fractal_kernel.h"
+
+#if defined(__AVR__) && !defined(FK_PORTABLE)
+#define FK_ASM_Q5_11
+
+// Estado de fk_loop_q5_11; el orden de los campos lo usa el .S
+typedef struct {
+	int16_t zx, zy;
+	int16_t cx, cy;
+	uint8_t iter, max_iter;
+} FK_Q511State;
+
+uint8_t fk_loop_q5_11(FK_Q511State *s);
+#endif
+
+static const uint8_t fk_frac_bits[FK_COUNT] = { 11, 27, 56 };
+
+// -----------------------------------------------------------------------------
+// Productos
+// -----------------------------------------------------------------------------
+
+// Q5.11 x Q5.11 -> Q.11 en 32 bits
+static inline int32_t fk_mul16(int16_t a, int16_t b)
+{
+	return ((int32_t)a * b) >> 11;
+}
+
+// Q4.27 x Q4.27 -> Q.27 en 64 bits
+static inline int64_t fk_mul32(int32_t a, int32_t b)
+{
+	return ((int64_t)a * b) >> 27;
+}
+
+// Q8.56 x Q8.56 -> Q.56: producto de 128 bits desplazado 56 (suelo,
+// igual que el >> aritmtico de los otros dos ncleos).
+static int64_t fk_mul64(int64_t a, int64_t b)
+{
+	uint8_t  neg = 0;
+	uint64_t ua = (uint64_t)a;
+	uint64_t ub = (uint64_t)b;
+
+	if (a < 0) { ua = -ua; neg ^= 1; }
+	if (b < 0) { ub = -ub; neg ^= 1; }
+
+	uint32_t a0 = (uint32_t)ua, a1 = (uint32_t)(ua >> 32);
+	uint32_t b0 = (uint32_t)ub, b1 = (uint32_t)(ub >> 32);
+
+	uint64_t p00 = (uint64_t)a0 * b0;
+	uint64_t p01 = (uint64_t)a0 * b1;
+	uint64_t p10 = (uint64_t)a1 * b0;
+	uint64_t p11 = (uint64_t)a1 * b1;
+
+	uint64_t mid = (p00 >> 32) + (uint32_t)p01 + (uint32_t)p10;
+	uint64_t lo  = (mid << 32) | (uint32_t)p00;
+	uint64_t hi  = p11 + (p01 >> 32) + (p10 >> 32) + (mid >> 32);
+
+	if (neg) {
+		lo = ~lo + 1;
+		hi = ~hi + (lo == 0);
+	}
+
+	return (int64_t)((hi << 8) | (lo >> 56));
+}
+
+// -----------------------------------------------------------------------------
+// Ncleos
+// -----------------------------------------------------------------------------
+
+// El bucle en C (en AVR, el de referencia del .S)
+static uint8_t fk_loop_q5_11_c(int16_t *pzx, int16_t *pzy, int16_t cx, int16_t cy,
+uint8_t iter, uint8_t max_iter)
+{
+	const int32_t escape2 = 4L << 11;
+	const int32_t bound   = 4L << 11;
+	int16_t zx = *pzx;
+	int16_t zy = *pzy;
+	int32_t zx2 = fk_mul16(zx, zx);
+	int32_t zy2 = fk_mul16(zy, zy);
+
+	while (iter < max_iter) {
+		int32_t nx = zx2 - zy2 + cx;
+		int32_t ny = 2 * fk_mul16(zx, zy) + cy;
+
+		if (nx >= bound || nx <= -bound || ny >= bound || ny <= -bound) break;
+
+		zx = (int16_t)nx;
+		zy = (int16_t)ny;
+		zx2 = fk_mul16(zx, zx);
+		zy2 = fk_mul16(zy, zy);
+		if (zx2 + zy2 > escape2) break;
+
+		iter++;
+	}
+
+	*pzx = zx;
+	*pzy = zy;
+	return iter;
+}
+
+static uint8_t fk_iterate_q5_11(int16_t *pzx, int16_t *pzy, int16_t cx, int16_t cy,
+uint8_t iter, uint8_t max_iter)
+{
+#ifdef FK_ASM_Q5_11
+	const int16_t bound = 4 << 11;
+
+	// El .S guarda los cuadrados en 16 bits: vale si z empieza dentro de
+	// (-4, 4), como toda rbita reanudada y todo z0 = 0 de Mandelbrot
+	if (*pzx > -bound && *pzx < bound && *pzy > -bound && *pzy < bound) {
+		FK_Q511State s = { *pzx, *pzy, cx, cy, iter, max_iter };
+		iter = fk_loop_q5_11(&s);
+		*pzx = s.zx;
+		*pzy = s.zy;
+		return iter;
+	}
+#endif
+	return fk_loop_q5_11_c(pzx, pzy, cx, cy, iter, max_iter);
+}
+
+static uint8_t fk_iterate_q4_27(int32_t *pzx, int32_t *pzy, int32_t cx, int32_t cy,
+uint8_t iter, uint8_t max_iter)
+{
+	int32_t zx = *pzx;
+	int32_t zy = *pzy;
+	const int64_t escape2 = (int64_t)4 << 27;
+	const int64_t bound   = (int64_t)4 << 27;
+	int64_t zx2 = fk_mul32(zx, zx);
+	int64_t zy2 = fk_mul32(zy, zy);
+
+	while (iter < max_iter) {
+		int64_t nx = zx2 - zy2 + cx;
+		int64_t ny = 2 * fk_mul32(zx, zy) + cy;
+
+		if (nx >= bound || nx <= -bound || ny >= bound || ny <= -bound) break;
+
+		zx = (int32_t)nx;
+		zy = (int32_t)ny;
+		zx2 = fk_mul32(zx, zx);
+		zy2 = fk_mul32(zy, zy);
+		if (zx2 + zy2 > escape2) break;
+
+		iter++;
+	}
+
+	*pzx = zx;
+	*pzy = zy;
+	return iter;
+}
+
+static uint8_t fk_iterate_q8_56(int64_t *pzx, int64_t *pzy, int64_t cx, int64_t cy,
+uint8_t iter, uint8_t max_iter)
+{
+	int64_t zx = *pzx;
+	int64_t zy = *pzy;
+	const int64_t escape2 = (int64_t)4 << 56;
+	const int64_t bound   = (int64_t)4 << 56;
+	int64_t zx2 = fk_mul64(zx, zx);
+	int64_t zy2 = fk_mul64(zy, zy);
+
+	while (iter < max_iter) {
+		int64_t nx = zx2 - zy2 + cx;
+		int64_t ny = 2 * fk_mul64(zx, zy) + cy;
+
+		if (nx >= bound || nx <= -bound || ny >= bound || ny <= -bound) break;
+
+		zx = nx;
+		zy = ny;
+		zx2 = fk_mul64(zx, zx);
+		zy2 = fk_mul64(zy, zy);
+		if (zx2 + zy2 > escape2) break;
+
+		iter++;
+	}
+
+	*pzx = zx;
+	*pzy = zy;
+	return iter;
+}
+
+// -----------------------------------------------------------------------------
+// API
+// -----------------------------------------------------------------------------
+uint8_t FK_FracBits(uint8_t kernel)
+{
+	return fk_frac_bits[kernel];
+}
+
+uint8_t FK_Bytes(uint8_t kernel)
+{
+	return (uint8_t)(2 << kernel);   // 2, 4, 8
+}
+
+uint8_t FK_Select(int64_t step)
+{
+	for (uint8_t k = 0; k < FK_COUNT; k++) {
+		if ((step >> (FK_VIEW_FRAC - fk_frac_bits[k])) >= FK_MIN_STEP_ULP)
+			return k;
+	}
+	return FK_NONE;
+}
+
+int64_t FK_FromView(uint8_t kernel, int64_t v)
+{
+	return v >> (FK_VIEW_FRAC - fk_frac_bits[kernel]);
+}
+
+uint8_t FK_Iterate(uint8_t kernel, int64_t zx, int64_t zy,
+int64_t cx, int64_t cy, uint8_t max_iter)
+{
+	return FK_Resume(kernel, &zx, &zy, cx, cy, 0, max_iter);
+}
+
+uint8_t FK_Resume(uint8_t kernel, int64_t *zx, int64_t *zy,
+int64_t cx, int64_t cy, uint8_t iter, uint8_t max_iter)
+{
+	switch (kernel) {
+		case FK_Q5_11: {
+			int16_t x = (int16_t)*zx, y = (int16_t)*zy;
+			iter = fk_iterate_q5_11(&x, &y, (int16_t)cx, (int16_t)cy, iter, max_iter);
+			*zx = x; *zy = y;
+			return iter;
+		}
+		case FK_Q4_27: {
+			int32_t x = (int32_t)*zx, y = (int32_t)*zy;
+			iter = fk_iterate_q4_27(&x, &y, (int32_t)cx, (int32_t)cy, iter, max_iter);
+			*zx = x; *zy = y;
+			return iter;
+		}
+		default:
+		return fk_iterate_q8_56(zx, zy, cx, cy, iter, max_iter);
+	}
+}
+
+#ifdef BENCH_BUILD
+uint8_t FK_IterateQ511C(int16_t zx, int16_t zy, int16_t cx, int16_t cy, uint8_t max_iter)
+{
+	return fk_loop_q5_11_c(&zx, &zy, cx, cy, 0, max_iter);
+}
+#endif
@@ -0,0 +1,53 @@
+// fractal_kernel.h - Ncleos de iteracin z = z^2 + c por ancho de palabra
+#ifndef FRACTAL_KERNEL_H_
+#define FRACTAL_KERNEL_H_
+
+#include <stdint.h>
+
+// Formatos disponibles, de ms barato a ms preciso
+#define FK_Q5_11   0   // 16 bits, rango +/-16,  resolucin 2^-11
+#define FK_Q4_27   1   // 32 bits, rango +/-16,  resolucin 2^-27
+#define FK_Q8_56   2   // 64 bits, rango +/-128, resolucin 2^-56
+#define FK_NONE    0xFF
+
+#define FK_COUNT   3
+
+// Las coordenadas de la vista se guardan siempre en Q8.56
+#define FK_VIEW_FRAC  56
+
+// Un paso entre pxeles debe valer al menos esta cantidad de unidades del
+// formato elegido: por debajo, el truncado del paso deforma la imagen.
+#define FK_MIN_STEP_ULP  16
+
+// Bits fraccionarios y bytes por componente de cada formato
+uint8_t FK_FracBits(uint8_t kernel);
+uint8_t FK_Bytes(uint8_t kernel);
+
+// Formato ms estrecho en el que un paso de 'step' (Q8.56) sigue siendo
+// exacto. FK_NONE si ninguno alcanza.
+uint8_t FK_Select(int64_t step);
+
+// Pasa un valor Q8.56 al formato del ncleo (desplazamiento aritmtico)
+int64_t FK_FromView(uint8_t kernel, int64_t v);
+
+// Itera desde z0 con la constante c (todo en unidades del ncleo).
+// Devuelve el nmero de iteraciones con |z|^2 <= 4, hasta max_iter.
+// Si |Re z| o |Im z| llega a 4 el punto ya escap y se corta antes de
+// que el formato desborde.
+uint8_t FK_Iterate(uint8_t kernel, int64_t zx, int64_t zy,
+                   int64_t cx, int64_t cy, uint8_t max_iter);
+
+// Contina una rbita guardada: *zx, *zy es el z tras 'iter' vueltas.
+// Al volver contienen el ltimo z (vlido solo si no escap, es decir,
+// si el resultado es igual a max_iter). Reanudar da exactamente el mismo
+// resultado que iterar de una vez hasta max_iter.
+uint8_t FK_Resume(uint8_t kernel, int64_t *zx, int64_t *zy,
+                  int64_t cx, int64_t cy, uint8_t iter, uint8_t max_iter);
+
+#ifdef BENCH_BUILD
+// El bucle Q5.11 en C aunque en AVR FK_Iterate use el .S: el benchmark
+// compara los dos (resultado y ciclos) sobre las mismas vistas.
+uint8_t FK_IterateQ511C(int16_t zx, int16_t zy, int16_t cx, int16_t cy, uint8_t max_iter);
+#endif
+
+#endif /* FRACTAL_KERNEL_H_ */
@@ -0,0 +1,241 @@
+// frame_cache.c - Cach de fotogramas RGB565 en la SD
+//
+// Reutiliza el buffer de sector de fat_fs.c: mientras se reproduce o se
+// escribe un fotograma no hay otras lecturas FAT en curso.
+
+#include "frame_cache.h"
+#include "fat_fs.h"
+#include "sd_spi.h"
+#include "tft_st7735.h"
+#include <string.h>
+
+#define FCACHE_FRAME_BYTES    ((uint32_t)TFT_WIDTH * TFT_HEIGHT * 2)
+#define FCACHE_FRAME_SECTORS  ((FCACHE_FRAME_BYTES + 511) / 512)
+#define FCACHE_SLOT_SECTORS   (1 + FCACHE_FRAME_SECTORS)
+
+// Cabecera de ranura (sector 0 de cada ranura)
+#define HDR_MAGIC    0   // "FCAC"
+#define HDR_VALID    4
+#define HDR_KEYLEN   5
+#define HDR_HASH     6   // 4 bytes, little endian
+#define HDR_KEY      10
+
+FCACHE_Stats g_fcache_stats;
+
+static uint32_t fc_base_lba;      // primer sector del archivo
+static uint16_t fc_slots;         // nmero de ranuras
+static uint8_t  fc_ready;
+
+static uint8_t  fc_key[FCACHE_MAX_KEY];
+static uint8_t  fc_key_len;
+static uint32_t fc_hash;
+static uint32_t fc_slot_lba;      // cabecera de la ranura actual
+
+// Estado de escritura
+static uint8_t  fc_writing;
+static uint16_t fc_pos;           // bytes en el buffer de sector
+static uint16_t fc_sector;        // sector del fotograma que se est llenando
+
+// -----------------------------------------------------------------------------
+// FNV-1a de 32 bits sobre la clave
+// -----------------------------------------------------------------------------
+static uint32_t FCACHE_Hash(const uint8_t *p, uint8_t len)
+{
+	uint32_t h = 2166136261UL;
+	for (uint8_t i = 0; i < len; i++) {
+		h ^= p[i];
+		h *= 16777619UL;
+	}
+	return h;
+}
+
+static uint8_t FCACHE_WriteHeader(uint8_t valid)
+{
+	uint8_t *buf = FAT_SectorBuffer();
+
+	memset(buf, 0, 512);
+	buf[HDR_MAGIC + 0] = 'F';
+	buf[HDR_MAGIC + 1] = 'C';
+	buf[HDR_MAGIC + 2] = 'A';
+	buf[HDR_MAGIC + 3] = 'C';
+	buf[HDR_VALID]  = valid;
+	buf[HDR_KEYLEN] = fc_key_len;
+	buf[HDR_HASH + 0] = (uint8_t)(fc_hash);
+	buf[HDR_HASH + 1] = (uint8_t)(fc_hash >> 8);
+	buf[HDR_HASH + 2] = (uint8_t)(fc_hash >> 16);
+	buf[HDR_HASH + 3] = (uint8_t)(fc_hash >> 24);
+	memcpy(&buf[HDR_KEY], fc_key, fc_key_len);
+
+	return SD_WriteBlock(fc_slot_lba, buf);
+}
+
+// -----------------------------------------------------------------------------
+// API
+// -----------------------------------------------------------------------------
+uint8_t FCACHE_Init(void)
+{
+	FAT_File   f;
+	FAT_Extent ext;
+
+	fc_ready = 0;
+	fc_writing = 0;
+
+	if (FAT_Open(&f, FRAME_CACHE_FILE) != 0) return FCACHE_ERR_NOFILE;
+
+	fc_slots = (uint16_t)((f.size_bytes / 512) / FCACHE_SLOT_SECTORS);
+	if (fc_slots == 0) return FCACHE_ERR_NOFILE;
+
+	// Las ranuras se escriben por LBA: con el archivo fragmentado se
+	// pisaran otros archivos o la FAT
+	if (FAT_GetExtents(&f, &ext, 1) != 1 ||
+	    ext.sectors < (uint32_t)fc_slots * FCACHE_SLOT_SECTORS)
+		return FCACHE_ERR_FRAG;
+
+	fc_base_lba = ext.lba;
+	fc_ready = 1;
+	return FCACHE_OK;
+}
+
+uint8_t FCACHE_Ready(void)
+{
+	return fc_ready;
+}
+
+uint8_t FCACHE_Lookup(const void *key, uint8_t key_len)
+{
+	if (!fc_ready || key_len > FCACHE_MAX_KEY) return 0;
+
+	memcpy(fc_key, key, key_len);
+	fc_key_len  = key_len;
+	fc_hash     = FCACHE_Hash(fc_key, key_len);
+	fc_slot_lba = fc_base_lba + (fc_hash % fc_slots) * FCACHE_SLOT_SECTORS;
+
+	g_fcache_stats.lookups++;
+
+	uint8_t *buf = FAT_SectorBuffer();
+	if (SD_ReadBlock(fc_slot_lba, buf) != SD_OK) return 0;
+
+	if (buf[HDR_MAGIC] != 'F' || buf[HDR_MAGIC + 1] != 'C' ||
+	buf[HDR_MAGIC + 2] != 'A' || buf[HDR_MAGIC + 3] != 'C') return 0;
+	if (buf[HDR_VALID] != 1)         return 0;
+	if (buf[HDR_KEYLEN] != key_len)  return 0;
+
+	// El hash solo elige la ranura; la clave completa decide el acierto
+	if (memcmp(&buf[HDR_KEY], fc_key, key_len) != 0) return 0;
+
+	g_fcache_stats.hits++;
+	return 1;
+}
+
+uint8_t FCACHE_Replay(uint8_t row0)
+{
+	uint8_t *buf = FAT_SectorBuffer();
+	uint32_t remaining = FCACHE_FRAME_BYTES;
+	uint32_t lba = fc_slot_lba + 1;
+
+	// Con scroll, el fotograma se parte en dos ventanas: de row0 al final
+	// de la GRAM y, tras dar la vuelta, de la lnea 0 a row0-1.
+	uint32_t wrap_at = FCACHE_FRAME_BYTES - (uint32_t)row0 * TFT_WIDTH * 2;
+
+	TFT_SetAddrWindow(0, row0, TFT_WIDTH - 1, TFT_HEIGHT - 1);
+
+	while (remaining > 0) {
+		// La SD y el TFT comparten el bus: leer con el TFT deseleccionado
+		if (SD_ReadBlock(lba++, buf) != SD_OK) return FCACHE_ERR_IO;
+
+		uint16_t n = (remaining > 512) ? 512 : (uint16_t)remaining;
+		uint16_t first = n;
+		uint32_t sent = FCACHE_FRAME_BYTES - remaining;
+
+		if (row0 && sent < wrap_at && sent + n > wrap_at)
+			first = (uint16_t)(wrap_at - sent);
+
+		TFT_StartWrite();
+		TFT_WriteBytes(buf, first);
+		TFT_EndWrite();
+
+		if (first < n || (row0 && sent + n == wrap_at)) {
+			TFT_SetAddrWindow(0, 0, TFT_WIDTH - 1, row0 - 1);
+			if (first < n) {
+				TFT_StartWrite();
+				TFT_WriteBytes(buf + first, n - first);
+				TFT_EndWrite();
+			}
+		}
+
+		remaining -= n;
+	}
+
+	return FCACHE_OK;
+}
+
+uint8_t FCACHE_BeginWrite(void)
+{
+	if (!fc_ready || fc_key_len == 0) return FCACHE_ERR_KEY;
+
+	// Invalidar primero la ranura: si se corta a mitad, no queda una
+	// cabecera vlida apuntando a un fotograma a medias.
+	if (FCACHE_WriteHeader(0) != SD_OK) return FCACHE_ERR_IO;
+
+	fc_pos = 0;
+	fc_sector = 0;
+	fc_writing = 1;
+	return FCACHE_OK;
+}
+
+static void FCACHE_FlushSector(void)
+{
+	if (SD_WriteBlock(fc_slot_lba + 1 + fc_sector, FAT_SectorBuffer()) != SD_OK) {
+		fc_writing = 0; // abandonar; la ranura queda invlida
+		return;
+	}
+	fc_sector++;
+	fc_pos = 0;
+}
+
+void FCACHE_PutPixel(uint16_t color)
+{
+	if (!fc_writing) return;
+
+	uint8_t *buf = FAT_SectorBuffer();
+	buf[fc_pos++] = color >> 8;
+	buf[fc_pos++] = color & 0xFF;
+
+	if (fc_pos == 512) {
+		// Pausar la rfaga del TFT: el ST7735 sigue con el mismo RAMWR
+		// cuando CS vuelve a bajar con DC=1.
+		TFT_EndWrite();
+		FCACHE_FlushSector();
+		TFT_StartWrite();
+	}
+}
+
+uint8_t FCACHE_PutSector(const uint8_t *sector)
+{
+	if (!fc_writing || fc_pos != 0) return FCACHE_ERR_IO;
+
+	if (SD_WriteBlock(fc_slot_lba + 1 + fc_sector, sector) != SD_OK) {
+		fc_writing = 0;
+		return FCACHE_ERR_IO;
+	}
+	fc_sector++;
+	return FCACHE_OK;
+}
+
+uint8_t FCACHE_EndWrite(void)
+{
+	if (!fc_writing) return FCACHE_ERR_IO;
+
+	if (fc_pos > 0) {
+		memset(FAT_SectorBuffer() + fc_pos, 0, 512 - fc_pos);
+		FCACHE_FlushSector();
+	}
+
+	if (!fc_writing || fc_sector != FCACHE_FRAME_SECTORS) {
+		fc_writing = 0;
+		return FCACHE_ERR_IO;
+	}
+
+	fc_writing = 0;
+	return (FCACHE_WriteHeader(1) == SD_OK) ? FCACHE_OK : FCACHE_ERR_IO;
+}
@@ -0,0 +1,58 @@
+// frame_cache.h
+#ifndef FRAME_CACHE_H_
+#define FRAME_CACHE_H_
+
+#include <stdint.h>
+
+// Cach de fotogramas completos (RGB565) en un archivo preasignado de la SD.
+//
+// El archivo FRAME_CACHE_FILE debe existir en el root, contiguo, y se divide
+// en ranuras de FCACHE_SLOT_SECTORS sectores: 1 sector de cabecera (clave)
+// + el fotograma en crudo, tal cual se enva al TFT.
+// Crearlo desde el PC, p.ej.:  dd if=/dev/zero of=FRACTAL.CAC bs=512 count=850
+
+#define FRAME_CACHE_FILE     "FRACTAL.CAC"
+#define FCACHE_MAX_KEY       32
+
+#define FCACHE_OK            0
+#define FCACHE_ERR_NOFILE    1
+#define FCACHE_ERR_IO        2
+#define FCACHE_ERR_KEY       3
+#define FCACHE_ERR_FRAG      4    // el archivo no es contiguo
+
+// Bsquedas y aciertos desde el arranque (para diagnstico)
+typedef struct {
+	uint16_t lookups;
+	uint16_t hits;
+} FCACHE_Stats;
+
+extern FCACHE_Stats g_fcache_stats;
+
+// Abre el archivo de cach. Requiere SD_Init() y FAT_Init() previos.
+// Si no es contiguo la cach queda desactivada (FCACHE_ERR_FRAG).
+uint8_t FCACHE_Init(void);
+
+// 1 si la cach est disponible
+uint8_t FCACHE_Ready(void);
+
+// Busca la clave (bytes arbitrarios) en su ranura.
+// Devuelve 1 si hay un fotograma vlido para ella, 0 si no.
+// La clave queda recordada para un FCACHE_BeginWrite posterior.
+uint8_t FCACHE_Lookup(const void *key, uint8_t key_len);
+
+// Vuelca el fotograma encontrado por FCACHE_Lookup a pantalla completa.
+// row0: lnea de GRAM donde va la primera fila (scroll vertical actual).
+uint8_t FCACHE_Replay(uint8_t row0);
+
+// Escritura "write-through" del fotograma mientras se dibuja.
+// FCACHE_PutPixel se llama DENTRO de una rfaga TFT_StartWrite/EndWrite
+// y en el mismo orden que los pxeles enviados al TFT.
+uint8_t FCACHE_BeginWrite(void);
+void    FCACHE_PutPixel(uint16_t color);
+
+// Alternativa a FCACHE_PutPixel fuera de una rfaga TFT: escribe el
+// siguiente sector del fotograma (512 bytes, ya en orden de envo).
+uint8_t FCACHE_PutSector(const uint8_t *sector);
+uint8_t FCACHE_EndWrite(void);
+
+#endif /* FRAME_CACHE_H_ */
@@ -0,0 +1,14 @@
+// host/avr/interrupt.h - Sin interrupciones en el simulador
+#ifndef HOST_AVR_INTERRUPT_H_
+#define HOST_AVR_INTERRUPT_H_
+
+#include <avr/io.h>
+
+// La ISR queda como funcin normal: la llama el simulador si se le da
+// (SIM_SetTimer1Isr, SIM_SetUsartRxIsr)
+#define ISR(vector)  void vector(void)
+
+#define sei()  ((void)0)
+#define cli()  ((void)0)
+
+#endif /* HOST_AVR_INTERRUPT_H_ */
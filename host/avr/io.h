@@ -0,0 +1,91 @@
+// host/avr/io.h - Registros del ATmega32 simulados como variables
+//
+// Solo para compilar en Linux los mdulos que incluyen <avr/io.h>
+// (a travs de spi_hal.h). El backend de simulacin no lee estos
+// registros: el bus SPI se modela en spi_hal_sim.c.
+#ifndef HOST_AVR_IO_H_
+#define HOST_AVR_IO_H_
+
+#include <stdint.h>
+
+extern volatile uint8_t DDRA, PORTA, PINA;
+extern volatile uint8_t DDRB, PORTB, PINB;
+extern volatile uint8_t DDRC, PORTC, PINC;
+extern volatile uint8_t DDRD, PORTD, PIND;
+extern volatile uint8_t SPCR, SPSR, SPDR;
+extern volatile uint8_t SREG;
+
+// Timer1 (cycles.c): avanza con el reloj simulado (SIM_Advance)
+extern volatile uint8_t  TCCR1A, TCCR1B, TIMSK, TIFR;
+extern volatile uint16_t TCNT1;
+
+// Timer0 (buttons.c): en CTC, tambin con el reloj simulado
+extern volatile uint8_t  TCCR0, TCNT0, OCR0;
+
+// USART: el simulador sustituye uart.c por host/uart_sim.c. Solo
+// USART_RXC_vect (uart_stream.c) lee UDR y UCSRA, que pone ah el simulador.
+extern volatile uint8_t UBRRH, UBRRL, UCSRA, UCSRB, UCSRC, UDR;
+
+#define PA0 0
+#define PA1 1
+#define PA2 2
+#define PA3 3
+#define PA4 4
+#define PA5 5
+#define PA6 6
+#define PA7 7
+
+#define PB0 0
+#define PB1 1
+#define PB2 2
+#define PB3 3
+#define PB4 4
+#define PB5 5
+#define PB6 6
+#define PB7 7
+
+#define PC0 0
+#define PC1 1
+#define PC2 2
+#define PC3 3
+#define PC4 4
+#define PC5 5
+#define PC6 6
+#define PC7 7
+
+#define PD0 0
+#define PD1 1
+#define PD2 2
+#define PD3 3
+#define PD4 4
+#define PD5 5
+#define PD6 6
+#define PD7 7
+
+#define SPIF  7
+#define SPE   6
+#define MSTR  4
+#define SPI2X 0
+
+#define CS00  0
+#define CS01  1
+#define CS02  2
+#define WGM01 3
+#define OCIE0 1
+
+#define CS10  0
+#define TOIE1 2
+#define TOV1  2
+
+#define RXC   7
+#define UDRE  5
+#define DOR   3
+#define U2X   1
+#define RXCIE 7
+#define RXEN  4
+#define TXEN  3
+#define URSEL 7
+#define UCSZ1 2
+#define UCSZ0 1
+
+#endif /* HOST_AVR_IO_H_ */
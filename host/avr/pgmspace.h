@@ -0,0 +1,15 @@
+// host/avr/pgmspace.h - En Linux la "flash" es memoria normal
+#ifndef HOST_AVR_PGMSPACE_H_
+#define HOST_AVR_PGMSPACE_H_
+
+#include <stdint.h>
+#include <string.h>
+
+#define PROGMEM
+#define PSTR(s)              (s)
+#define pgm_read_byte(p)     (*(const uint8_t *)(p))
+#define pgm_read_word(p)     (*(const uint16_t *)(p))
+#define pgm_read_dword(p)    (*(const uint32_t *)(p))
+#define memcpy_P             memcpy
+
+#endif /* HOST_AVR_PGMSPACE_H_ */
@@ -0,0 +1,14 @@
+// host/avr/sleep.h - Dormir en el simulador es adelantar el reloj
+#ifndef HOST_AVR_SLEEP_H_
+#define HOST_AVR_SLEEP_H_
+
+void SIM_Sleep(void);   // host/spi_hal_sim.c
+
+#define SLEEP_MODE_IDLE  0
+
+#define set_sleep_mode(mode)  ((void)(mode))
+#define sleep_enable()        ((void)0)
+#define sleep_disable()       ((void)0)
+#define sleep_cpu()           SIM_Sleep()
+
+#endif /* HOST_AVR_SLEEP_H_ */
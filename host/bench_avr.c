@@ -0,0 +1,268 @@
+// host/bench_avr.c - Benchmark del firmware real bajo simavr
+//
+// Carga el ELF compilado con -DBENCH_BUILD en un ATmega32 simulado
+// ciclo a ciclo y conecta su SPI y sus pines de CS/DC a los modelos de
+// host/spi_hal_sim.c (ST7735 virtual + SD sobre imagen). Las lneas
+// "BENCH <nombre> <mtrica> <ciclos>" que el firmware manda por la USART
+// salen por stdout y se comparan con una lnea base.
+//
+// Preparar (desde la raz del proyecto):
+//   avr-gcc -mmcu=atmega32 -Os -DF_CPU=8000000UL -DBENCH_BUILD -o bench.elf
+//       main.c spi_hal.c sd_spi.c fat_fs.c bmp_stream.c tft_st7735.c
+//       frame_cache.c fractal.c fractal_kernel.c cycles.c uart.c
+//       font5x7.c hud.c prof.c anim.c pak.c uart_stream.c scratch.c
+//       buttons.c fractal_kernel_avr.S
+//   gcc -O2 -o bench_corpus host/bench_corpus.c
+//   gcc -O2 -o mkimg host/mkimg.c
+//   gcc -O2 -Ihost -I. -I/usr/include/simavr -o bench_avr
+//       host/bench_avr.c host/spi_hal_sim.c host/uart_sim.c -lsimavr -lelf
+//   (con la misma -DBOARD_... en los dos: los pines salen de board.h)
+//   mkdir corpus && ./bench_corpus corpus && ./mkimg bench.img 8 corpus/*.BMP
+//
+// Uso:
+//   bench_avr bench.elf bench.img                 comparar con BENCH_BASELINE
+//   bench_avr bench.elf bench.img base.txt [umbral%]   con otra base (def. 5%)
+//   bench_avr bench.elf bench.img -               solo medir
+//   bench_avr -w base.txt bench.elf bench.img     grabar lnea base
+//
+// La lnea base del proyecto es host/bench_baseline.txt (desde la raz).
+// Termina con cdigo 1 si alguna mtrica empeora ms que el umbral, si
+// una mtrica con base 0 deja de serlo (kernel/q5_11 mismatch), si falta
+// alguna mtrica de la base o si el firmware no llega a "BENCH done".
+// Las mtricas que no estn en la base se informan como nuevas y no
+// fallan. Regrabar la base (-w) solo cuando un cambio de rendimiento es
+// intencionado.
+//
+// La imagen de disco se modifica si el firmware escribe (cach): usar
+// una copia nueva en cada ejecucin para que las medidas sean repetibles.
+
+#include "sim.h"
+#include "spi_hal.h"
+
+#include <sim_avr.h>
+#include <sim_elf.h>
+#include <sim_irq.h>
+#include <avr_ioport.h>
+#include <avr_spi.h>
+#include <avr_uart.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define MAX_RESULTS  128
+#define LINE_MAX     128
+
+#define BENCH_BASELINE  "host/bench_baseline.txt"
+
+typedef struct {
+	char     name[64];
+	char     metric[32];
+	uint32_t value;
+} Result;
+
+static Result   results[MAX_RESULTS];
+static int      nresults;
+static int      done;
+
+static char     line[LINE_MAX];
+static int      line_len;
+
+static avr_irq_t *spi_in;
+
+// -----------------------------------------------------------------------------
+// Enganches de simavr -> modelos de spi_hal_sim.c
+// -----------------------------------------------------------------------------
+
+static void on_spi(struct avr_irq_t *irq, uint32_t value, void *param)
+{
+	(void)irq; (void)param;
+	avr_raise_irq(spi_in, SPI_Transfer((uint8_t)value));
+}
+
+static void on_tft_cs(struct avr_irq_t *irq, uint32_t value, void *param)
+{
+	(void)irq; (void)param;
+	if (value) SPI_TFT_Unselect(); else SPI_TFT_Select();
+}
+
+static void on_sd_cs(struct avr_irq_t *irq, uint32_t value, void *param)
+{
+	(void)irq; (void)param;
+	if (value) SPI_SD_Unselect(); else SPI_SD_Select();
+}
+
+static void on_tft_dc(struct avr_irq_t *irq, uint32_t value, void *param)
+{
+	(void)irq; (void)param;
+	if (value) TFT_DC_Data(); else TFT_DC_Command();
+}
+
+static void on_uart(struct avr_irq_t *irq, uint32_t value, void *param)
+{
+	(void)irq; (void)param;
+
+	if (value != '\n') {
+		if (line_len < LINE_MAX - 1) line[line_len++] = (char)value;
+		return;
+	}
+
+	line[line_len] = 0;
+	line_len = 0;
+	puts(line);
+
+	Result r;
+	if (strcmp(line, "BENCH done") == 0) {
+		done = 1;
+	} else if (nresults < MAX_RESULTS &&
+	           sscanf(line, "BENCH %63s %31s %u", r.name, r.metric, &r.value) == 3) {
+		results[nresults++] = r;
+	}
+}
+
+// -----------------------------------------------------------------------------
+// Lnea base
+// -----------------------------------------------------------------------------
+
+static int write_baseline(const char *path)
+{
+	FILE *f = fopen(path, "w");
+	if (!f) { perror(path); return 1; }
+
+	fprintf(f, "# nombre mtrica ciclos (generado por bench_avr -w)\n");
+	for (int i = 0; i < nresults; i++)
+		fprintf(f, "%s %s %u\n", results[i].name, results[i].metric, results[i].value);
+	return fclose(f) != 0;
+}
+
+static int compare_baseline(const char *path, double threshold)
+{
+	FILE *f = fopen(path, "r");
+	if (!f) { perror(path); return 1; }
+
+	Result base[MAX_RESULTS];
+	int nbase = 0;
+	char buf[LINE_MAX];
+
+	while (fgets(buf, sizeof(buf), f) && nbase < MAX_RESULTS) {
+		if (buf[0] == '#') continue;
+		if (sscanf(buf, "%63s %31s %u", base[nbase].name, base[nbase].metric,
+		           &base[nbase].value) == 3)
+			nbase++;
+	}
+	fclose(f);
+
+	int fail = 0;
+	for (int i = 0; i < nresults; i++) {
+		const Result *r = &results[i];
+		const Result *b = NULL;
+
+		for (int j = 0; j < nbase; j++)
+			if (!strcmp(base[j].name, r->name) && !strcmp(base[j].metric, r->metric))
+				b = &base[j];
+
+		if (!b) {
+			printf("NEW  %s %s %u\n", r->name, r->metric, r->value);
+			continue;
+		}
+
+		// Con la base a 0 (p. ej. kernel/q5_11 mismatch) falla cualquier valor
+		double delta = b->value ? 100.0 * ((double)r->value - b->value) / b->value : 0.0;
+		int bad = b->value ? delta > threshold : r->value != 0;
+		printf("%s %s %s %u -> %u (%+.1f%%)\n", bad ? "FAIL" : "ok  ",
+		       r->name, r->metric, b->value, r->value, delta);
+		fail |= bad;
+	}
+
+	// Una medida que desaparece tambin es un fallo
+	for (int j = 0; j < nbase; j++) {
+		int found = 0;
+
+		for (int i = 0; i < nresults && !found; i++)
+			found = !strcmp(base[j].name, results[i].name) &&
+			        !strcmp(base[j].metric, results[i].metric);
+		if (!found) {
+			printf("MISS %s %s %u\n", base[j].name, base[j].metric, base[j].value);
+			fail = 1;
+		}
+	}
+
+	return fail;
+}
+
+// -----------------------------------------------------------------------------
+
+int main(int argc, char **argv)
+{
+	const char *write_path = NULL;
+	int a = 1;
+
+	if (a + 1 < argc && strcmp(argv[a], "-w") == 0) {
+		write_path = argv[a + 1];
+		a += 2;
+	}
+	if (argc - a < 2) {
+		fprintf(stderr, "uso: %s [-w base.txt] firmware.elf disco.img [base.txt|- [umbral%%]]\n",
+		        argv[0]);
+		return 2;
+	}
+
+	elf_firmware_t fw;
+	memset(&fw, 0, sizeof(fw));
+	if (elf_read_firmware(argv[a], &fw) != 0) {
+		fprintf(stderr, "no se pudo leer %s\n", argv[a]);
+		return 2;
+	}
+
+	avr_t *avr = avr_make_mcu_by_name("atmega32");
+	if (!avr) return 2;
+	avr_init(avr);
+	avr_load_firmware(avr, &fw);
+	avr->frequency = 8000000;
+
+	if (SIM_Open(argv[a + 1], 0) != 0) {
+		perror(argv[a + 1]);
+		return 2;
+	}
+
+	spi_in = avr_io_getirq(avr, AVR_IOCTL_SPI_GETIRQ(0), SPI_IRQ_INPUT);
+	avr_irq_register_notify(avr_io_getirq(avr, AVR_IOCTL_SPI_GETIRQ(0), SPI_IRQ_OUTPUT),
+	                        on_spi, NULL);
+
+	// Mismos pines que el firmware (board.h, con la misma -DBOARD_...)
+	avr_irq_register_notify(avr_io_getirq(avr, AVR_IOCTL_IOPORT_GETIRQ(TFT_CS_PORT_ID), TFT_CS_PIN),
+	                        on_tft_cs, NULL);
+	avr_irq_register_notify(avr_io_getirq(avr, AVR_IOCTL_IOPORT_GETIRQ(SD_CS_PORT_ID), SD_CS_PIN),
+	                        on_sd_cs, NULL);
+	avr_irq_register_notify(avr_io_getirq(avr, AVR_IOCTL_IOPORT_GETIRQ(TFT_DC_PORT_ID), TFT_DC_PIN),
+	                        on_tft_dc, NULL);
+
+	// La USART: nada por el stdio de simavr, solo por on_uart
+	uint32_t flags = 0;
+	avr_ioctl(avr, AVR_IOCTL_UART_GET_FLAGS('0'), &flags);
+	flags &= ~AVR_UART_FLAG_STDIO;
+	avr_ioctl(avr, AVR_IOCTL_UART_SET_FLAGS('0'), &flags);
+	avr_irq_register_notify(avr_io_getirq(avr, AVR_IOCTL_UART_GETIRQ('0'), UART_IRQ_OUTPUT),
+	                        on_uart, NULL);
+
+	int state;
+	do {
+		state = avr_run(avr);
+	} while (state != cpu_Done && state != cpu_Crashed);
+
+	SIM_Close();
+
+	if (!done) {
+		fprintf(stderr, "el firmware no termin el benchmark\n");
+		return 1;
+	}
+
+	if (write_path)
+		return write_baseline(write_path);
+
+	const char *base = (argc - a >= 3) ? argv[a + 2] : BENCH_BASELINE;
+	if (!strcmp(base, "-"))
+		return 0;
+
+	return compare_baseline(base, (argc - a >= 4) ? atof(argv[a + 3]) : 5.0);
+}
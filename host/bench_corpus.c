@@ -0,0 +1,66 @@
+// host/bench_corpus.c - Corpus fijo de BMP para el benchmark
+//
+// Uso: bench_corpus DIRECTORIO
+// Escribe BMP de 24 bits (de abajo arriba) con contenido determinista:
+//   GRAD.BMP   132x162  pantalla completa
+//   SMALL.BMP   64x48   centrada, pocas filas
+//   ODD.BMP    101x77   ancho impar: filas con relleno
+//   TALL.BMP   132x240  ms alta que la pantalla (se recorta)
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+static void put16(uint8_t *p, uint16_t v) { p[0] = (uint8_t)v; p[1] = (uint8_t)(v >> 8); }
+static void put32(uint8_t *p, uint32_t v) { put16(p, (uint16_t)v); put16(p + 2, (uint16_t)(v >> 16)); }
+
+static int write_bmp(const char *dir, const char *name, int w, int h)
+{
+	char path[512];
+	snprintf(path, sizeof(path), "%s/%s", dir, name);
+
+	FILE *f = fopen(path, "wb");
+	if (!f) { perror(path); return 1; }
+
+	int stride = (w * 3 + 3) & ~3;
+	uint8_t hdr[54];
+	memset(hdr, 0, sizeof(hdr));
+	hdr[0] = 'B'; hdr[1] = 'M';
+	put32(hdr + 2, 54 + (uint32_t)stride * h);
+	put32(hdr + 10, 54);
+	put32(hdr + 14, 40);
+	put32(hdr + 18, (uint32_t)w);
+	put32(hdr + 22, (uint32_t)h);
+	put16(hdr + 26, 1);
+	put16(hdr + 28, 24);
+	put32(hdr + 34, (uint32_t)stride * h);
+	fwrite(hdr, 1, sizeof(hdr), f);
+
+	uint8_t row[4 * 1024];
+	for (int y = h - 1; y >= 0; y--) {
+		memset(row, 0, (size_t)stride);
+		for (int x = 0; x < w; x++) {
+			row[x * 3 + 0] = (uint8_t)(x * 255 / (w - 1));          // B
+			row[x * 3 + 1] = (uint8_t)(y * 255 / (h - 1));          // G
+			row[x * 3 + 2] = (uint8_t)((x ^ y) * 4);                // R
+		}
+		fwrite(row, 1, (size_t)stride, f);
+	}
+
+	return fclose(f) != 0;
+}
+
+int main(int argc, char **argv)
+{
+	if (argc != 2) {
+		fprintf(stderr, "uso: %s DIRECTORIO\n", argv[0]);
+		return 1;
+	}
+
+	int err = 0;
+	err |= write_bmp(argv[1], "GRAD.BMP",  132, 162);
+	err |= write_bmp(argv[1], "SMALL.BMP",  64,  48);
+	err |= write_bmp(argv[1], "ODD.BMP",   101,  77);
+	err |= write_bmp(argv[1], "TALL.BMP",  132, 240);
+	return err;
+}
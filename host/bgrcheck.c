@@ -0,0 +1,125 @@
+// host/bgrcheck.c - TFT_WriteBGR888 contra la frmula de empaquetado
+//
+// Pasa los 2^24 colores BGR888 por TFT_WriteBGR888 (el mismo bucle de
+// envo solapado que en el AVR, ver tft_st7735.c) sobre el bus de
+// host/spi_hal_sim.c, en 565 y en 444, y compara cada byte que llega al
+// TFT con el empaquetado directo:
+//   565: RRRRRGGG GGGBBBBB
+//   444: dos pxeles en RRRRGGGG BBBBRRRR GGGGBBBB
+// Los colores van en llamadas de 1 a BGR_MAX_RUN pxeles (un solo pxel,
+// pares, impares, y en 444 medio par pendiente entre llamadas).
+// Termina con 1 al primer modo con algn byte distinto o de menos.
+//
+// Compilar (desde la raz del proyecto):
+//   gcc -std=gnu99 -O2 -Wall -Ihost -I. -o bgrcheck host/bgrcheck.c
+//       tft_st7735.c font5x7.c host/spi_hal_sim.c host/uart_sim.c
+
+#include "sim.h"
+#include "spi_hal.h"
+#include "tft_st7735.h"
+
+#include <stdio.h>
+#include <stdint.h>
+
+#define BGR_COLORS   (1UL << 24)
+#define BGR_MAX_RUN  67
+
+static uint8_t  chk_mode;
+static uint32_t chk_next;        // prximo pxel de la secuencia esperada
+static uint8_t  chk_exp[3];      // bytes esperados an no recibidos
+static uint8_t  chk_have, chk_pos;
+static uint32_t chk_bytes, chk_bad, chk_cmds;
+
+// Color nmero i de la secuencia: B el ms bajo, R el ms alto
+static void chk_color(uint32_t i, uint8_t *b, uint8_t *g, uint8_t *r)
+{
+	*b = (uint8_t)i;
+	*g = (uint8_t)(i >> 8);
+	*r = (uint8_t)(i >> 16);
+}
+
+static void chk_refill(void)
+{
+	uint8_t b, g, r;
+
+	chk_pos = 0;
+	if (chk_mode == TFT_COLOR_565) {
+		chk_color(chk_next++, &b, &g, &r);
+		uint16_t c = (uint16_t)((r & 0xF8) << 8 | (g & 0xFC) << 3 | b >> 3);
+		chk_exp[0] = (uint8_t)(c >> 8);
+		chk_exp[1] = (uint8_t)c;
+		chk_have = 2;
+	} else {
+		chk_color(chk_next++, &b, &g, &r);
+		uint16_t c0 = (uint16_t)((r >> 4) << 8 | (g >> 4) << 4 | b >> 4);
+		chk_color(chk_next++, &b, &g, &r);
+		uint16_t c1 = (uint16_t)((r >> 4) << 8 | (g >> 4) << 4 | b >> 4);
+		chk_exp[0] = (uint8_t)(c0 >> 4);
+		chk_exp[1] = (uint8_t)(c0 << 4 | c1 >> 8);
+		chk_exp[2] = (uint8_t)c1;
+		chk_have = 3;
+	}
+}
+
+static void chk_tap(uint8_t data, uint8_t dc)
+{
+	if (!dc) {
+		chk_cmds++;
+		return;
+	}
+	if (chk_pos == chk_have) chk_refill();
+
+	uint8_t want = chk_exp[chk_pos++];
+	if (data != want && chk_bad++ < 8)
+		printf("  byte %lu (pxel %lu): 0x%02X, se esperaba 0x%02X\n",
+		       (unsigned long)chk_bytes, (unsigned long)(chk_next - 1), data, want);
+	chk_bytes++;
+}
+
+static int chk_run(uint8_t mode, const char *name)
+{
+	static uint8_t buf[BGR_MAX_RUN * 3];
+	uint32_t i = 0;
+	uint8_t  run = 1;
+
+	TFT_SetColorMode(mode);
+
+	chk_mode = mode;
+	chk_next = 0;
+	chk_have = chk_pos = 0;
+	chk_bytes = chk_bad = chk_cmds = 0;
+	SIM_SetTftTap(chk_tap);
+
+	TFT_StartWrite();
+	while (i < BGR_COLORS) {
+		uint16_t n = run;
+		if (n > BGR_COLORS - i) n = (uint16_t)(BGR_COLORS - i);
+
+		for (uint16_t k = 0; k < n; k++)
+			chk_color(i + k, &buf[k * 3 + 0], &buf[k * 3 + 1], &buf[k * 3 + 2]);
+		TFT_WriteBGR888(buf, n);
+
+		i += n;
+		run = (run == BGR_MAX_RUN) ? 1 : run + 1;
+	}
+	TFT_EndWrite();
+	SIM_SetTftTap(NULL);
+
+	uint32_t want = (mode == TFT_COLOR_565) ? BGR_COLORS * 2 : BGR_COLORS / 2 * 3;
+	int fail = chk_bad || chk_cmds || chk_bytes != want || chk_pos != chk_have;
+
+	printf("%s: %lu bytes de %lu, %lu distintos, %lu comandos%s\n", name,
+	       (unsigned long)chk_bytes, (unsigned long)want, (unsigned long)chk_bad,
+	       (unsigned long)chk_cmds, fail ? "  FALLA" : "");
+	return fail;
+}
+
+int main(void)
+{
+	SPI_Init(4);
+	TFT_Init();
+
+	if (chk_run(TFT_COLOR_565, "565")) return 1;
+	if (chk_run(TFT_COLOR_444, "444")) return 1;
+	return 0;
+}
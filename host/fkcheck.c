@@ -0,0 +1,249 @@
+// host/fkcheck.c - Ncleos de fractal_kernel.c contra una rbita en coma flotante
+//
+// Para cada ncleo (Q5.11, Q4.27, Q8.56) toma vistas al azar entre los
+// zooms en los que fractal.c lo elige con FK_Select, con el centro cerca
+// del borde del conjunto, e itera cada pxel con FK_Iterate y con
+// z = z^2 + c en coma flotante desde los mismos z0 y c (los valores del
+// formato, as no cuenta el error de la rejilla, solo el de la
+// aritmtica). La referencia es long double: en x86 tiene 64 bits de
+// mantisa y representa exactos los Q8.56, que en double (53 bits) ya se
+// redondearan al pasarlos.
+//
+// Informa por ncleo:
+//  - pxeles con otro nmero de iteraciones, y el error medio y mximo,
+//  - millones de iteraciones por segundo de FK_Iterate en este PC. Los
+//    ciclos por iteracin en el AVR los da el benchmark del firmware
+//    (lnea "BENCH kernel/q5_11 iter_cycles" de host/bench_avr.c).
+// Termina con 1 si en algn ncleo los pxeles distintos pasan de su
+// lmite (chk_limit, o -max para todos). No es una prueba bit a bit, eso
+// lo hace fracref sweep: los lmites dejan margen sobre lo que se mide
+// hoy en vistas de borde (Q5.11 ~10%, Q4.27 ~2%, Q8.56 ~0%) y saltan si
+// un cambio en un ncleo le hace perder precisin de verdad.
+//
+// Compilar (desde la raz del proyecto):
+//   gcc -std=gnu99 -O2 -Wall -I. -o fkcheck host/fkcheck.c fractal_kernel.c
+//
+// Uso: fkcheck [-max %] [vistas_por_ncleo] [semilla]
+//   Por defecto 20 vistas por ncleo.
+
+#include "fractal_kernel.h"
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define CHK_W          132        // TFT_WIDTH
+#define CHK_H          162        // TFT_HEIGHT
+#define CHK_MAX_ZOOM   46         // FRACTAL_MAX_ZOOM
+#define CHK_SCALE_Q11  3072       // escala de la vista inicial, +/-1.5
+#define CHK_JULIA_C_RE (-1638)    // -0.8
+#define CHK_JULIA_C_IM 319        //  0.156
+#define CHK_CENTER_LIM ((int64_t)2 << FK_VIEW_FRAC)
+#define CHK_TRIES      1000       // centros probados por vista
+
+typedef long double real_t;
+
+static const char *const chk_names[FK_COUNT] = { "Q5.11", "Q4.27", "Q8.56" };
+
+// Porcentaje de pxeles distintos permitido por ncleo
+static double chk_limit[FK_COUNT] = { 25.0, 6.0, 0.1 };
+
+static int64_t chk_from_q11(int64_t v)
+{
+	return v * ((int64_t)1 << (FK_VIEW_FRAC - 11));
+}
+
+// Como FRACTAL_Scale: las dos vistas iniciales tienen la misma escala
+static int64_t chk_scale(uint8_t zoom)
+{
+	return chk_from_q11(CHK_SCALE_Q11) >> zoom;
+}
+
+static uint8_t chk_kernel_for(uint8_t zoom)
+{
+	return FK_Select((2 * chk_scale(zoom)) / (CHK_H - 1));
+}
+
+static uint64_t chk_rand(uint64_t *st)
+{
+	*st ^= *st << 13;
+	*st ^= *st >> 7;
+	*st ^= *st << 17;
+	return *st;
+}
+
+// El mismo bucle que los ncleos (corte en |Re|, |Im| >= 4 y escape con
+// |z|^2 > 4), en coma flotante. 'one' es 1.0 en unidades del ncleo.
+static uint8_t chk_orbit(int64_t zx0, int64_t zy0, int64_t cx0, int64_t cy0,
+                         real_t one, uint8_t max_iter)
+{
+	real_t zx = zx0 / one, zy = zy0 / one;
+	real_t cx = cx0 / one, cy = cy0 / one;
+	uint8_t iter = 0;
+
+	while (iter < max_iter) {
+		real_t nx = zx * zx - zy * zy + cx;
+		real_t ny = 2 * zx * zy + cy;
+
+		if (nx >= 4 || nx <= -4 || ny >= 4 || ny <= -4) break;
+
+		zx = nx;
+		zy = ny;
+		if (zx * zx + zy * zy > 4) break;
+
+		iter++;
+	}
+	return iter;
+}
+
+typedef struct {
+	uint8_t type;              // 0 Mandelbrot, 1 Julia
+	uint8_t zoom;
+	uint8_t max_iter;
+	int64_t center_re;         // Q8.56
+	int64_t center_im;
+} ChkView;
+
+typedef struct {
+	long     views, pixels, bad;
+	uint64_t err_sum;
+	unsigned err_max;
+	uint64_t iters;
+	double   secs;
+} ChkStats;
+
+// Pxel (x, y) de la vista como lo arma fractal.c: z0 y c en el formato
+static void chk_pixel(const ChkView *v, uint8_t k, int x, int y,
+                      int64_t *zx, int64_t *zy, int64_t *cx, int64_t *cy)
+{
+	int64_t scale = FK_FromView(k, chk_scale(v->zoom));
+	int64_t px = FK_FromView(k, v->center_re) - scale + (int64_t)x * ((2 * scale) / (CHK_W - 1));
+	int64_t py = FK_FromView(k, v->center_im) - scale + (int64_t)y * ((2 * scale) / (CHK_H - 1));
+
+	if (v->type == 0) {
+		*zx = 0;  *zy = 0;
+		*cx = px; *cy = py;
+	} else {
+		*zx = px; *zy = py;
+		*cx = FK_FromView(k, chk_from_q11(CHK_JULIA_C_RE));
+		*cy = FK_FromView(k, chk_from_q11(CHK_JULIA_C_IM));
+	}
+}
+
+// Centro al azar con el punto central cerca del borde: en el interior o
+// lejos del conjunto todos los pxeles salen iguales y no prueban nada
+static void chk_pick_view(ChkView *v, uint8_t k, uint8_t first, uint8_t count, uint64_t *st)
+{
+	v->type     = (uint8_t)(chk_rand(st) & 1);
+	v->zoom     = (uint8_t)(first + chk_rand(st) % count);
+	v->max_iter = (uint8_t)(64 + chk_rand(st) % 192);
+
+	for (int t = 0; t < CHK_TRIES; t++) {
+		int64_t zx, zy, cx, cy;
+
+		v->center_re = (int64_t)(chk_rand(st) % ((uint64_t)2 * CHK_CENTER_LIM + 1)) - CHK_CENTER_LIM;
+		v->center_im = (int64_t)(chk_rand(st) % ((uint64_t)2 * CHK_CENTER_LIM + 1)) - CHK_CENTER_LIM;
+
+		chk_pixel(v, k, CHK_W / 2, CHK_H / 2, &zx, &zy, &cx, &cy);
+		uint8_t it = chk_orbit(zx, zy, cx, cy, (real_t)((int64_t)1 << FK_FracBits(k)), v->max_iter);
+		if (it >= v->max_iter / 4 && it < v->max_iter) return;
+	}
+}
+
+static void chk_view(const ChkView *v, uint8_t k, ChkStats *s)
+{
+	static uint8_t got[CHK_W * CHK_H];
+	real_t one = (real_t)((int64_t)1 << FK_FracBits(k));
+	struct timespec t0, t1;
+	int64_t zx, zy, cx, cy;
+
+	clock_gettime(CLOCK_MONOTONIC, &t0);
+	for (int y = 0; y < CHK_H; y++) {
+		for (int x = 0; x < CHK_W; x++) {
+			chk_pixel(v, k, x, y, &zx, &zy, &cx, &cy);
+			got[y * CHK_W + x] = FK_Iterate(k, zx, zy, cx, cy, v->max_iter);
+		}
+	}
+	clock_gettime(CLOCK_MONOTONIC, &t1);
+	s->secs += (double)(t1.tv_sec - t0.tv_sec) + (t1.tv_nsec - t0.tv_nsec) / 1e9;
+
+	long bad = 0;
+	for (int y = 0; y < CHK_H; y++) {
+		for (int x = 0; x < CHK_W; x++) {
+			chk_pixel(v, k, x, y, &zx, &zy, &cx, &cy);
+			uint8_t want = chk_orbit(zx, zy, cx, cy, one, v->max_iter);
+			uint8_t have = got[y * CHK_W + x];
+
+			s->iters += have;
+			if (have == want) continue;
+
+			unsigned err = (have > want) ? have - want : want - have;
+			bad++;
+			s->err_sum += err;
+			if (err > s->err_max) s->err_max = err;
+		}
+	}
+
+	s->views++;
+	s->pixels += CHK_W * CHK_H;
+	s->bad    += bad;
+}
+
+int main(int argc, char **argv)
+{
+	long     views = 20;
+	uint64_t seed = 1;
+	int a = 1;
+
+	if (a + 1 < argc && !strcmp(argv[a], "-max")) {
+		for (uint8_t k = 0; k < FK_COUNT; k++) chk_limit[k] = atof(argv[a + 1]);
+		a += 2;
+	}
+	if (a < argc) views = atol(argv[a++]);
+	if (a < argc) seed  = strtoull(argv[a++], NULL, 0);
+	if (a != argc || views < 1) {
+		fprintf(stderr, "uso: %s [-max %%] [vistas_por_ncleo] [semilla]\n", argv[0]);
+		return 1;
+	}
+
+	// Zooms de cada ncleo
+	uint8_t first[FK_COUNT] = { 0 }, count[FK_COUNT] = { 0 };
+	for (uint8_t z = CHK_MAX_ZOOM + 1; z-- > 0; ) {
+		uint8_t k = chk_kernel_for(z);
+		if (k == FK_NONE) continue;
+		first[k] = z;
+		count[k]++;
+	}
+
+	uint64_t st = seed ? seed : 1;
+	int fail = 0;
+
+	printf("ncleo  zooms  vistas  distintos  error medio  error mx  Miter/s\n");
+	for (uint8_t k = 0; k < FK_COUNT; k++) {
+		ChkStats s;
+		memset(&s, 0, sizeof(s));
+
+		if (count[k] == 0) {
+			printf("%-6s  ningn zoom lo elige\n", chk_names[k]);
+			continue;
+		}
+
+		for (long n = 0; n < views; n++) {
+			ChkView v;
+			chk_pick_view(&v, k, first[k], count[k], &st);
+			chk_view(&v, k, &s);
+		}
+
+		double pct = 100.0 * s.bad / s.pixels;
+		printf("%-6s  %2u-%-2u  %6ld  %8.3f%%  %11.2f  %9u  %7.1f%s\n",
+		       chk_names[k], first[k], first[k] + count[k] - 1, s.views, pct,
+		       s.bad ? (double)s.err_sum / s.bad : 0.0, s.err_max,
+		       s.secs > 0 ? s.iters / s.secs / 1e6 : 0.0,
+		       pct > chk_limit[k] ? "  FALLA" : "");
+		if (pct > chk_limit[k]) fail = 1;
+	}
+
+	return fail;
+}
@@ -0,0 +1,758 @@
+// host/fracref.c - Render de referencia del fractal, bit a bit igual al firmware
+//
+// Vuelve a escribir, aparte de fractal.c y fractal_kernel.c, la rejilla
+// de la vista, los tres ncleos (Q5.11, Q4.27, Q8.56) y las dos paletas:
+// si un cambio en el firmware altera un solo pxel, la comparacin lo
+// encuentra. La pantalla se reparte en bandas de filas entre hilos, y los
+// ncleos de 16 y 32 bits iteran REF_LANES pxeles a la vez, sin saltos
+// por pxel, para que gcc los vectorice.
+//
+// Compilar (desde la raz del proyecto):
+//   gcc -std=gnu99 -O3 -march=native -Wall -pthread -I. -o fracref
+//       host/fracref.c fractal_kernel.c
+//
+// Uso:
+//   fracref [-j hilos] [-12] render TIPO OPS salida.ppm
+//       La vista a la que se llega desde la inicial con OPS (u d l r i o,
+//       '-' para ninguna), igual que 'sim -16 disco.img fractal TIPO OPS'.
+//       -12 recorta a RGB444 como FRACTAL_COLOR_MODE (sim sin -16).
+//   fracref [-j hilos] [-12] golden DIR
+//       Escribe los fotogramas de referencia de la tabla 'cases' en
+//       DIR/<nombre>.ppm y la lista en DIR/casos.txt.
+//   fracref diff a.ppm b.ppm
+//       Termina con 1 si difieren; dice cuntos pxeles y dnde.
+//   fracref [-j hilos] sweep VISTAS [semilla]
+//       Vistas al azar (ncleo, tipo, zoom, centro hasta el lmite de
+//       pan, max_iter 1..255): FK_Iterate y FK_Resume del firmware contra
+//       la referencia, pxel a pxel. Informa adems de cunto se aparta
+//       el ncleo elegido del de 64 bits (prdida de precisin). Termina
+//       con 1 si algn pxel no coincide.
+//
+// Comparar el firmware simulado con los fotogramas de referencia:
+//   ./fracref golden ref
+//   while read n t ops; do cp disco.img x.img;
+//       ./sim -16 x.img fractal $t $ops x.ppm 2>/dev/null;
+//       ./fracref diff ref/$n.ppm x.ppm || echo "FALLA $n"; done < ref/casos.txt
+//
+// Si el cambio es intencionado (otra paleta, otro ncleo), se regeneran
+// los fotogramas con la referencia cambiada igual.
+
+#include "fractal_kernel.h"
+
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#define REF_W          132        // TFT_WIDTH
+#define REF_H          162        // TFT_HEIGHT
+#define REF_LANES      8          // pxeles por lote
+#define REF_TILE_ROWS  6          // filas por banda de trabajo
+#define REF_MAX_JOBS   64
+
+// fractal.c: vistas iniciales (Q5.11), paso de pan y lmites
+#define REF_MANDEL     0
+#define REF_JULIA      1
+#define REF_PAN_STEP   16
+#define REF_MAX_ZOOM   46
+#define REF_MAX_ITER   120
+#define REF_SCALE_Q11  3072        // +/-1.5
+#define REF_MANDEL_RE  (-1536)     // -0.75
+#define REF_JULIA_C_RE (-1638)     // -0.8
+#define REF_JULIA_C_IM 319         //  0.156
+#define REF_VIEW_FRAC  56
+#define REF_CENTER_LIM ((int64_t)2 << REF_VIEW_FRAC)
+
+#define REF_Q5_11      0
+#define REF_Q4_27      1
+#define REF_Q8_56      2
+#define REF_NONE       0xFF
+
+static const uint8_t ref_frac[3] = { 11, 27, 56 };
+
+typedef struct {
+	uint8_t type;
+	uint8_t zoom;
+	uint8_t max_iter;
+	int64_t center_re;   // Q8.56
+	int64_t center_im;
+} RefView;
+
+// Esquina y paso en unidades del ncleo, como FractalGrid
+typedef struct {
+	int64_t re_min, im_min;
+	int64_t re_step, im_step;
+	int64_t jc_re, jc_im;      // c de Julia
+	uint8_t kernel;
+} RefGrid;
+
+// -----------------------------------------------------------------------------
+// Vista y rejilla
+// -----------------------------------------------------------------------------
+
+static int64_t ref_from_q11(int64_t v)
+{
+	return v * ((int64_t)1 << (REF_VIEW_FRAC - 11));
+}
+
+static int64_t ref_to_kernel(uint8_t k, int64_t v)
+{
+	return v >> (REF_VIEW_FRAC - ref_frac[k]);
+}
+
+static void ref_home(RefView *v, uint8_t type)
+{
+	v->type      = type;
+	v->zoom      = 0;
+	v->max_iter  = REF_MAX_ITER;
+	v->center_re = ref_from_q11(type == REF_MANDEL ? REF_MANDEL_RE : 0);
+	v->center_im = 0;
+}
+
+static uint8_t ref_kernel_for(uint8_t zoom)
+{
+	int64_t step = (2 * (ref_from_q11(REF_SCALE_Q11) >> zoom)) / (REF_H - 1);
+
+	for (uint8_t k = 0; k < 3; k++)
+		if ((step >> (REF_VIEW_FRAC - ref_frac[k])) >= 16)
+			return k;
+	return REF_NONE;
+}
+
+static void ref_grid(const RefView *v, RefGrid *g)
+{
+	uint8_t k     = ref_kernel_for(v->zoom);
+	int64_t scale = ref_to_kernel(k, ref_from_q11(REF_SCALE_Q11) >> v->zoom);
+
+	g->kernel  = k;
+	g->re_min  = ref_to_kernel(k, v->center_re) - scale;
+	g->im_min  = ref_to_kernel(k, v->center_im) - scale;
+	g->re_step = (2 * scale) / (REF_W - 1);
+	g->im_step = (2 * scale) / (REF_H - 1);
+	g->jc_re   = ref_to_kernel(k, ref_from_q11(REF_JULIA_C_RE));
+	g->jc_im   = ref_to_kernel(k, ref_from_q11(REF_JULIA_C_IM));
+}
+
+// Operaciones de host/sim_main.c sobre la vista (FRACTAL_Pan / FRACTAL_Zoom)
+static int ref_apply(RefView *v, char op)
+{
+	int dx = 0, dy = 0;
+
+	switch (op) {
+	case 'u': dy = -REF_PAN_STEP; break;
+	case 'd': dy =  REF_PAN_STEP; break;
+	case 'l': dx = -REF_PAN_STEP; break;
+	case 'r': dx =  REF_PAN_STEP; break;
+	case 'i':
+		if (v->zoom < REF_MAX_ZOOM && ref_kernel_for(v->zoom + 1) != REF_NONE) v->zoom++;
+		return 0;
+	case 'o':
+		if (v->zoom > 0) v->zoom--;
+		return 0;
+	default:
+		return -1;
+	}
+
+	RefGrid g;
+	ref_grid(v, &g);
+	int64_t unit = (int64_t)1 << (REF_VIEW_FRAC - ref_frac[g.kernel]);
+	int64_t re = v->center_re + g.re_step * dx * unit;
+	int64_t im = v->center_im + g.im_step * dy * unit;
+
+	if (re <= REF_CENTER_LIM && re >= -REF_CENTER_LIM &&
+	    im <= REF_CENTER_LIM && im >= -REF_CENTER_LIM) {
+		v->center_re = re;
+		v->center_im = im;
+	}
+	return 0;
+}
+
+// -----------------------------------------------------------------------------
+// Ncleos
+// -----------------------------------------------------------------------------
+// Misma regla en los tres: la vuelta cuenta si el z nuevo queda con
+// |Re| y |Im| < 4 y |z|^2 <= 4 (cuadrados truncados con >> aritmtico).
+// Un lote sigue mientras quede algn pxel vivo; los dems no cambian.
+
+static void ref_batch_q5_11(const int64_t *zx0, const int64_t *zy0,
+                            const int64_t *cx0, const int64_t *cy0,
+                            uint8_t max_iter, uint8_t *out)
+{
+	const int32_t bound = 4 << 11, escape2 = 4 << 11;
+	int32_t zx[REF_LANES], zy[REF_LANES], cx[REF_LANES], cy[REF_LANES];
+	int32_t zx2[REF_LANES], zy2[REF_LANES], it[REF_LANES], live[REF_LANES];
+
+	for (int l = 0; l < REF_LANES; l++) {
+		zx[l] = (int16_t)zx0[l];
+		zy[l] = (int16_t)zy0[l];
+		cx[l] = (int16_t)cx0[l];
+		cy[l] = (int16_t)cy0[l];
+		zx2[l] = (zx[l] * zx[l]) >> 11;
+		zy2[l] = (zy[l] * zy[l]) >> 11;
+		it[l] = 0;
+		live[l] = 1;
+	}
+
+	for (int n = 0; n < max_iter; n++) {
+		int32_t any = 0;
+		for (int l = 0; l < REF_LANES; l++) {
+			int32_t nx = zx2[l] - zy2[l] + cx[l];
+			int32_t ny = 2 * ((zx[l] * zy[l]) >> 11) + cy[l];
+			int32_t in = (nx < bound) & (nx > -bound) & (ny < bound) & (ny > -bound);
+			nx = in ? nx : 0;                      // sin desbordar el cuadrado
+			ny = in ? ny : 0;
+			int32_t nx2 = (nx * nx) >> 11;
+			int32_t ny2 = (ny * ny) >> 11;
+			int32_t ok = live[l] & in & (nx2 + ny2 <= escape2);
+
+			zx[l]  = ok ? nx  : zx[l];
+			zy[l]  = ok ? ny  : zy[l];
+			zx2[l] = ok ? nx2 : zx2[l];
+			zy2[l] = ok ? ny2 : zy2[l];
+			it[l] += ok;
+			live[l] = ok;
+			any |= ok;
+		}
+		if (!any) break;
+	}
+
+	for (int l = 0; l < REF_LANES; l++) out[l] = (uint8_t)it[l];
+}
+
+static void ref_batch_q4_27(const int64_t *zx0, const int64_t *zy0,
+                            const int64_t *cx0, const int64_t *cy0,
+                            uint8_t max_iter, uint8_t *out)
+{
+	const int64_t bound = (int64_t)4 << 27, escape2 = (int64_t)4 << 27;
+	int64_t zx[REF_LANES], zy[REF_LANES], cx[REF_LANES], cy[REF_LANES];
+	int64_t zx2[REF_LANES], zy2[REF_LANES], it[REF_LANES], live[REF_LANES];
+
+	for (int l = 0; l < REF_LANES; l++) {
+		zx[l] = (int32_t)zx0[l];
+		zy[l] = (int32_t)zy0[l];
+		cx[l] = (int32_t)cx0[l];
+		cy[l] = (int32_t)cy0[l];
+		zx2[l] = (zx[l] * zx[l]) >> 27;
+		zy2[l] = (zy[l] * zy[l]) >> 27;
+		it[l] = 0;
+		live[l] = 1;
+	}
+
+	for (int n = 0; n < max_iter; n++) {
+		int64_t any = 0;
+		for (int l = 0; l < REF_LANES; l++) {
+			int64_t nx = zx2[l] - zy2[l] + cx[l];
+			int64_t ny = 2 * ((zx[l] * zy[l]) >> 27) + cy[l];
+			int64_t in = (nx < bound) & (nx > -bound) & (ny < bound) & (ny > -bound);
+			nx = in ? nx : 0;
+			ny = in ? ny : 0;
+			int64_t nx2 = (nx * nx) >> 27;
+			int64_t ny2 = (ny * ny) >> 27;
+			int64_t ok = live[l] & in & (nx2 + ny2 <= escape2);
+
+			zx[l]  = ok ? nx  : zx[l];
+			zy[l]  = ok ? ny  : zy[l];
+			zx2[l] = ok ? nx2 : zx2[l];
+			zy2[l] = ok ? ny2 : zy2[l];
+			it[l] += ok;
+			live[l] = ok;
+			any |= ok;
+		}
+		if (!any) break;
+	}
+
+	for (int l = 0; l < REF_LANES; l++) out[l] = (uint8_t)it[l];
+}
+
+// Q8.56 con productos de 128 bits (suelo, igual que fk_mul64)
+static int64_t ref_mul56(int64_t a, int64_t b)
+{
+	return (int64_t)(((__int128)a * b) >> 56);
+}
+
+static void ref_batch_q8_56(const int64_t *zx0, const int64_t *zy0,
+                            const int64_t *cx, const int64_t *cy,
+                            uint8_t max_iter, uint8_t *out)
+{
+	const int64_t bound = (int64_t)4 << 56, escape2 = (int64_t)4 << 56;
+
+	for (int l = 0; l < REF_LANES; l++) {
+		int64_t zx = zx0[l], zy = zy0[l];
+		int64_t zx2 = ref_mul56(zx, zx), zy2 = ref_mul56(zy, zy);
+		uint8_t it = 0;
+
+		while (it < max_iter) {
+			int64_t nx = zx2 - zy2 + cx[l];
+			int64_t ny = 2 * ref_mul56(zx, zy) + cy[l];
+			if (nx >= bound || nx <= -bound || ny >= bound || ny <= -bound) break;
+			zx = nx;
+			zy = ny;
+			zx2 = ref_mul56(zx, zx);
+			zy2 = ref_mul56(zy, zy);
+			if (zx2 + zy2 > escape2) break;
+			it++;
+		}
+		out[l] = it;
+	}
+}
+
+typedef void (*RefBatch)(const int64_t *, const int64_t *, const int64_t *,
+                         const int64_t *, uint8_t, uint8_t *);
+
+static const RefBatch ref_batch[3] = { ref_batch_q5_11, ref_batch_q4_27, ref_batch_q8_56 };
+
+// z0 y c de REF_LANES pxeles seguidos de la fila py desde px0 (los que
+// se salen por la derecha repiten el ltimo)
+static void ref_lanes(const RefView *v, const RefGrid *g, int px0, int py,
+                      int64_t *zx, int64_t *zy, int64_t *cx, int64_t *cy)
+{
+	int64_t im = g->im_min + g->im_step * py;
+
+	for (int l = 0; l < REF_LANES; l++) {
+		int px = (px0 + l < REF_W) ? px0 + l : REF_W - 1;
+		int64_t re = g->re_min + g->re_step * px;
+
+		if (v->type == REF_MANDEL) {
+			zx[l] = 0;     zy[l] = 0;
+			cx[l] = re;    cy[l] = im;
+		} else {
+			zx[l] = re;    zy[l] = im;
+			cx[l] = g->jc_re; cy[l] = g->jc_im;
+		}
+	}
+}
+
+// -----------------------------------------------------------------------------
+// Paletas (color_from_iter_mandel / color_from_iter_julia de fractal.c)
+// -----------------------------------------------------------------------------
+
+static uint16_t ref_rgb565(unsigned r, unsigned g, unsigned b)
+{
+	return (uint16_t)(((r & 0xF8) << 8) | ((g & 0xFC) << 3) | ((b & 0xF8) >> 3));
+}
+
+static uint16_t ref_color_mandel(uint8_t iter, uint8_t max_iter)
+{
+	if (iter >= max_iter) return 0x0000;
+
+	unsigned t = (((unsigned)iter * 255 / max_iter) * 3) & 0xFF;
+
+	if (t < 85)  return ref_rgb565(0, (3 * t) & 0xFF, (128 + t * 127 / 85) & 0xFF);
+	if (t < 170) return ref_rgb565((3 * (t - 85)) & 0xFF, 255, (255 - 3 * (t - 85)) & 0xFF);
+	return ref_rgb565(255, 255, ((t - 170) * 3) & 0xFF);
+}
+
+static uint16_t ref_color_julia(uint8_t iter, uint8_t max_iter)
+{
+	if (iter >= max_iter) return 0x0000;
+
+	unsigned t = (unsigned)iter * 255 / max_iter;
+
+	if (t < 32)  return ref_rgb565(20, 0, (t * 8) & 0xFF);
+	if (t < 64)  return ref_rgb565((40 + (t - 32) * 3) & 0xFF, 0, 255);
+	if (t < 128) return ref_rgb565(((t - 64) * 4) & 0xFF, 0, (255 - (t - 64) * 4) & 0xFF);
+	if (t < 192) return ref_rgb565(255, ((t - 128) * 3) & 0xFF, 0);
+	return ref_rgb565(255, 255, ((t - 192) * 4) & 0xFF);
+}
+
+// RGB565 -> RGB444 (TFT_To444) -> RGB565 como lo guarda el ST7735 virtual
+static uint16_t ref_via_444(uint16_t c)
+{
+	unsigned r = c >> 12, g = (c >> 7) & 0x0F, b = (c >> 1) & 0x0F;
+	return (uint16_t)(((r << 1 | r >> 3) << 11) | ((g << 2 | g >> 2) << 5) | (b << 1 | b >> 3));
+}
+
+// -----------------------------------------------------------------------------
+// Reparto en hilos
+// -----------------------------------------------------------------------------
+
+static int ref_threads = 1;
+
+typedef struct {
+	void (*band)(void *ctx, int y0, int y1);
+	void *ctx;
+	int   next_row;
+} RefJob;
+
+static void *ref_worker(void *arg)
+{
+	RefJob *job = arg;
+
+	for (;;) {
+		int y0 = __atomic_fetch_add(&job->next_row, REF_TILE_ROWS, __ATOMIC_RELAXED);
+		if (y0 >= REF_H) return NULL;
+		job->band(job->ctx, y0, (y0 + REF_TILE_ROWS < REF_H) ? y0 + REF_TILE_ROWS : REF_H);
+	}
+}
+
+static void ref_parallel(void (*band)(void *, int, int), void *ctx)
+{
+	RefJob job = { band, ctx, 0 };
+	pthread_t th[REF_MAX_JOBS];
+	int n = 0;
+
+	for (; n < ref_threads - 1; n++)
+		if (pthread_create(&th[n], NULL, ref_worker, &job) != 0) break;
+	ref_worker(&job);
+	while (n > 0) pthread_join(th[--n], NULL);
+}
+
+// -----------------------------------------------------------------------------
+// Plano de iteraciones y fotograma
+// -----------------------------------------------------------------------------
+
+typedef struct {
+	const RefView *v;
+	RefGrid        g;
+	uint8_t        kernel;     // normalmente g.kernel; sweep fuerza Q8.56
+	uint8_t       *iter;       // REF_W x REF_H
+} RefPlane;
+
+static void ref_plane_band(void *ctx, int y0, int y1)
+{
+	RefPlane *p = ctx;
+	int64_t zx[REF_LANES], zy[REF_LANES], cx[REF_LANES], cy[REF_LANES];
+	uint8_t it[REF_LANES];
+
+	for (int y = y0; y < y1; y++) {
+		for (int x = 0; x < REF_W; x += REF_LANES) {
+			ref_lanes(p->v, &p->g, x, y, zx, zy, cx, cy);
+
+			// Rejilla de otro ncleo: las mismas coordenadas, en Q8.56
+			if (p->kernel != p->g.kernel) {
+				int s = REF_VIEW_FRAC - ref_frac[p->g.kernel];
+				for (int l = 0; l < REF_LANES; l++) {
+					zx[l] *= (int64_t)1 << s;  zy[l] *= (int64_t)1 << s;
+					cx[l] *= (int64_t)1 << s;  cy[l] *= (int64_t)1 << s;
+				}
+			}
+
+			ref_batch[p->kernel](zx, zy, cx, cy, p->v->max_iter, it);
+			for (int l = 0; l < REF_LANES && x + l < REF_W; l++)
+				p->iter[y * REF_W + x + l] = it[l];
+		}
+	}
+}
+
+static void ref_plane(const RefView *v, uint8_t *iter)
+{
+	RefPlane p = { v, { 0 }, 0, iter };
+	ref_grid(v, &p.g);
+	p.kernel = p.g.kernel;
+	ref_parallel(ref_plane_band, &p);
+}
+
+static int ref_write_ppm(const char *path, const RefView *v, int c12)
+{
+	static uint8_t iter[REF_W * REF_H];
+	ref_plane(v, iter);
+
+	FILE *f = fopen(path, "wb");
+	if (!f) { perror(path); return -1; }
+
+	// Misma conversin que SIM_DumpPPM
+	fprintf(f, "P6\n%d %d\n255\n", REF_W, REF_H);
+	for (int i = 0; i < REF_W * REF_H; i++) {
+		uint16_t c = (v->type == REF_MANDEL) ? ref_color_mandel(iter[i], v->max_iter)
+		                                     : ref_color_julia(iter[i], v->max_iter);
+		if (c12) c = ref_via_444(c);
+
+		uint8_t rgb[3] = {
+			(uint8_t)(((c >> 11) & 0x1F) * 255 / 31),
+			(uint8_t)(((c >> 5) & 0x3F) * 255 / 63),
+			(uint8_t)((c & 0x1F) * 255 / 31)
+		};
+		fwrite(rgb, 1, 3, f);
+	}
+	return fclose(f);
+}
+
+static int ref_view_from_ops(RefView *v, const char *type, const char *ops)
+{
+	ref_home(v, (uint8_t)atoi(type));
+	for (; *ops && *ops != '-'; ops++) {
+		if (ref_apply(v, *ops) != 0) {
+			fprintf(stderr, "operacin desconocida: %c\n", *ops);
+			return -1;
+		}
+	}
+	return 0;
+}
+
+// -----------------------------------------------------------------------------
+// golden / diff
+// -----------------------------------------------------------------------------
+
+// Cada ncleo, con pan vertical (scroll por hardware, solo filas nuevas)
+// y horizontal (vista completa)
+static const struct {
+	const char *name;
+	const char *type;
+	const char *ops;
+} cases[] = {
+	{ "mandel",          "0", "-" },
+	{ "julia",           "1", "-" },
+	{ "mandel_pan",      "0", "uurdd" },
+	{ "julia_pan",       "1", "ddl" },
+	{ "mandel_q4_27",    "0", "iiii" },
+	{ "mandel_q4_27_pan","0", "iiiiluu" },
+	{ "julia_q4_27",     "1", "iiirru" },
+	{ "mandel_q8_56",    "0", "iiiiiiiiiiiiiiiiiiii" },
+	{ "julia_q8_56",     "1", "rriiiiiiiiiiiiiiiiiiiiid" },
+	{ "mandel_deep",     "0", "iiiiiiiiiiiiiiiiiiiiiiiiiiiiiiiiiiiiiiiiiiiiiiii" },
+	{ "mandel_out",      "0", "iiioooo" },
+	{ "mandel_edge",     "0", "llllllllllllllllllllllll" },
+};
+#define CASES  (sizeof(cases) / sizeof(cases[0]))
+
+static int ref_golden(const char *dir, int c12)
+{
+	char path[512];
+
+	mkdir(dir, 0777);
+	snprintf(path, sizeof path, "%s/casos.txt", dir);
+	FILE *list = fopen(path, "w");
+	if (!list) { perror(path); return 1; }
+
+	for (unsigned i = 0; i < CASES; i++) {
+		RefView v;
+		if (ref_view_from_ops(&v, cases[i].type, cases[i].ops) != 0) return 1;
+
+		snprintf(path, sizeof path, "%s/%s.ppm", dir, cases[i].name);
+		if (ref_write_ppm(path, &v, c12) != 0) return 1;
+		fprintf(list, "%s %s %s\n", cases[i].name, cases[i].type, cases[i].ops);
+		printf("%-18s zoom %2u ncleo %u\n", cases[i].name, v.zoom, ref_kernel_for(v.zoom));
+	}
+	return fclose(list) != 0;
+}
+
+static uint8_t *ref_read_ppm(const char *path, int *w, int *h)
+{
+	FILE *f = fopen(path, "rb");
+	if (!f) { perror(path); return NULL; }
+
+	int max;
+	uint8_t *px = NULL;
+	if (fscanf(f, "P6 %d %d %d", w, h, &max) == 3 && max == 255 && fgetc(f) != EOF &&
+	    *w > 0 && *h > 0 && (px = malloc((size_t)*w * *h * 3)) &&
+	    fread(px, 3, (size_t)*w * *h, f) != (size_t)*w * *h) {
+		free(px);
+		px = NULL;
+	}
+	if (!px) fprintf(stderr, "%s: no es un PPM P6 de 8 bits\n", path);
+	fclose(f);
+	return px;
+}
+
+static int ref_diff(const char *pa, const char *pb)
+{
+	int wa, ha, wb, hb;
+	uint8_t *a = ref_read_ppm(pa, &wa, &ha);
+	uint8_t *b = ref_read_ppm(pb, &wb, &hb);
+
+	if (!a || !b) return 2;
+	if (wa != wb || ha != hb) {
+		printf("%s %dx%d, %s %dx%d\n", pa, wa, ha, pb, wb, hb);
+		return 1;
+	}
+
+	long n = 0;
+	int x0 = wa, y0 = ha, x1 = -1, y1 = -1;
+	for (int y = 0; y < ha; y++) {
+		for (int x = 0; x < wa; x++) {
+			size_t i = ((size_t)y * wa + x) * 3;
+			if (!memcmp(a + i, b + i, 3)) continue;
+			if (n++ == 0)
+				printf("primer pxel distinto (%d,%d): %02X%02X%02X / %02X%02X%02X\n",
+				       x, y, a[i], a[i + 1], a[i + 2], b[i], b[i + 1], b[i + 2]);
+			if (x < x0) x0 = x;
+			if (x > x1) x1 = x;
+			if (y < y0) y0 = y;
+			if (y > y1) y1 = y;
+		}
+	}
+	if (n) printf("%ld pxeles distintos en (%d,%d)-(%d,%d)\n", n, x0, y0, x1, y1);
+
+	free(a);
+	free(b);
+	return n != 0;
+}
+
+// -----------------------------------------------------------------------------
+// sweep
+// -----------------------------------------------------------------------------
+
+typedef struct {
+	const RefView *v;
+	RefGrid        g;
+	const uint8_t *ref;        // referencia con el ncleo de la vista
+	long           iterate_bad, resume_bad;
+	pthread_mutex_t lock;
+} RefSweep;
+
+// El firmware (fractal_kernel.c) sobre las mismas z0 y c
+static void ref_sweep_band(void *ctx, int y0, int y1)
+{
+	RefSweep *s = ctx;
+	int64_t zx[REF_LANES], zy[REF_LANES], cx[REF_LANES], cy[REF_LANES];
+	long it_bad = 0, rs_bad = 0;
+	uint8_t max = s->v->max_iter, split = max / 2;
+
+	for (int y = y0; y < y1; y++) {
+		for (int x = 0; x < REF_W; x += REF_LANES) {
+			ref_lanes(s->v, &s->g, x, y, zx, zy, cx, cy);
+
+			for (int l = 0; l < REF_LANES && x + l < REF_W; l++) {
+				uint8_t want = s->ref[y * REF_W + x + l];
+				uint8_t k = s->g.kernel;
+
+				if (FK_Iterate(k, zx[l], zy[l], cx[l], cy[l], max) != want) it_bad++;
+
+				// Como el render progresivo: parar en 'split' y reanudar
+				int64_t rx = zx[l], ry = zy[l];
+				uint8_t it = FK_Resume(k, &rx, &ry, cx[l], cy[l], 0, split);
+				if (it == split) it = FK_Resume(k, &rx, &ry, cx[l], cy[l], split, max);
+				if (it != want) rs_bad++;
+			}
+		}
+	}
+
+	pthread_mutex_lock(&s->lock);
+	s->iterate_bad += it_bad;
+	s->resume_bad  += rs_bad;
+	pthread_mutex_unlock(&s->lock);
+}
+
+static uint64_t ref_rand(uint64_t *st)
+{
+	*st ^= *st << 13;
+	*st ^= *st >> 7;
+	*st ^= *st << 17;
+	return *st;
+}
+
+static int ref_sweep(long views, uint64_t seed)
+{
+	static uint8_t ref[REF_W * REF_H], deep[REF_W * REF_H];
+	uint64_t st = seed ? seed : 1;
+	long bad_views = 0, pixels = 0;
+	double worst = 0, lost[3] = { 0 };
+	long per_kernel[3] = { 0 };
+	struct timespec t0, t1;
+
+	clock_gettime(CLOCK_MONOTONIC, &t0);
+
+	// Zooms de cada ncleo: se elige antes el ncleo, si no casi todas
+	// las vistas seran de 64 bits
+	uint8_t first[3] = { 0 }, count[3] = { 0 };
+	for (uint8_t z = REF_MAX_ZOOM + 1; z-- > 0; ) {
+		uint8_t k = ref_kernel_for(z);
+		if (k == REF_NONE) continue;
+		first[k] = z;
+		count[k]++;
+	}
+
+	for (long n = 0; n < views; n++) {
+		RefView v;
+		uint8_t k = (uint8_t)(ref_rand(&st) % 3);
+
+		v.type      = (uint8_t)(ref_rand(&st) & 1);
+		v.zoom      = (uint8_t)(first[k] + ref_rand(&st) % count[k]);
+		v.max_iter  = (uint8_t)(1 + ref_rand(&st) % 255);
+		// Centro en [-2, 2] con todos los bits de Q8.56
+		v.center_re = (int64_t)(ref_rand(&st) % ((uint64_t)2 * REF_CENTER_LIM + 1)) - REF_CENTER_LIM;
+		v.center_im = (int64_t)(ref_rand(&st) % ((uint64_t)2 * REF_CENTER_LIM + 1)) - REF_CENTER_LIM;
+
+		RefSweep s = { &v, { 0 }, ref, 0, 0, PTHREAD_MUTEX_INITIALIZER };
+		ref_grid(&v, &s.g);
+
+		RefPlane p = { &v, s.g, s.g.kernel, ref };
+		ref_parallel(ref_plane_band, &p);
+		ref_parallel(ref_sweep_band, &s);
+
+		if (s.iterate_bad || s.resume_bad) {
+			if (bad_views++ < 10)
+				printf("FALLA tipo %u zoom %u iter %u centro %lld %lld: "
+				       "FK_Iterate %ld, FK_Resume %ld pxeles\n",
+				       v.type, v.zoom, v.max_iter, (long long)v.center_re,
+				       (long long)v.center_im, s.iterate_bad, s.resume_bad);
+		}
+
+		// Precisin: el mismo plano con el ncleo de 64 bits
+		long diff = 0;
+		if (s.g.kernel != REF_Q8_56) {
+			p.kernel = REF_Q8_56;
+			p.iter   = deep;
+			ref_parallel(ref_plane_band, &p);
+			for (int i = 0; i < REF_W * REF_H; i++) diff += (ref[i] != deep[i]);
+		}
+		double pct = 100.0 * diff / (REF_W * REF_H);
+		lost[s.g.kernel] += pct;
+		per_kernel[s.g.kernel]++;
+		if (pct > worst) worst = pct;
+		pixels += REF_W * REF_H;
+	}
+
+	clock_gettime(CLOCK_MONOTONIC, &t1);
+	double secs = (double)(t1.tv_sec - t0.tv_sec) + (t1.tv_nsec - t0.tv_nsec) / 1e9;
+
+	printf("%ld vistas, %ld pxeles, %d hilos, %.1f s (%.2f Mpxel/s)\n",
+	       views, pixels, ref_threads, secs, secs > 0 ? pixels / secs / 1e6 : 0.0);
+	for (int k = 0; k < 3; k++)
+		if (per_kernel[k])
+			printf("  ncleo %-5s %6ld vistas, distinto del de 64 bits: %.2f%% de media\n",
+			       k == REF_Q5_11 ? "Q5.11" : k == REF_Q4_27 ? "Q4.27" : "Q8.56",
+			       per_kernel[k], lost[k] / per_kernel[k]);
+	printf("  peor vista: %.2f%%; vistas con fallos: %ld\n", worst, bad_views);
+
+	return bad_views != 0;
+}
+
+// -----------------------------------------------------------------------------
+
+static int usage(const char *argv0)
+{
+	fprintf(stderr, "uso: %s [-j hilos] [-12] render TIPO OPS salida.ppm\n"
+	                "     %s [-j hilos] [-12] golden DIR\n"
+	                "     %s diff a.ppm b.ppm\n"
+	                "     %s [-j hilos] sweep VISTAS [semilla]\n",
+	        argv0, argv0, argv0, argv0);
+	return 2;
+}
+
+int main(int argc, char **argv)
+{
+	int c12 = 0;
+	int a = 1;
+
+	ref_threads = (int)sysconf(_SC_NPROCESSORS_ONLN);
+	for (; a < argc && argv[a][0] == '-'; a++) {
+		if (!strcmp(argv[a], "-12")) c12 = 1;
+		else if (!strcmp(argv[a], "-j") && a + 1 < argc) ref_threads = atoi(argv[++a]);
+		else return usage(argv[0]);
+	}
+	if (ref_threads < 1) ref_threads = 1;
+	if (ref_threads > REF_MAX_JOBS) ref_threads = REF_MAX_JOBS;
+	if (a >= argc) return usage(argv[0]);
+
+	const char *cmd = argv[a];
+	int n = argc - a - 1;
+
+	if (!strcmp(cmd, "render") && n == 3) {
+		RefView v;
+		if (ref_view_from_ops(&v, argv[a + 1], argv[a + 2]) != 0) return 2;
+		return ref_write_ppm(argv[a + 3], &v, c12) != 0;
+	}
+	if (!strcmp(cmd, "golden") && n == 1)
+		return ref_golden(argv[a + 1], c12);
+	if (!strcmp(cmd, "diff") && n == 2)
+		return ref_diff(argv[a + 1], argv[a + 2]);
+	if (!strcmp(cmd, "sweep") && (n == 1 || n == 2))
+		return ref_sweep(atol(argv[a + 1]), n == 2 ? strtoull(argv[a + 2], NULL, 0) : 1);
+
+	return usage(argv[0]);
+}
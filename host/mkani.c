@@ -0,0 +1,342 @@
+// host/mkani.c - Genera una animacin .ANI (ver anim.h) a partir de BMPs
+//
+// Uso: mkani [-fps N] [-rect X,Y,W,H] [-delta] salida.ani cuadro.bmp [...]
+//      mkani [...] salida.ani directorio
+//   Cada BMP (24 bits) es un fotograma, en el orden dado; con un
+//   directorio, sus .bmp por orden alfabtico.
+//   -fps   fotogramas por segundo objetivo (por defecto 15; 0 = sin lmite)
+//   -rect  recorta ese rectngulo de cada BMP (origen arriba a la izquierda)
+//          y lo coloca en la misma posicin de la pantalla. Sin -rect se
+//          usa el BMP entero, centrado.
+//   -delta solo las teselas de 8x8 que cambian de un fotograma al
+//          siguiente (tipo DELTA); sin l, fotogramas enteros (RAW).
+//
+// Compilar: gcc -O2 -o mkani host/mkani.c
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <dirent.h>
+#include <sys/stat.h>
+
+#define SCREEN_W 132
+#define SCREEN_H 162
+#define BPS      512
+#define TILE     8
+#define SOLID    0x8000
+
+static void put16(uint8_t *p, uint16_t v) { p[0] = (uint8_t)v; p[1] = (uint8_t)(v >> 8); }
+static uint32_t get32(const uint8_t *p) { return p[0] | p[1] << 8 | p[2] << 16 | (uint32_t)p[3] << 24; }
+
+typedef struct {
+	int      w, h;
+	uint8_t *rgb;      // w*h*3, fila 0 arriba
+} Image;
+
+static int load_bmp(const char *path, Image *img)
+{
+	FILE *f = fopen(path, "rb");
+	if (!f) { perror(path); return -1; }
+
+	uint8_t hdr[54];
+	if (fread(hdr, 1, 54, f) != 54 || hdr[0] != 'B' || hdr[1] != 'M' ||
+	    (hdr[28] | hdr[29] << 8) != 24) {
+		fprintf(stderr, "%s: no es un BMP de 24 bits\n", path);
+		fclose(f);
+		return -1;
+	}
+
+	uint32_t off = get32(&hdr[10]);
+	int32_t  w = (int32_t)get32(&hdr[18]);
+	int32_t  h = (int32_t)get32(&hdr[22]);
+	int      bottom_up = h > 0;
+	if (h < 0) h = -h;
+
+	uint32_t stride = ((uint32_t)w * 3 + 3) & ~3u;
+	uint8_t *row = malloc(stride);
+	img->w = w;
+	img->h = h;
+	img->rgb = malloc((size_t)w * h * 3);
+
+	for (int y = 0; y < h; y++) {
+		int src = bottom_up ? h - 1 - y : y;
+		fseek(f, (long)(off + (uint32_t)src * stride), SEEK_SET);
+		if (fread(row, 1, stride, f) != stride) memset(row, 0, stride);
+		for (int x = 0; x < w; x++) {
+			uint8_t *d = &img->rgb[((size_t)y * w + x) * 3];
+			d[0] = row[x * 3 + 2];
+			d[1] = row[x * 3 + 1];
+			d[2] = row[x * 3 + 0];
+		}
+	}
+
+	free(row);
+	fclose(f);
+	return 0;
+}
+
+// Los .bmp de un directorio, por orden alfabtico
+static int cmp_name(const void *a, const void *b)
+{
+	return strcmp(*(char *const *)a, *(char *const *)b);
+}
+
+static char **list_dir(const char *dir, int *count)
+{
+	DIR *d = opendir(dir);
+	if (!d) { perror(dir); return NULL; }
+
+	char **names = NULL;
+	int n = 0;
+	struct dirent *e;
+	while ((e = readdir(d)) != NULL) {
+		size_t len = strlen(e->d_name);
+		if (len < 5 || strcasecmp(e->d_name + len - 4, ".bmp") != 0) continue;
+		names = realloc(names, (n + 1) * sizeof *names);
+		names[n] = malloc(strlen(dir) + len + 2);
+		sprintf(names[n], "%s/%s", dir, e->d_name);
+		n++;
+	}
+	closedir(d);
+
+	qsort(names, n, sizeof *names, cmp_name);
+	*count = n;
+	return names;
+}
+
+/* ---------- DELTA ---------- */
+
+typedef struct {
+	uint8_t *p;
+	size_t   len, cap;
+} Buf;
+
+static void buf_put8(Buf *b, uint8_t v)
+{
+	if (b->len == b->cap) {
+		b->cap = b->cap ? b->cap * 2 : 4096;
+		b->p = realloc(b->p, b->cap);
+	}
+	b->p[b->len++] = v;
+}
+
+static void buf_put16(Buf *b, uint16_t v)   // MSB primero, como los pxeles
+{
+	buf_put8(b, (uint8_t)(v >> 8));
+	buf_put8(b, (uint8_t)v);
+}
+
+// Tesela (tx, ty) de un fotograma w x h: tamao recortado al borde
+static void tile_size(int w, int h, int tx, int ty, int *tw, int *th)
+{
+	*tw = (w - tx * TILE < TILE) ? w - tx * TILE : TILE;
+	*th = (h - ty * TILE < TILE) ? h - ty * TILE : TILE;
+}
+
+static int tile_changed(const uint16_t *prev, const uint16_t *cur, int w, int h, int tx, int ty)
+{
+	if (!prev) return 1;
+
+	int tw, th;
+	tile_size(w, h, tx, ty, &tw, &th);
+	for (int y = 0; y < th; y++) {
+		size_t o = (size_t)(ty * TILE + y) * w + tx * TILE;
+		if (memcmp(&prev[o], &cur[o], tw * sizeof *cur) != 0) return 1;
+	}
+	return 0;
+}
+
+// 1 si toda la tesela es de un color (y lo devuelve en *c)
+static int tile_solid(const uint16_t *cur, int w, int h, int tx, int ty, uint16_t *c)
+{
+	int tw, th;
+	tile_size(w, h, tx, ty, &tw, &th);
+	*c = cur[(size_t)ty * TILE * w + tx * TILE];
+	for (int y = 0; y < th; y++)
+		for (int x = 0; x < tw; x++)
+			if (cur[(size_t)(ty * TILE + y) * w + tx * TILE + x] != *c) return 0;
+	return 1;
+}
+
+// Un fotograma DELTA (sin rellenar a sector); prev == NULL: todas las teselas
+static void encode_delta(const uint16_t *prev, const uint16_t *cur, int w, int h, Buf *b)
+{
+	int ntx = (w + TILE - 1) / TILE;
+	int nty = (h + TILE - 1) / TILE;
+	int map_len = (ntx * nty + 7) / 8;
+	uint8_t *dirty = calloc(ntx * nty, 1);
+
+	for (int ty = 0; ty < nty; ty++)
+		for (int tx = 0; tx < ntx; tx++)
+			dirty[ty * ntx + tx] = (uint8_t)tile_changed(prev, cur, w, h, tx, ty);
+
+	for (int i = 0; i < (map_len + 1) / 2 * 2; i++) {
+		uint8_t m = 0;
+		for (int k = 0; k < 8; k++)
+			if (i * 8 + k < ntx * nty && dirty[i * 8 + k]) m |= (uint8_t)(1 << k);
+		buf_put8(b, m);
+	}
+
+	for (int ty = 0; ty < nty; ty++) {
+		int th, tw;
+		tile_size(w, h, 0, ty, &tw, &th);
+
+		for (int tx = 0; tx < ntx; ) {
+			if (!dirty[ty * ntx + tx]) { tx++; continue; }
+
+			int end = tx + 1;
+			while (end < ntx && dirty[ty * ntx + end]) end++;
+
+			// Segmentos: teselas slidas del mismo color juntas, el resto en crudo
+			while (tx < end) {
+				uint16_t c, c2;
+				int n = 1;
+				if (tile_solid(cur, w, h, tx, ty, &c)) {
+					while (tx + n < end && tile_solid(cur, w, h, tx + n, ty, &c2) && c2 == c) n++;
+					buf_put16(b, (uint16_t)(SOLID | n));
+					buf_put16(b, c);
+				} else {
+					while (tx + n < end && !tile_solid(cur, w, h, tx + n, ty, &c2)) n++;
+					buf_put16(b, (uint16_t)n);
+					int x0 = tx * TILE;
+					int sw = (x0 + n * TILE > w) ? w - x0 : n * TILE;
+					for (int y = 0; y < th; y++)
+						for (int x = 0; x < sw; x++)
+							buf_put16(b, cur[(size_t)(ty * TILE + y) * w + x0 + x]);
+				}
+				tx += n;
+			}
+		}
+	}
+	free(dirty);
+}
+
+int main(int argc, char **argv)
+{
+	int fps = 15;
+	int delta = 0;
+	int rx = -1, ry = 0, rw = 0, rh = 0;
+	int a = 1;
+
+	for (; a < argc && argv[a][0] == '-'; a++) {
+		if (!strcmp(argv[a], "-fps") && a + 1 < argc) {
+			fps = atoi(argv[++a]);
+		} else if (!strcmp(argv[a], "-rect") && a + 1 < argc) {
+			if (sscanf(argv[++a], "%d,%d,%d,%d", &rx, &ry, &rw, &rh) != 4) rx = -2;
+		} else if (!strcmp(argv[a], "-delta")) {
+			delta = 1;
+		} else {
+			rx = -2;
+			break;
+		}
+	}
+
+	if (rx == -2 || argc - a < 2 || fps < 0 || fps > 255) {
+		fprintf(stderr, "uso: %s [-fps N] [-rect X,Y,W,H] [-delta] salida.ani cuadro.bmp [...] | directorio\n", argv[0]);
+		return 1;
+	}
+
+	const char *out = argv[a++];
+	int frames = argc - a;
+	char **names = &argv[a];
+
+	struct stat st;
+	if (frames == 1 && stat(names[0], &st) == 0 && S_ISDIR(st.st_mode)) {
+		names = list_dir(names[0], &frames);
+		if (!names || frames == 0) {
+			fprintf(stderr, "%s: no hay BMPs\n", argv[a]);
+			return 1;
+		}
+	}
+
+	FILE *fo = fopen(out, "wb");
+	if (!fo) { perror(out); return 1; }
+
+	int x0 = 0, y0 = 0, w = 0, h = 0, sx = 0, sy = 0;
+	uint32_t frame_sectors = 0, total_sectors = 0;
+	uint8_t  hdr[BPS] = { 'A', 'N', 'I', '1' };
+	uint16_t *cur = NULL, *prev = NULL;
+	Buf b = { 0 };
+
+	for (int i = 0; i < frames; i++) {
+		Image img;
+		if (load_bmp(names[i], &img) != 0) return 1;
+
+		if (i == 0) {
+			if (rx >= 0) {
+				x0 = sx = rx; y0 = sy = ry; w = rw; h = rh;
+			} else {
+				w = img.w; h = img.h;
+				x0 = (SCREEN_W - w) / 2;
+				y0 = (SCREEN_H - h) / 2;
+			}
+			if (w <= 0 || h <= 0 || x0 < 0 || y0 < 0 ||
+			    x0 + w > SCREEN_W || y0 + h > SCREEN_H) {
+				fprintf(stderr, "el fotograma no cabe en %dx%d\n", SCREEN_W, SCREEN_H);
+				return 1;
+			}
+
+			cur  = malloc((size_t)w * h * sizeof *cur);
+			prev = malloc((size_t)w * h * sizeof *prev);
+			if (!delta) frame_sectors = ((uint32_t)w * h * 2 + BPS - 1) / BPS;
+
+			// La cabecera se completa al final (en DELTA falta el mximo)
+			fwrite(hdr, 1, BPS, fo);
+		}
+
+		if (sx + w > img.w || sy + h > img.h) {
+			fprintf(stderr, "%s: ms pequeo que el primer fotograma\n", names[i]);
+			return 1;
+		}
+
+		// RGB565, fila a fila
+		for (int y = 0; y < h; y++) {
+			for (int x = 0; x < w; x++) {
+				const uint8_t *p = &img.rgb[((size_t)(sy + y) * img.w + sx + x) * 3];
+				cur[y * w + x] = (uint16_t)((p[0] & 0xF8) << 8 | (p[1] & 0xFC) << 3 | p[2] >> 3);
+			}
+		}
+		free(img.rgb);
+
+		b.len = 0;
+		if (delta) {
+			encode_delta(i ? prev : NULL, cur, w, h, &b);
+		} else {
+			for (int k = 0; k < w * h; k++) buf_put16(&b, cur[k]);
+		}
+
+		// Cada fotograma empieza en sector nuevo
+		while (b.len % BPS) buf_put8(&b, 0);
+		fwrite(b.p, 1, b.len, fo);
+
+		uint32_t sectors = (uint32_t)(b.len / BPS);
+		if (sectors > frame_sectors) frame_sectors = sectors;
+		total_sectors += sectors;
+
+		uint16_t *t = prev; prev = cur; cur = t;
+	}
+
+	put16(&hdr[4], (uint16_t)w);
+	put16(&hdr[6], (uint16_t)h);
+	hdr[8] = (uint8_t)x0;
+	hdr[9] = (uint8_t)y0;
+	put16(&hdr[10], (uint16_t)frames);
+	hdr[12] = (uint8_t)fps;
+	hdr[13] = (uint8_t)delta;          // ANIM_KIND_RAW / ANIM_KIND_DELTA
+	put16(&hdr[14], (uint16_t)frame_sectors);
+	fseek(fo, 0, SEEK_SET);
+	fwrite(hdr, 1, BPS, fo);
+
+	free(b.p);
+	free(cur);
+	free(prev);
+	if (fclose(fo) != 0) { perror(out); return 1; }
+
+	uint32_t raw = (uint32_t)frames * (((uint32_t)w * h * 2 + BPS - 1) / BPS);
+	printf("%s: %d fotogramas %s de %dx%d en (%d,%d), %d fps, %u sectores (%u%% de RAW)\n",
+	       out, frames, delta ? "DELTA" : "RAW", w, h, x0, y0, fps,
+	       (unsigned)total_sectors, (unsigned)(total_sectors * 100 / raw));
+	return 0;
+}
@@ -0,0 +1,237 @@
+// host/mkimg.c - Genera una imagen FAT16 o FAT32 para el simulador
+//
+// Uso: mkimg [-fat32] [-mbr] salida.img tam_MB ARCHIVO [ARCHIVO ...]
+//   ARCHIVO puede ser una ruta del PC (se copia con su nombre 8.3)
+//   o NOMBRE.EXT:bytes para reservar un archivo lleno de ceros
+//   (p.ej. FRACTAL.CAC:435200 para la cach de fotogramas).
+//   -fat32  FAT32 (hace falta tam_MB >= 34): root como cadena de
+//           clsteres (el primero delante de los archivos, el resto
+//           detrs, para que no sea contiguo) y sector FSInfo.
+//   -mbr    tabla de particiones con una particin en el sector 2048,
+//           como viene formateada una tarjeta SDHC; sin l, el volumen
+//           empieza en el sector 0 ("superfloppy").
+//
+// Los archivos se colocan en clsteres contiguos, como asume fat_fs.c.
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+
+#define BPS          512
+#define ROOT_ENTRIES 512          // FAT16: root fijo
+#define NUM_FATS     2
+#define PART_START   2048         // con -mbr
+
+static void put16(uint8_t *p, uint16_t v) { p[0] = (uint8_t)v; p[1] = (uint8_t)(v >> 8); }
+static void put32(uint8_t *p, uint32_t v) { put16(p, (uint16_t)v); put16(p + 2, (uint16_t)(v >> 16)); }
+
+static void make_name83(const char *path, uint8_t out[11])
+{
+	const char *base = strrchr(path, '/');
+	base = base ? base + 1 : path;
+
+	memset(out, ' ', 11);
+	int j = 0, ext = 0;
+	for (int i = 0; base[i] && base[i] != ':'; i++) {
+		if (base[i] == '.') { j = 8; ext = 1; continue; }
+		if ((!ext && j < 8) || (ext && j < 11))
+			out[j++] = (uint8_t)toupper((unsigned char)base[i]);
+	}
+}
+
+static int      fat32;
+static uint8_t *fat;
+
+static void set_fat(uint32_t cluster, uint32_t next)
+{
+	if (fat32) put32(fat + cluster * 4, next);
+	else       put16(fat + cluster * 2, (uint16_t)next);
+}
+
+int main(int argc, char **argv)
+{
+	int mbr = 0;
+	int a = 1;
+
+	for (; a < argc && argv[a][0] == '-'; a++) {
+		if (!strcmp(argv[a], "-fat32"))    fat32 = 1;
+		else if (!strcmp(argv[a], "-mbr")) mbr = 1;
+		else break;
+	}
+
+	if (argc - a < 2 || argv[a][0] == '-') {
+		fprintf(stderr, "uso: %s [-fat32] [-mbr] salida.img tam_MB [archivo|NOMBRE:bytes ...]\n", argv[0]);
+		return 1;
+	}
+
+	const char *out_path = argv[a];
+	uint32_t total = (uint32_t)atoi(argv[a + 1]) * 2048u;   // sectores del disco
+	int      first = a + 2;
+	int      files = argc - first;
+
+	uint32_t part = mbr ? PART_START : 0;
+	uint32_t vol  = total - part;                           // sectores del volumen
+	uint32_t eoc  = fat32 ? 0x0FFFFFFF : 0xFFFF;
+	uint32_t reserved = fat32 ? 32 : 1;
+	uint8_t  spc = 1;
+	if (!fat32) while (vol / spc > 65524u) spc <<= 1;
+
+	uint32_t clusters_est = vol / spc;
+	uint32_t fat_sectors  = ((clusters_est + 2) * (fat32 ? 4 : 2) + BPS - 1) / BPS;
+	uint32_t root_sectors = fat32 ? 0 : ROOT_ENTRIES * 32 / BPS;
+	uint32_t data_start   = reserved + NUM_FATS * fat_sectors + root_sectors;
+	uint32_t clusters     = (vol - data_start) / spc;
+	uint32_t cbytes       = (uint32_t)spc * BPS;
+
+	if (!fat32 && clusters < 4085) {
+		fprintf(stderr, "imagen demasiado pequea para FAT16\n");
+		return 1;
+	}
+	if (fat32 && clusters < 65525) {
+		fprintf(stderr, "imagen demasiado pequea para FAT32\n");
+		return 1;
+	}
+	if (!fat32 && files >= ROOT_ENTRIES) {
+		fprintf(stderr, "demasiados archivos\n");
+		return 1;
+	}
+
+	uint8_t *disk = calloc(total, BPS);
+	if (!disk) return 1;
+	uint8_t *img = disk + (size_t)part * BPS;
+
+	// MBR con una sola particin
+	if (mbr) {
+		uint8_t *pe = disk + 0x1BE;
+		pe[4] = fat32 ? 0x0C : 0x0E;                        // FAT32 / FAT16, LBA
+		put32(pe + 8, part);
+		put32(pe + 12, vol);
+		disk[510] = 0x55; disk[511] = 0xAA;
+	}
+
+	// Boot sector / BPB
+	uint8_t *bs = img;
+	bs[0] = 0xEB; bs[1] = fat32 ? 0x58 : 0x3C; bs[2] = 0x90;
+	memcpy(bs + 3, "MKIMG1.0", 8);
+	put16(bs + 11, BPS);
+	bs[13] = spc;
+	put16(bs + 14, (uint16_t)reserved);
+	bs[16] = NUM_FATS;
+	put16(bs + 17, fat32 ? 0 : ROOT_ENTRIES);
+	if (!fat32 && vol < 65536) put16(bs + 19, (uint16_t)vol); else put32(bs + 32, vol);
+	bs[21] = 0xF8;
+	put32(bs + 28, part);                                   // sectores ocultos
+	if (fat32) {
+		put32(bs + 36, fat_sectors);
+		put32(bs + 44, 2);                                  // clster del root
+		put16(bs + 48, 1);                                  // FSInfo
+		put16(bs + 50, 6);                                  // copia del boot
+		bs[66] = 0x29;
+		memcpy(bs + 71, "SIMSD      ", 11);
+		memcpy(bs + 82, "FAT32   ", 8);
+	} else {
+		put16(bs + 22, (uint16_t)fat_sectors);
+		bs[38] = 0x29;
+		memcpy(bs + 43, "SIMSD      ", 11);
+		memcpy(bs + 54, "FAT16   ", 8);
+	}
+	bs[510] = 0x55; bs[511] = 0xAA;
+	if (fat32) memcpy(img + 6 * BPS, bs, BPS);
+
+	fat = img + reserved * BPS;
+	set_fat(0, fat32 ? 0x0FFFFFF8 : 0xFFF8);
+	set_fat(1, eoc);
+
+	// Entradas del root en un buffer; al final van a su sitio
+	uint8_t *dir = calloc((size_t)files + 1, 32);
+
+	// FAT32: el root empieza en el clster 2 y los archivos detrs
+	uint32_t next_cluster = fat32 ? 3 : 2;
+
+	for (int i = 0; i < files; i++) {
+		const char *arg = argv[first + i];
+		const char *colon = strchr(arg, ':');
+		uint8_t *data = NULL;
+		uint32_t size = 0;
+
+		if (colon) {
+			size = (uint32_t)strtoul(colon + 1, NULL, 0);
+		} else {
+			FILE *f = fopen(arg, "rb");
+			if (!f) { perror(arg); return 1; }
+			fseek(f, 0, SEEK_END);
+			size = (uint32_t)ftell(f);
+			fseek(f, 0, SEEK_SET);
+			data = malloc(size ? size : 1);
+			if (fread(data, 1, size, f) != size) { perror(arg); return 1; }
+			fclose(f);
+		}
+
+		uint32_t ncl = (size + cbytes - 1) / cbytes;
+		if (next_cluster + ncl > clusters + 2) {
+			fprintf(stderr, "no cabe: %s\n", arg);
+			return 1;
+		}
+
+		uint8_t *e = dir + i * 32;
+		make_name83(arg, e);
+		e[11] = 0x20;
+		if (ncl) {
+			put16(e + 20, (uint16_t)(next_cluster >> 16));
+			put16(e + 26, (uint16_t)next_cluster);
+		}
+		put32(e + 28, size);
+
+		for (uint32_t c = 0; c < ncl; c++) {
+			uint32_t cl = next_cluster + c;
+			set_fat(cl, (c + 1 == ncl) ? eoc : cl + 1);
+		}
+		if (data) {
+			memcpy(img + (data_start + (next_cluster - 2) * spc) * BPS, data, size);
+			free(data);
+		}
+		next_cluster += ncl;
+	}
+
+	if (!fat32) {
+		memcpy(img + (reserved + NUM_FATS * fat_sectors) * BPS, dir, (size_t)files * 32);
+	} else {
+		// Cadena del root: 2 y luego los clsteres libres tras los archivos
+		uint32_t per_cl = cbytes / 32;
+		uint32_t n_cl   = (files + 1 + per_cl - 1) / per_cl;
+		uint32_t cl = 2;
+
+		if (next_cluster + n_cl - 1 > clusters + 2) {
+			fprintf(stderr, "no cabe el root\n");
+			return 1;
+		}
+		for (uint32_t k = 0; k < n_cl; k++) {
+			uint32_t next = (k + 1 == n_cl) ? eoc : next_cluster++;
+			uint32_t left = (uint32_t)files + 1 - k * per_cl;
+			if (left > per_cl) left = per_cl;
+			memcpy(img + (data_start + (cl - 2) * spc) * BPS, dir + k * cbytes, left * 32);
+			set_fat(cl, next);
+			cl = next;
+		}
+
+		// FSInfo: clsteres libres y siguiente libre
+		uint8_t *fsi = img + BPS;
+		put32(fsi + 0, 0x41615252);
+		put32(fsi + 484, 0x61417272);
+		put32(fsi + 488, clusters + 2 - next_cluster);
+		put32(fsi + 492, next_cluster);
+		put32(fsi + 508, 0xAA550000);
+	}
+	free(dir);
+
+	memcpy(fat + fat_sectors * BPS, fat, fat_sectors * BPS);   // segunda FAT
+
+	FILE *out = fopen(out_path, "wb");
+	if (!out) { perror(out_path); return 1; }
+	fwrite(disk, BPS, total, out);
+	fclose(out);
+	free(disk);
+	return 0;
+}
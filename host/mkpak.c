@@ -0,0 +1,261 @@
+// host/mkpak.c - Genera el paquete de la galera (GALLERY.PAK, ver pak.h)
+//
+// Uso: mkpak [-444] salida.pak imagen.bmp [...]
+//      mkpak [-444] salida.pak directorio
+//   Cada BMP (24 bits) es una entrada, en el orden dado; con un
+//   directorio, sus .bmp por orden alfabtico. Las imgenes se componen
+//   al ancho del panel como hace el visor con un BMP suelto: las
+//   estrechas centradas sobre fondo negro, las anchas recortadas por la
+//   derecha. El alto se conserva (las altas se pueden desplazar).
+//   -444  filas en RGB444 empaquetado (1,5 bytes por pxel), para el
+//         visor en TFT_COLOR_444; sin l, RGB565.
+//
+// Compilar: gcc -O2 -o mkpak host/mkpak.c
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <ctype.h>
+#include <dirent.h>
+#include <sys/stat.h>
+
+#define SCREEN_W    132
+#define BPS         512
+#define MAX_ENTRIES 16         // PAK_MAX_ENTRIES
+#define FMT_RGB565  0
+#define FMT_RGB444  1
+
+static void put16(uint8_t *p, uint16_t v) { p[0] = (uint8_t)v; p[1] = (uint8_t)(v >> 8); }
+static void put32(uint8_t *p, uint32_t v) { put16(p, (uint16_t)v); put16(p + 2, (uint16_t)(v >> 16)); }
+static uint32_t get32(const uint8_t *p) { return p[0] | p[1] << 8 | p[2] << 16 | (uint32_t)p[3] << 24; }
+
+typedef struct {
+	int      w, h;
+	uint8_t *rgb;      // w*h*3, fila 0 arriba
+} Image;
+
+static int load_bmp(const char *path, Image *img)
+{
+	FILE *f = fopen(path, "rb");
+	if (!f) { perror(path); return -1; }
+
+	uint8_t hdr[54];
+	if (fread(hdr, 1, 54, f) != 54 || hdr[0] != 'B' || hdr[1] != 'M' ||
+	    (hdr[28] | hdr[29] << 8) != 24) {
+		fprintf(stderr, "%s: no es un BMP de 24 bits\n", path);
+		fclose(f);
+		return -1;
+	}
+
+	uint32_t off = get32(&hdr[10]);
+	int32_t  w = (int32_t)get32(&hdr[18]);
+	int32_t  h = (int32_t)get32(&hdr[22]);
+	int      bottom_up = h > 0;
+	if (h < 0) h = -h;
+
+	uint32_t stride = ((uint32_t)w * 3 + 3) & ~3u;
+	uint8_t *row = malloc(stride);
+	img->w = w;
+	img->h = h;
+	img->rgb = malloc((size_t)w * h * 3);
+
+	for (int y = 0; y < h; y++) {
+		int src = bottom_up ? h - 1 - y : y;
+		fseek(f, (long)(off + (uint32_t)src * stride), SEEK_SET);
+		if (fread(row, 1, stride, f) != stride) memset(row, 0, stride);
+		for (int x = 0; x < w; x++) {
+			uint8_t *d = &img->rgb[((size_t)y * w + x) * 3];
+			d[0] = row[x * 3 + 2];
+			d[1] = row[x * 3 + 1];
+			d[2] = row[x * 3 + 0];
+		}
+	}
+
+	free(row);
+	fclose(f);
+	return 0;
+}
+
+// Los .bmp de un directorio, por orden alfabtico
+static int cmp_name(const void *a, const void *b)
+{
+	return strcmp(*(char *const *)a, *(char *const *)b);
+}
+
+static char **list_dir(const char *dir, int *count)
+{
+	DIR *d = opendir(dir);
+	if (!d) { perror(dir); return NULL; }
+
+	char **names = NULL;
+	int n = 0;
+	struct dirent *e;
+	while ((e = readdir(d)) != NULL) {
+		size_t len = strlen(e->d_name);
+		if (len < 5 || strcasecmp(e->d_name + len - 4, ".bmp") != 0) continue;
+		names = realloc(names, (n + 1) * sizeof *names);
+		names[n] = malloc(strlen(dir) + len + 2);
+		sprintf(names[n], "%s/%s", dir, e->d_name);
+		n++;
+	}
+	closedir(d);
+
+	qsort(names, n, sizeof *names, cmp_name);
+	*count = n;
+	return names;
+}
+
+// "ruta/foto.bmp" -> "FOTO.BMP" (8.3, como lo listara el firmware)
+static void make_name(const char *path, char out[12])
+{
+	const char *base = strrchr(path, '/');
+	base = base ? base + 1 : path;
+
+	memset(out, 0, 12);
+	int j = 0, n = 0, ext = 0;
+	for (int i = 0; base[i] && j < 12; i++) {
+		if (base[i] == '.') {
+			if (ext) break;
+			ext = 1; n = 0;
+			out[j++] = '.';
+			continue;
+		}
+		if (n < (ext ? 3 : 8)) {
+			out[j++] = (char)toupper((unsigned char)base[i]);
+			n++;
+		}
+	}
+}
+
+// Fila y de la imagen compuesta al ancho del panel, en RGB888
+static void compose_row(const Image *img, int y, uint8_t out[SCREEN_W * 3])
+{
+	int w  = img->w > SCREEN_W ? SCREEN_W : img->w;
+	int ox = (SCREEN_W - w) / 2;
+
+	memset(out, 0, SCREEN_W * 3);
+	memcpy(out + ox * 3, img->rgb + (size_t)y * img->w * 3, (size_t)w * 3);
+}
+
+static size_t row_bytes(int format)
+{
+	return format == FMT_RGB444 ? SCREEN_W * 3 / 2 : SCREEN_W * 2;
+}
+
+// Misma conversin que el firmware con un BMP (TFT_WriteBGR888)
+static void encode_row(const uint8_t *rgb, int format, uint8_t *out)
+{
+	for (int x = 0; x < SCREEN_W; x++) {
+		uint8_t r = rgb[x * 3], g = rgb[x * 3 + 1], b = rgb[x * 3 + 2];
+
+		if (format == FMT_RGB565) {
+			out[x * 2]     = (uint8_t)((r & 0xF8) | (g >> 5));
+			out[x * 2 + 1] = (uint8_t)(((g << 3) & 0xE0) | (b >> 3));
+		} else {
+			uint16_t c = (uint16_t)((r & 0xF0) << 4 | (g & 0xF0) | (b >> 4));
+			uint8_t *p = out + (x / 2) * 3;
+			if (x & 1) {
+				p[1] |= (uint8_t)(c >> 8);
+				p[2]  = (uint8_t)c;
+			} else {
+				p[0] = (uint8_t)(c >> 4);
+				p[1] = (uint8_t)(c << 4);
+			}
+		}
+	}
+}
+
+int main(int argc, char **argv)
+{
+	int format = FMT_RGB565;
+	int a = 1;
+
+	for (; a < argc && argv[a][0] == '-'; a++) {
+		if (!strcmp(argv[a], "-444")) format = FMT_RGB444;
+		else break;
+	}
+
+	if (argc - a < 2) {
+		fprintf(stderr, "uso: %s [-444] salida.pak imagen.bmp [...] | directorio\n", argv[0]);
+		return 1;
+	}
+
+	const char *out_path = argv[a];
+	char **files = argv + a + 1;
+	int    count = argc - a - 1;
+
+	struct stat st;
+	if (count == 1 && stat(files[0], &st) == 0 && S_ISDIR(st.st_mode)) {
+		files = list_dir(files[0], &count);
+		if (!files) return 1;
+	}
+	if (count == 0) {
+		fprintf(stderr, "no hay imgenes\n");
+		return 1;
+	}
+	if (count > MAX_ENTRIES)
+		fprintf(stderr, "aviso: el firmware solo usa las %d primeras\n", MAX_ENTRIES);
+
+	FILE *out = fopen(out_path, "wb");
+	if (!out) { perror(out_path); return 1; }
+
+	// ndice: cabecera de 32 bytes y una entrada de 32 por imagen
+	uint32_t index_sectors = (32 + 32 * (uint32_t)count + BPS - 1) / BPS;
+	uint8_t *index = calloc(index_sectors, BPS);
+	memcpy(index, "PAK1", 4);
+	put16(index + 4, (uint16_t)count);
+	fseek(out, (long)index_sectors * BPS, SEEK_SET);
+
+	uint32_t sector = index_sectors;
+	size_t   rb = row_bytes(format);
+	uint8_t  rgb[SCREEN_W * 3];
+	uint8_t *enc = malloc(rb);
+
+	for (int i = 0; i < count; i++) {
+		Image img;
+		if (load_bmp(files[i], &img) != 0) return 1;
+		if (img.h > 0xFFFF) {
+			fprintf(stderr, "%s: demasiado alta\n", files[i]);
+			return 1;
+		}
+
+		uint32_t bytes   = (uint32_t)(rb * img.h);
+		uint32_t sectors = (bytes + BPS - 1) / BPS;
+
+		uint8_t *e = index + 32 + 32 * i;
+		char name[12];
+		make_name(files[i], name);
+		memcpy(e, name, 12);
+		put16(e + 12, SCREEN_W);
+		put16(e + 14, (uint16_t)img.h);
+		e[16] = (uint8_t)format;
+		put32(e + 20, sector);
+		put32(e + 24, sectors);
+
+		for (int y = 0; y < img.h; y++) {
+			compose_row(&img, y, rgb);
+			encode_row(rgb, format, enc);
+			fwrite(enc, 1, rb, out);
+		}
+
+		// Siguiente imagen en sector nuevo
+		static const uint8_t zero[BPS];
+		fwrite(zero, 1, (size_t)sectors * BPS - bytes, out);
+
+		printf("%-12s %4dx%-4d sector %u (%u)\n", name, img.w, img.h, sector, sectors);
+		sector += sectors;
+		free(img.rgb);
+	}
+
+	fseek(out, 0, SEEK_SET);
+	fwrite(index, BPS, index_sectors, out);
+	fclose(out);
+
+	printf("%s: %d imgenes, %u sectores, %s\n", out_path, count, sector,
+	       format == FMT_RGB444 ? "RGB444" : "RGB565");
+	free(index);
+	free(enc);
+	return 0;
+}
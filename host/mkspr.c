@@ -0,0 +1,163 @@
+// host/mkspr.c - Genera un sprite .SPR (ver sprite.h) a partir de un BMP
+//
+// Uso: mkspr [-key RRGGBB] [-c nombre] entrada.bmp salida
+//   El BMP (24 bits, hasta 64 pxeles de ancho y 255 de alto) es el
+//   sprite entero; los pxeles del color clave (por defecto FF00FF,
+//   magenta) son transparentes. Cada fila se guarda como sus tramos
+//   opacos.
+//   -c  en lugar del archivo para la SD escribe en 'salida' un array C
+//       'nombre' en PROGMEM con los mismos bytes, para SPR_FromFlash.
+//
+// Compilar: gcc -O2 -o mkspr host/mkspr.c
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define MAX_W   64       // SPR_MAX_W
+#define MAX_H   255
+#define HEADER  8
+
+static uint32_t get32(const uint8_t *p) { return p[0] | p[1] << 8 | p[2] << 16 | (uint32_t)p[3] << 24; }
+
+typedef struct {
+	int      w, h;
+	uint8_t *rgb;      // w*h*3, fila 0 arriba
+} Image;
+
+static int load_bmp(const char *path, Image *img)
+{
+	FILE *f = fopen(path, "rb");
+	if (!f) { perror(path); return -1; }
+
+	uint8_t hdr[54];
+	if (fread(hdr, 1, 54, f) != 54 || hdr[0] != 'B' || hdr[1] != 'M' ||
+	    (hdr[28] | hdr[29] << 8) != 24) {
+		fprintf(stderr, "%s: no es un BMP de 24 bits\n", path);
+		fclose(f);
+		return -1;
+	}
+
+	uint32_t off = get32(&hdr[10]);
+	int32_t  w = (int32_t)get32(&hdr[18]);
+	int32_t  h = (int32_t)get32(&hdr[22]);
+	int      bottom_up = h > 0;
+	if (h < 0) h = -h;
+
+	uint32_t stride = ((uint32_t)w * 3 + 3) & ~3u;
+	uint8_t *row = malloc(stride);
+	img->w = w;
+	img->h = h;
+	img->rgb = malloc((size_t)w * h * 3);
+
+	for (int y = 0; y < h; y++) {
+		int src = bottom_up ? h - 1 - y : y;
+		fseek(f, (long)(off + (uint32_t)src * stride), SEEK_SET);
+		if (fread(row, 1, stride, f) != stride) memset(row, 0, stride);
+		for (int x = 0; x < w; x++) {
+			uint8_t *d = &img->rgb[((size_t)y * w + x) * 3];
+			d[0] = row[x * 3 + 2];
+			d[1] = row[x * 3 + 1];
+			d[2] = row[x * 3 + 0];
+		}
+	}
+
+	free(row);
+	fclose(f);
+	return 0;
+}
+
+static uint16_t rgb565(const uint8_t *p)
+{
+	return (uint16_t)(((p[0] & 0xF8) << 8) | ((p[1] & 0xFC) << 3) | (p[2] >> 3));
+}
+
+int main(int argc, char **argv)
+{
+	uint32_t    key = 0xFF00FF;
+	const char *cname = NULL;
+	int a = 1;
+
+	for (; a < argc && argv[a][0] == '-'; a++) {
+		if (!strcmp(argv[a], "-key") && a + 1 < argc)   key = (uint32_t)strtoul(argv[++a], NULL, 16);
+		else if (!strcmp(argv[a], "-c") && a + 1 < argc) cname = argv[++a];
+		else break;
+	}
+	if (argc - a != 2) {
+		fprintf(stderr, "uso: %s [-key RRGGBB] [-c nombre] entrada.bmp salida\n", argv[0]);
+		return 1;
+	}
+
+	Image img;
+	if (load_bmp(argv[a], &img) != 0) return 1;
+	if (img.w < 1 || img.w > MAX_W || img.h < 1 || img.h > MAX_H) {
+		fprintf(stderr, "%s: %dx%d, el mximo es %dx%d\n", argv[a], img.w, img.h, MAX_W, MAX_H);
+		return 1;
+	}
+
+	// Cabecera + en el peor caso, por fila, 1 + tramos alternos de 1 pxel
+	size_t   cap = HEADER + (size_t)img.h * (1 + MAX_W / 2 * 4 + MAX_W);
+	uint8_t *out = calloc(1, cap);
+	size_t   len = HEADER;
+	unsigned spans = 0, opaque = 0;
+
+	for (int y = 0; y < img.h; y++) {
+		size_t count_at = len++;
+		int    n = 0;
+
+		for (int x = 0; x < img.w; ) {
+			const uint8_t *p = &img.rgb[((size_t)y * img.w + x) * 3];
+			if ((uint32_t)(p[0] << 16 | p[1] << 8 | p[2]) == key) { x++; continue; }
+
+			int x0 = x;
+			out[len++] = (uint8_t)x0;
+			size_t len_at = len++;
+			for (; x < img.w; x++) {
+				p = &img.rgb[((size_t)y * img.w + x) * 3];
+				if ((uint32_t)(p[0] << 16 | p[1] << 8 | p[2]) == key) break;
+				uint16_t c = rgb565(p);
+				out[len++] = (uint8_t)(c >> 8);
+				out[len++] = (uint8_t)c;
+			}
+			out[len_at] = (uint8_t)(x - x0);
+			opaque += (unsigned)(x - x0);
+			n++;
+		}
+		out[count_at] = (uint8_t)n;
+		spans += (unsigned)n;
+	}
+
+	if (len - HEADER > 0xFFFF) {
+		fprintf(stderr, "%s: demasiado grande (%zu bytes)\n", argv[a], len);
+		return 1;
+	}
+
+	memcpy(out, "SPR1", 4);
+	out[4] = (uint8_t)img.w;
+	out[5] = (uint8_t)img.h;
+	out[6] = (uint8_t)(len - HEADER);
+	out[7] = (uint8_t)((len - HEADER) >> 8);
+
+	FILE *f = fopen(argv[a + 1], cname ? "w" : "wb");
+	if (!f) { perror(argv[a + 1]); return 1; }
+
+	if (cname) {
+		fprintf(f, "// %s: %dx%d, generado con host/mkspr.c a partir de %s\n",
+		        cname, img.w, img.h, argv[a]);
+		fprintf(f, "const uint8_t %s[%zu] PROGMEM = {", cname, len);
+		for (size_t i = 0; i < len; i++)
+			fprintf(f, "%s0x%02X,", (i % 12) ? " " : "\n\t", out[i]);
+		fprintf(f, "\n};\n");
+	} else {
+		fwrite(out, 1, len, f);
+	}
+	if (fclose(f) != 0) { perror(argv[a + 1]); return 1; }
+
+	printf("%dx%d: %u tramos, %u de %d pxeles opacos, %zu bytes\n",
+	       img.w, img.h, spans, opaque, img.w * img.h, len);
+
+	free(out);
+	free(img.rgb);
+	return 0;
+}
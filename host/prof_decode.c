@@ -0,0 +1,117 @@
+// host/prof_decode.c - Decodifica los paquetes de PROF_Flush (prof.h)
+//
+// Compilar: gcc -O2 -o prof_decode host/prof_decode.c
+// Uso:      stty -F /dev/ttyUSB0 500000 raw && prof_decode < /dev/ttyUSB0
+//           prof_decode captura.bin
+//
+// Imprime por fotograma cada fase con sus ciclos, entradas, media y
+// porcentaje del fotograma. Los ciclos de cada fase son exclusivos (sin
+// los de las fases anidadas) y suman el fotograma; "resto" es lo que no
+// est dentro de ninguna otra sonda.
+//
+// El puerto es el de uart_stream.h (UART_STREAM_BAUD): los XON/XOFF que
+// manda su control de flujo pueden caer entre los bytes de un paquete y
+// se ignoran; los del paquete van escapados.
+
+#include <stdint.h>
+#include <stdio.h>
+
+#define F_CPU_HZ  8000000.0
+#define SYNC0     0xC3     // PROF_SYNC0
+#define ESC       0x7D     // PROF_ESC
+#define XON       0x11
+#define XOFF      0x13
+#define CUT       (-2)
+
+// Byte del paquete ya sin escapar, EOF, o CUT si aparece un sincronismo
+// (el paquete se cort: se deja para la siguiente cabecera)
+static int get_byte(FILE *in)
+{
+	int c;
+
+	do c = fgetc(in); while (c == XON || c == XOFF);
+	if (c == SYNC0) {
+		ungetc(c, in);
+		return CUT;
+	}
+	if (c != ESC) return c;
+
+	do c = fgetc(in); while (c == XON || c == XOFF);
+	return (c == EOF) ? EOF : (c ^ 0x20);
+}
+
+static const char *phase_names[] = {
+	"resto", "sd_wait", "sd_data", "fat_copy", "bmp_convert", "tft_write", "fractal_iter"
+};
+#define NAMES  (sizeof(phase_names) / sizeof(phase_names[0]))
+
+int main(int argc, char **argv)
+{
+	FILE *in = stdin;
+	if (argc > 1 && !(in = fopen(argv[1], "rb"))) {
+		perror(argv[1]);
+		return 1;
+	}
+
+	unsigned frame = 0;
+	int c, prev = -1;
+
+	while ((c = fgetc(in)) != EOF) {
+		// Sincronizar con la cabecera 0xC3 'P'
+		if (!(prev == SYNC0 && c == 'P')) {
+			prev = c;
+			continue;
+		}
+		prev = -1;
+
+		int n = get_byte(in);
+		if (n == EOF) break;
+		if (n < 0 || n > 32) continue;
+
+		uint8_t  sum = (uint8_t)n;
+		uint32_t total[32];
+		uint16_t count[32];
+		int ok = 1;
+
+		for (int i = 0; i < n && ok > 0; i++) {
+			uint8_t b[6];
+			for (int k = 0; k < 6; k++) {
+				int v = get_byte(in);
+				if (v < 0) { ok = v; break; }
+				b[k] = (uint8_t)v;
+				sum += b[k];
+			}
+			total[i] = (uint32_t)b[0] | (uint32_t)b[1] << 8 |
+			           (uint32_t)b[2] << 16 | (uint32_t)b[3] << 24;
+			count[i] = (uint16_t)(b[4] | b[5] << 8);
+		}
+
+		int check = ok > 0 ? get_byte(in) : ok;
+		if (check == EOF) break;
+		if (check == CUT) {
+			fprintf(stderr, "paquete cortado, descartado\n");
+			continue;
+		}
+		if ((uint8_t)check != sum) {
+			fprintf(stderr, "paquete con suma incorrecta, descartado\n");
+			continue;
+		}
+
+		uint32_t all = 0;
+		for (int i = 0; i < n; i++) all += total[i];
+
+		double frame_cycles = all ? (double)all : 1.0;
+		printf("frame %u: %u ciclos (%.1f ms)\n", frame++, all,
+		       all * 1000.0 / F_CPU_HZ);
+
+		for (int i = 0; i < n; i++) {
+			if (!count[i]) continue;
+			printf("  %-13s %10u ciclos %6u veces %8.0f/vez %5.1f%%\n",
+			       (unsigned)i < NAMES ? phase_names[i] : "?",
+			       total[i], count[i], (double)total[i] / count[i],
+			       100.0 * total[i] / frame_cycles);
+		}
+	}
+
+	return 0;
+}
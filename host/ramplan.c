@@ -0,0 +1,334 @@
+// host/ramplan.c - Presupuesto de SRAM por modo: esttico + pila
+//
+// Preparar (desde la raz del proyecto):
+//   avr-gcc -mmcu=atmega32 -Os -DF_CPU=8000000UL -fcallgraph-info=su
+//       -o fw.elf main.c spi_hal.c sd_spi.c fat_fs.c bmp_stream.c
+//       tft_st7735.c frame_cache.c fractal.c fractal_kernel.c cycles.c
+//       uart.c font5x7.c hud.c prof.c anim.c pak.c uart_stream.c
+//       scratch.c buttons.c fractal_kernel_avr.S
+//   avr-nm -S -t d fw.elf > fw.nm
+//   gcc -O2 -o ramplan host/ramplan.c
+//
+// Uso: ramplan [-m bytes_sram] fw.nm fw-*.ci
+//
+// Esttico: .data + .bss del ELF (igual en todos los modos: el arena de
+// scratch.h cuenta una vez, con el tamao de su regin mayor), con los
+// smbolos ms grandes.
+// Pila: el camino ms hondo desde main sin entrar en lo que solo usa otro
+// modo (tabla 'modes'), ms la ISR ms honda, que puede llegar encima.
+// Cada llamada suma 2 bytes de direccin de retorno al marco que da gcc.
+// Las funciones sin datos (avr-libc, ensamblador) cuentan 0 y se listan.
+//
+// Termina con 1 si algn modo no cabe en la SRAM.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define SRAM_DEFAULT  2048      // ATmega32
+#define CALL_BYTES    2         // PC de 16 bits
+#define MAX_FUNCS     1024
+#define MAX_EDGES     8192
+#define MAX_SYMS      512
+#define TOP_SYMS      12
+
+typedef struct {
+	char name[96];       // ttulo del nodo: "ruta:nombre" si es static
+	long frame;          // -1: sin datos
+	int  unbounded;      // marco dinmico sin cota
+	// Por modo
+	long depth;          // -1: sin calcular
+	int  next;           // hijo del camino ms hondo
+	int  visiting;
+} Func;
+
+typedef struct { int from, to; } Edge;
+
+typedef struct {
+	const char *name;
+	const char *skip[16];      // prefijos de lo que este modo no llama
+	const char *indirect[4];   // destinos de las llamadas por puntero
+} Mode;
+
+// TFT_DirtyFlush es la nica llamada por puntero: el pintor del modo
+static const Mode modes[] = {
+	{ "visor",
+	  { "FRACTAL_Draw", "FRACTAL_Recolor", "FRACTAL_Pan", "FRACTAL_Zoom",
+	    "fractal_", "stream_", "USTREAM_Poll", "bench_", NULL },
+	  { "gallery_paint", NULL } },
+	{ "fractal",
+	  { "gallery_", "draw_bmp_rows", "slide_in_bmp", "BMP_", "PAK_", "ANIM_",
+	    "FAT_ListFiles", "stream_", "USTREAM_Poll", "bench_", NULL },
+	  { "fractal_paint", NULL } },
+	{ "stream",
+	  { "gallery_", "draw_bmp_rows", "slide_in_bmp", "BMP_", "PAK_", "ANIM_",
+	    "FAT_", "FRACTAL_", "fractal_", "FCACHE_", "HUD_", "hud_toggle",
+	    "storage_init", "bench_", NULL },
+	  { NULL } },
+};
+#define MODES  (sizeof(modes) / sizeof(modes[0]))
+
+static Func funcs[MAX_FUNCS];
+static int  nfuncs;
+static Edge edges[MAX_EDGES];
+static int  nedges;
+
+typedef struct { long size; char name[64]; } Sym;
+static Sym  syms[MAX_SYMS];
+static int  nsyms;
+
+// Nombre sin la ruta de los static
+static const char *short_name(const char *title)
+{
+	const char *c = strrchr(title, ':');
+	return c ? c + 1 : title;
+}
+
+static int find_func(const char *title)
+{
+	for (int i = 0; i < nfuncs; i++)
+		if (!strcmp(funcs[i].name, title)) return i;
+
+	if (nfuncs == MAX_FUNCS) {
+		fprintf(stderr, "demasiadas funciones\n");
+		exit(1);
+	}
+	Func *f = &funcs[nfuncs];
+	snprintf(f->name, sizeof f->name, "%s", title);
+	f->frame = -1;
+	return nfuncs++;
+}
+
+static int find_short(const char *name)
+{
+	for (int i = 0; i < nfuncs; i++)
+		if (!strcmp(short_name(funcs[i].name), name)) return i;
+	return -1;
+}
+
+// Valor entre comillas tras 'key' (sin las comillas)
+static int get_field(const char *line, const char *key, char *out, size_t n)
+{
+	const char *p = strstr(line, key);
+	if (!p) return 0;
+	p += strlen(key);
+	const char *e = strchr(p, '"');
+	if (!e) return 0;
+
+	size_t len = (size_t)(e - p);
+	if (len >= n) len = n - 1;
+	memcpy(out, p, len);
+	out[len] = '\0';
+	return 1;
+}
+
+// Formato VCG de gcc -fcallgraph-info=su:
+//   node: { title: "f" label: "f\nfich.c:1:2\n12 bytes (static)" }
+//   edge: { sourcename: "f" targetname: "g" label: "..." }
+static int load_ci(const char *path)
+{
+	FILE *f = fopen(path, "r");
+	if (!f) { perror(path); return -1; }
+
+	char line[1024], a[256], b[256];
+	while (fgets(line, sizeof line, f)) {
+		if (!strncmp(line, "node:", 5) && get_field(line, "title: \"", a, sizeof a)) {
+			int i = find_func(a);
+			if (get_field(line, "label: \"", b, sizeof b)) {
+				char *p = strstr(b, " bytes (");
+				if (p) {
+					while (p > b && p[-1] >= '0' && p[-1] <= '9') p--;
+					funcs[i].frame = atol(p);
+					funcs[i].unbounded = strstr(p, "(dynamic)") != NULL;
+				}
+			}
+		} else if (!strncmp(line, "edge:", 5) &&
+		           get_field(line, "sourcename: \"", a, sizeof a) &&
+		           get_field(line, "targetname: \"", b, sizeof b)) {
+			if (nedges == MAX_EDGES) {
+				fprintf(stderr, "demasiadas llamadas\n");
+				exit(1);
+			}
+			edges[nedges].from = find_func(a);
+			edges[nedges].to   = find_func(b);
+			nedges++;
+		}
+	}
+	fclose(f);
+	return 0;
+}
+
+// avr-nm -S -t d: "valor tamao tipo nombre"; .data y .bss son d/D y b/B
+static long load_nm(const char *path)
+{
+	FILE *f = fopen(path, "r");
+	if (!f) { perror(path); return -1; }
+
+	char line[256], name[64], type;
+	long value, size, total = 0;
+	while (fgets(line, sizeof line, f)) {
+		if (sscanf(line, "%ld %ld %c %63s", &value, &size, &type, name) != 4) continue;
+		if (!strchr("bBdD", type)) continue;
+
+		total += size;
+		if (nsyms < MAX_SYMS) {
+			syms[nsyms].size = size;
+			snprintf(syms[nsyms].name, sizeof syms[nsyms].name, "%s", name);
+			nsyms++;
+		}
+	}
+	fclose(f);
+	return total;
+}
+
+static int cmp_sym(const void *a, const void *b)
+{
+	long d = ((const Sym *)b)->size - ((const Sym *)a)->size;
+	return (d > 0) - (d < 0);
+}
+
+static int skipped(const Mode *m, const char *title)
+{
+	const char *n = short_name(title);
+	for (int i = 0; m->skip[i]; i++)
+		if (!strncmp(n, m->skip[i], strlen(m->skip[i]))) return 1;
+	return 0;
+}
+
+static long depth(const Mode *m, int i);
+
+static void try_child(const Mode *m, Func *f, long *best, int c)
+{
+	long d = depth(m, c);
+	if (d > *best) {
+		*best = d;
+		f->next = c;
+	}
+}
+
+// Pila desde la entrada en 'i' hasta la hoja ms honda, su marco incluido
+static long depth(const Mode *m, int i)
+{
+	Func *f = &funcs[i];
+	if (f->depth >= 0) return f->depth;
+	if (f->visiting) {
+		fprintf(stderr, "aviso: recursin en %s, sin contar\n", short_name(f->name));
+		return 0;
+	}
+
+	f->visiting = 1;
+	long best = -1;            // sin llamadas
+	for (int e = 0; e < nedges; e++) {
+		if (edges[e].from != i || skipped(m, funcs[edges[e].to].name)) continue;
+
+		if (!strcmp(funcs[edges[e].to].name, "__indirect_call")) {
+			for (int k = 0; m->indirect[k]; k++) {
+				int c = find_short(m->indirect[k]);
+				if (c >= 0) try_child(m, f, &best, c);
+			}
+		} else {
+			try_child(m, f, &best, edges[e].to);
+		}
+	}
+	f->visiting = 0;
+
+	f->depth = (f->frame > 0 ? f->frame : 0) + (best >= 0 ? best + CALL_BYTES : 0);
+	return f->depth;
+}
+
+static void reset(void)
+{
+	for (int i = 0; i < nfuncs; i++) {
+		funcs[i].depth = -1;
+		funcs[i].next = -1;
+		funcs[i].visiting = 0;
+	}
+}
+
+static void print_path(int i)
+{
+	for (; i >= 0; i = funcs[i].next)
+		printf(" %s(%ld)%s", short_name(funcs[i].name),
+		       funcs[i].frame > 0 ? funcs[i].frame : 0, funcs[i].next >= 0 ? " >" : "");
+	printf("\n");
+}
+
+int main(int argc, char **argv)
+{
+	long sram = SRAM_DEFAULT;
+	int  a = 1;
+
+	if (a + 1 < argc && !strcmp(argv[a], "-m")) {
+		sram = atol(argv[a + 1]);
+		a += 2;
+	}
+	if (argc - a < 2) {
+		fprintf(stderr, "uso: %s [-m bytes_sram] fw.nm fw-*.ci\n", argv[0]);
+		return 1;
+	}
+
+	long stat = load_nm(argv[a]);
+	if (stat < 0) return 1;
+	for (int i = a + 1; i < argc; i++)
+		if (load_ci(argv[i]) != 0) return 1;
+
+	int root = find_short("main");
+	if (root < 0 || funcs[root].frame < 0) {
+		fprintf(stderr, "main no est en los .ci\n");
+		return 1;
+	}
+
+	qsort(syms, (size_t)nsyms, sizeof syms[0], cmp_sym);
+	printf("SRAM %ld bytes, esttico %ld (.data + .bss)\n", sram, stat);
+	for (int i = 0; i < nsyms && i < TOP_SYMS; i++)
+		printf("  %6ld  %s\n", syms[i].size, syms[i].name);
+
+	// ISR ms honda: no se anidan, basta con la mayor
+	static const Mode no_skip = { "isr", { NULL }, { NULL } };
+	long isr = 0;
+	int  isr_root = -1;
+	reset();
+	for (int i = 0; i < nfuncs; i++) {
+		if (strncmp(short_name(funcs[i].name), "__vector_", 9)) continue;
+		long d = depth(&no_skip, i) + CALL_BYTES;
+		if (d > isr) { isr = d; isr_root = i; }
+	}
+
+	printf("\n%-8s %6s %6s %6s\n", "modo", "pila", "ISR", "libre");
+	int over = 0;
+	for (unsigned m = 0; m < MODES; m++) {
+		reset();
+		long d = depth(&modes[m], root);
+		long free_b = sram - stat - d - isr;
+		printf("%-8s %6ld %6ld %6ld\n", modes[m].name, d, isr, free_b);
+		if (free_b < 0) over = 1;
+	}
+
+	// Los caminos, para saber qu recortar
+	printf("\n");
+	for (unsigned m = 0; m < MODES; m++) {
+		reset();
+		depth(&modes[m], root);
+		printf("%s:", modes[m].name);
+		print_path(root);
+	}
+	if (isr_root >= 0) {
+		reset();
+		depth(&no_skip, isr_root);
+		printf("isr:");
+		print_path(isr_root);
+	}
+
+	// Lo que no se ha podido contar
+	int first = 1;
+	for (int i = 0; i < nfuncs; i++) {
+		if (!strcmp(funcs[i].name, "__indirect_call")) continue;
+		if (funcs[i].frame >= 0 && !funcs[i].unbounded) continue;
+		if (first) printf("\nsin datos o sin cota:");
+		printf(" %s%s", short_name(funcs[i].name), funcs[i].unbounded ? "(dinmico)" : "");
+		first = 0;
+	}
+	if (!first) printf("\n");
+
+	return over;
+}
@@ -0,0 +1,284 @@
+// host/sendimg.c - Manda imgenes al panel por el puerto serie (uart_stream.h)
+//
+// Uso: sendimg [-rle] [-at X,Y] puerto imagen.bmp [...]
+//   Cada BMP (24 bits) es una trama, recortada a lo que cabe en el panel
+//   desde (X, Y) (0,0 por defecto). Tras cada una espera la respuesta del
+//   AVR; si la rechaza, o no contesta, la repite (hasta 3 veces).
+//   -rle  pxeles comprimidos por repeticiones (sin l, tal cual)
+//   puerto: el adaptador USB-serie (/dev/ttyUSB0...) a 500000 baudios, o
+//           el pseudoterminal que imprime "sim disco.img serial N".
+//   El control de flujo XON/XOFF del AVR lo hace el propio driver (IXON).
+//
+// Compilar: gcc -O2 -Ihost -o sendimg host/sendimg.c
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <termios.h>
+#include <time.h>
+#include <unistd.h>
+#include <util/crc16.h>
+
+#define SCREEN_W      132
+#define SCREEN_H      162
+#define SYNC          0xA5     // USTREAM_SYNC
+#define TYPE_RAW      0
+#define TYPE_RLE      1
+#define ACK           'K'
+#define TIMEOUT_MS    50       // USTREAM_TIMEOUT_MS
+#define RETRIES       3
+#define PROF_SYNC     0xC3     // PROF_SYNC0 (prof.c), firmware con -DPROF_ENABLE
+#define PROF_ESC      0x7D     // PROF_ESC
+
+static uint32_t get32(const uint8_t *p) { return p[0] | p[1] << 8 | p[2] << 16 | (uint32_t)p[3] << 24; }
+
+typedef struct {
+	int      w, h;
+	uint8_t *rgb;      // w*h*3, fila 0 arriba
+} Image;
+
+static int load_bmp(const char *path, Image *img)
+{
+	FILE *f = fopen(path, "rb");
+	if (!f) { perror(path); return -1; }
+
+	uint8_t hdr[54];
+	if (fread(hdr, 1, 54, f) != 54 || hdr[0] != 'B' || hdr[1] != 'M' ||
+	    (hdr[28] | hdr[29] << 8) != 24) {
+		fprintf(stderr, "%s: no es un BMP de 24 bits\n", path);
+		fclose(f);
+		return -1;
+	}
+
+	uint32_t off = get32(&hdr[10]);
+	int32_t  w = (int32_t)get32(&hdr[18]);
+	int32_t  h = (int32_t)get32(&hdr[22]);
+	int      bottom_up = h > 0;
+	if (h < 0) h = -h;
+
+	uint32_t stride = ((uint32_t)w * 3 + 3) & ~3u;
+	uint8_t *row = malloc(stride);
+	img->w = w;
+	img->h = h;
+	img->rgb = malloc((size_t)w * h * 3);
+
+	for (int y = 0; y < h; y++) {
+		int src = bottom_up ? h - 1 - y : y;
+		fseek(f, (long)(off + (uint32_t)src * stride), SEEK_SET);
+		if (fread(row, 1, stride, f) != stride) memset(row, 0, stride);
+		for (int x = 0; x < w; x++) {
+			uint8_t *d = &img->rgb[((size_t)y * w + x) * 3];
+			d[0] = row[x * 3 + 2];
+			d[1] = row[x * 3 + 1];
+			d[2] = row[x * 3 + 0];
+		}
+	}
+
+	free(row);
+	fclose(f);
+	return 0;
+}
+
+// Misma conversin que el firmware con un BMP (TFT_WriteBGR888)
+static uint16_t to565(const uint8_t *rgb)
+{
+	return (uint16_t)((rgb[0] & 0xF8) << 8 | (rgb[1] & 0xFC) << 3 | rgb[2] >> 3);
+}
+
+static size_t put_pixel(uint8_t *out, uint16_t c)
+{
+	out[0] = (uint8_t)(c >> 8);
+	out[1] = (uint8_t)c;
+	return 2;
+}
+
+// Repeticiones de 2 o ms pxeles (3 bytes en lugar de 4); el resto en
+// paquetes literales de hasta 128
+static size_t encode_rle(const uint16_t *px, size_t n, uint8_t *out)
+{
+	size_t o = 0, i = 0;
+
+	while (i < n) {
+		size_t run = 1;
+		while (i + run < n && run < 128 && px[i + run] == px[i]) run++;
+
+		if (run >= 2) {
+			out[o++] = (uint8_t)(0x80 | (run - 1));
+			o += put_pixel(out + o, px[i]);
+			i += run;
+			continue;
+		}
+
+		size_t lit = 1;
+		while (i + lit < n && lit < 128 &&
+		       !(i + lit + 1 < n && px[i + lit] == px[i + lit + 1]))
+			lit++;
+
+		out[o++] = (uint8_t)(lit - 1);
+		for (size_t k = 0; k < lit; k++)
+			o += put_pixel(out + o, px[i + k]);
+		i += lit;
+	}
+	return o;
+}
+
+static int open_port(const char *path)
+{
+	int fd = open(path, O_RDWR | O_NOCTTY);
+	if (fd < 0) { perror(path); return -1; }
+
+	struct termios t;
+	if (tcgetattr(fd, &t) != 0) { perror(path); close(fd); return -1; }
+	cfmakeraw(&t);
+	t.c_iflag |= IXON;            // XOFF/XON del AVR paran y siguen la salida
+	t.c_cc[VMIN]  = 0;
+	t.c_cc[VTIME] = 1;            // read() vuelve cada 0,1 s
+	cfsetispeed(&t, B500000);
+	cfsetospeed(&t, B500000);
+	if (tcsetattr(fd, TCSANOW, &t) != 0) { perror(path); close(fd); return -1; }
+
+	tcflush(fd, TCIFLUSH);
+	return fd;
+}
+
+static int write_all(int fd, const uint8_t *p, size_t n)
+{
+	while (n) {
+		ssize_t w = write(fd, p, n);
+		if (w <= 0) return -1;
+		p += w;
+		n -= (size_t)w;
+	}
+	return 0;
+}
+
+// Un byte, o -1 si no llega en 2 s
+static int read_byte(int fd)
+{
+	for (int tries = 0; tries < 20; tries++) {
+		uint8_t b;
+		if (read(fd, &b, 1) == 1) return b;
+	}
+	return -1;
+}
+
+// Salta un paquete de perfilado (prof.h) ya empezado: 'P', n y
+// n * 6 + 1 bytes, cada uno quiz escapado
+static void skip_prof(int fd)
+{
+	int n;
+
+	if (read_byte(fd) != 'P' || (n = read_byte(fd)) < 0) return;
+	for (int left = n * 6 + 1; left > 0; left--) {
+		int b = read_byte(fd);
+		if (b < 0) return;
+		if (b == PROF_ESC) read_byte(fd);
+	}
+}
+
+// Respuesta del AVR a la trama, o 0 si no llega en 2 s. Un volcado de
+// perfilado que empez justo antes de la trama llega delante: se salta.
+static int wait_reply(int fd)
+{
+	int b;
+
+	while ((b = read_byte(fd)) == PROF_SYNC)
+		skip_prof(fd);
+	return (b < 0) ? 0 : b;
+}
+
+static double now_s(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+int main(int argc, char **argv)
+{
+	int rle = 0, x0 = 0, y0 = 0;
+	int a = 1;
+
+	for (; a < argc && argv[a][0] == '-'; a++) {
+		if (!strcmp(argv[a], "-rle")) rle = 1;
+		else if (!strcmp(argv[a], "-at") && a + 1 < argc &&
+		         sscanf(argv[a + 1], "%d,%d", &x0, &y0) == 2) a++;
+		else break;
+	}
+
+	if (argc - a < 2 || x0 < 0 || y0 < 0 || x0 >= SCREEN_W || y0 >= SCREEN_H) {
+		fprintf(stderr, "uso: %s [-rle] [-at X,Y] puerto imagen.bmp [...]\n", argv[0]);
+		return 1;
+	}
+
+	int fd = open_port(argv[a]);
+	if (fd < 0) return 1;
+
+	// Lo ms grande posible: RLE sin ninguna repeticin
+	size_t    max_px = (size_t)SCREEN_W * SCREEN_H;
+	uint16_t *px = malloc(max_px * sizeof *px);
+	uint8_t  *frame = malloc(6 + max_px * 2 + (max_px + 127) / 128 + 2);
+	int       failed = 0;
+
+	for (int i = a + 1; i < argc; i++) {
+		Image img;
+		if (load_bmp(argv[i], &img) != 0) return 1;
+
+		int w = img.w < SCREEN_W - x0 ? img.w : SCREEN_W - x0;
+		int h = img.h < SCREEN_H - y0 ? img.h : SCREEN_H - y0;
+		size_t n = (size_t)w * h;
+
+		for (int y = 0; y < h; y++)
+			for (int x = 0; x < w; x++)
+				px[(size_t)y * w + x] = to565(&img.rgb[((size_t)y * img.w + x) * 3]);
+		free(img.rgb);
+
+		size_t len = 0;
+		frame[len++] = SYNC;
+		frame[len++] = rle ? TYPE_RLE : TYPE_RAW;
+		frame[len++] = (uint8_t)x0;
+		frame[len++] = (uint8_t)y0;
+		frame[len++] = (uint8_t)w;
+		frame[len++] = (uint8_t)h;
+		if (rle) {
+			len += encode_rle(px, n, frame + len);
+		} else {
+			for (size_t k = 0; k < n; k++)
+				len += put_pixel(frame + len, px[k]);
+		}
+
+		uint16_t crc = 0xFFFF;
+		for (size_t k = 1; k < len; k++)
+			crc = _crc_ccitt_update(crc, frame[k]);
+		frame[len++] = (uint8_t)crc;
+		frame[len++] = (uint8_t)(crc >> 8);
+
+		int reply = 0;
+		double t0 = now_s();
+		for (int tries = 0; tries < RETRIES && reply != ACK; tries++) {
+			if (tries) {
+				// Que el AVR descarte lo que le quede de la anterior
+				usleep(2 * TIMEOUT_MS * 1000);
+				tcflush(fd, TCIFLUSH);
+			}
+			if (write_all(fd, frame, len) != 0) {
+				perror(argv[a]);
+				return 1;
+			}
+			reply = wait_reply(fd);
+		}
+		double dt = now_s() - t0;
+
+		printf("%s: %dx%d en (%d,%d), %zu bytes (%s, %.0f%%), %c, %.2f s\n",
+		       argv[i], w, h, x0, y0, len, rle ? "RLE" : "RAW",
+		       100.0 * len / (6 + n * 2 + 2), reply ? reply : '-', dt);
+		if (reply != ACK) failed++;
+	}
+
+	free(px);
+	free(frame);
+	close(fd);
+	return failed ? 2 : 0;
+}
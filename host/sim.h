@@ -0,0 +1,73 @@
+// host/sim.h - Backend de simulacin para Linux
+//
+// Sustituye a spi_hal.c (y uart.c, ver host/uart_sim.c): implementa la interfaz de spi_hal.h sobre un
+// ST7735 virtual (framebuffer) y una tarjeta SD en modo SPI que sirve
+// sectores desde un archivo de imagen de disco.
+#ifndef HOST_SIM_H_
+#define HOST_SIM_H_
+
+#include <stdint.h>
+#include <stdio.h>
+
+typedef struct {
+	uint32_t spi_bytes;        // bytes totales por el bus
+	uint32_t tft_bytes;        // bytes con el CS del TFT activo
+	uint32_t sd_bytes;         // bytes con el CS de la SD activo
+	uint32_t tft_transactions; // flancos de bajada del CS del TFT
+	uint32_t sd_transactions;  // flancos de bajada del CS de la SD
+	uint32_t cs_toggles;       // cambios de cualquiera de los dos CS
+	uint32_t bus_conflicts;    // bytes con ambos CS activos
+	uint32_t tft_commands;
+	uint32_t tft_pixels;
+	uint32_t sd_commands;
+	uint32_t sd_blocks_read;
+	uint32_t sd_blocks_written;
+	uint32_t uart_rx_bytes;    // entregados a la ISR de recepcin
+	uint32_t uart_tx_bytes;
+	uint32_t uart_tx_lost;     // no cupieron en el pty
+} SIM_Stats;
+
+extern SIM_Stats g_sim;
+
+// Abre la imagen de disco (lectura/escritura). sdhc=1 simula una tarjeta
+// de alta capacidad (direccionamiento por bloque).
+int  SIM_Open(const char *image_path, int sdhc);
+void SIM_Close(void);
+
+void SIM_ResetStats(void);
+void SIM_PrintStats(FILE *out);
+
+// Vuelca lo que se ve en el panel (con scroll aplicado) como PPM binario
+int  SIM_DumpPPM(const char *path);
+
+// Pxel visible (x, y) en RGB565
+uint16_t SIM_GetPixel(uint8_t x, uint8_t y);
+
+// Cada byte que llega al TFT, con DC (1 = dato), antes de decodificarlo
+void SIM_SetTftTap(void (*tap)(uint8_t data, uint8_t dc));
+
+// Reloj de CPU simulado: avanza por cada byte SPI 8 x el divisor de
+// SPI_Init/SPI_SetClock ms SIM_SPI_LOOP_CYCLES (el bucle), y lo que
+// pidan _delay_ms/_delay_us. Mueve el Timer1 si est en marcha; 'isr'
+// hace de TIMER1_OVF_vect (cycles.c).
+#define SIM_SPI_LOOP_CYCLES  8
+void SIM_Advance(uint32_t cycles);
+void SIM_SetTimer1Isr(void (*isr)(void));
+
+// Timer0 en CTC: 'isr' hace de TIMER0_COMP_vect (buttons.c). SIM_Sleep es
+// el sleep_cpu() de host/avr/sleep.h: adelanta el reloj hasta la prxima
+// interrupcin, del Timer0 o de la USART (1 ms como mucho).
+void SIM_SetTimer0Isr(void (*isr)(void));
+void SIM_Sleep(void);
+
+// USART sobre un pseudoterminal (host/uart_sim.c). SIM_UartOpen devuelve
+// el nombre del esclavo, donde se conecta el host (host/sendimg.c), o
+// NULL. 'isr' hace de USART_RXC_vect (uart_stream.c); SIM_Advance le
+// entrega lo recibido con el ritmo de UART_STREAM_BAUD.
+#define SIM_UART_XOFF_LAG  16
+const char *SIM_UartOpen(void);
+void SIM_UartClose(void);
+void SIM_SetUsartRxIsr(void (*isr)(void));
+void SIM_UartAdvance(uint32_t cycles);
+
+#endif /* HOST_SIM_H_ */
@@ -0,0 +1,251 @@
+// host/sim_main.c - Ejecuta el firmware en Linux sobre el backend simulado
+//
+// Compilar desde la raz del proyecto (los mdulos no cambian: solo se
+// sustituyen spi_hal.c por host/spi_hal_sim.c, uart.c por host/uart_sim.c
+// y <avr/...> por host/):
+//
+//   gcc -std=gnu99 -O2 -Wall -Ihost -I. -o sim host/sim_main.c
+//       host/spi_hal_sim.c host/uart_sim.c sd_spi.c fat_fs.c bmp_stream.c
+//       tft_st7735.c frame_cache.c fractal.c fractal_kernel.c font5x7.c
+//       hud.c cycles.c prof.c anim.c pak.c uart_stream.c scratch.c
+//       buttons.c sprite.c
+//   (todo en una lnea)
+//   gcc -std=gnu99 -O2 -Wall -o mkimg host/mkimg.c
+//   gcc -std=gnu99 -O2 -Wall -o mkani host/mkani.c
+//   gcc -std=gnu99 -O2 -Wall -o mkpak host/mkpak.c
+//   gcc -std=gnu99 -O2 -Wall -o mkspr host/mkspr.c
+//   gcc -std=gnu99 -O2 -Wall -Ihost -o sendimg host/sendimg.c
+//   gcc -std=gnu99 -O2 -Wall -o ramplan host/ramplan.c
+//   gcc -std=gnu99 -O3 -Wall -pthread -I. -o fracref host/fracref.c fractal_kernel.c
+//   gcc -std=gnu99 -O2 -Wall -I. -o fkcheck host/fkcheck.c fractal_kernel.c
+//   gcc -std=gnu99 -O2 -Wall -Ihost -I. -o bgrcheck host/bgrcheck.c
+//       tft_st7735.c font5x7.c host/spi_hal_sim.c host/uart_sim.c
+//
+// Uso:
+//   sim [-hc] [-16] disco.img gallery OPS salida.ppm
+//       OPS: n (imagen siguiente, con la transicin; una animacin
+//       .ANI se reproduce entera), u d (pan de una imagen alta), h (HUD).
+//       Vuelca la pantalla final.
+//   sim [-hc] [-16] disco.img fractal TIPO OPS salida.ppm
+//       TIPO 0 = Mandelbrot, 1 = Julia. Dibuja la vista inicial y aplica
+//       OPS: u d l r (pan), i o (zoom), c (un paso de animacin de
+//       paleta), h (HUD), k m x (cursor: mostrarlo, moverlo 5,3 y
+//       quitarlo, con su fondo guardado). '-' para ninguna. El cursor es
+//       CURSOR.SPR si est en el disco y si no host/cursor_spr.h.
+//   sim [-hc] [-16] disco.img serial TRAMAS salida.ppm
+//       Abre un pseudoterminal e imprime su nombre por stdout: ah se
+//       conecta host/sendimg.c. Corre la galera hasta que llega una
+//       trama, como el bucle de main(), y despus recibe TRAMAS tramas.
+//
+// El Timer1 avanza con el reloj simulado (host/sim.h), as que los
+// tiempos del HUD y el regulador de fps de las animaciones funcionan.
+// -hc simula una tarjeta SDHC. -16 fuerza pxeles RGB565 en lugar del
+// formato de cada modo (VIEWER_COLOR_MODE / FRACTAL_COLOR_MODE). Tras cada paso se imprimen los contadores
+// del bus por stderr, una lnea por paso.
+//
+// Ejemplo:
+//   ./mkimg disco.img 8 FOTO.BMP FRACTAL.CAC:435200 FRACTAL.ITR:21504
+//   ./sim disco.img fractal 0 iid mandel.ppm
+
+#define main firmware_main
+#include "../main.c"
+#undef main
+
+#include "sim.h"
+#include "cycles.h"
+#include "sprite.h"
+#include <avr/pgmspace.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "cursor_spr.h"   // mkspr -c spr_cursor cursor.bmp host/cursor_spr.h
+
+void TIMER1_OVF_vect(void);   // ISR de cycles.c
+void TIMER0_COMP_vect(void);  // ISR de buttons.c
+void USART_RXC_vect(void);    // ISR de uart_stream.c
+
+static void print_step(const char *what)
+{
+	fprintf(stderr, "%s spi=%u tft_tx=%u sd_tx=%u cs=%u pixels=%u rd=%u wr=%u\n",
+	        what, g_sim.spi_bytes, g_sim.tft_transactions, g_sim.sd_transactions,
+	        g_sim.cs_toggles, g_sim.tft_pixels, g_sim.sd_blocks_read,
+	        g_sim.sd_blocks_written);
+}
+
+// Cursor sobre el fractal, con su fondo en un buffer
+static SPR_Sprite cursor;
+static uint16_t   cursor_px[SPR_MAX_W * 16];
+static SPR_Save   cursor_save = { .px = cursor_px, .cap = sizeof cursor_px / sizeof cursor_px[0] };
+static uint8_t    cursor_loaded;
+
+static void cursor_back(uint8_t x, uint8_t y, uint8_t w, uint16_t *out)
+{
+	FRACTAL_ReadPixels(&fractal_view, x, y, w, out);
+}
+
+static void cursor_op(char op)
+{
+	if (!cursor_loaded) {
+		if (!(okSD && okFAT && SPR_Open(&cursor, "CURSOR.SPR") == SPR_OK))
+			SPR_FromFlash(&cursor, spr_cursor);
+		cursor_loaded = 1;
+	}
+
+	uint8_t r = SPR_OK;
+	if (op == 'k')
+		r = SPR_Show(&cursor, &cursor_save, TFT_WIDTH / 2 - 6, TFT_HEIGHT / 2 - 11, cursor_back);
+	else if (op == 'm')
+		r = SPR_Move(&cursor, &cursor_save, cursor_save.x + 5, cursor_save.y + 3, cursor_back);
+	else
+		SPR_Hide(&cursor_save);
+	if (r != SPR_OK)
+		fprintf(stderr, "sprite: error %u\n", r);
+}
+
+static int usage(const char *argv0)
+{
+	fprintf(stderr, "uso: %s [-hc] [-16] disco.img gallery OPS salida.ppm\n"
+	                "     %s [-hc] [-16] disco.img fractal TIPO OPS salida.ppm\n"
+	                "     %s [-hc] [-16] disco.img serial TRAMAS salida.ppm\n",
+	        argv0, argv0, argv0);
+	return 1;
+}
+
+int main(int argc, char **argv)
+{
+	int sdhc = 0;
+	int rgb565 = 0;
+	int a = 1;
+
+	for (; a < argc && argv[a][0] == '-'; a++) {
+		if (strcmp(argv[a], "-hc") == 0) sdhc = 1;
+		else if (strcmp(argv[a], "-16") == 0) rgb565 = 1;
+		else return usage(argv[0]);
+	}
+	if (argc - a < 4) return usage(argv[0]);
+
+	const char *image = argv[a];
+	const char *what  = argv[a + 1];
+	int gallery = (strcmp(what, "gallery") == 0);
+	int serial  = (strcmp(what, "serial") == 0);
+
+	if (!gallery && !serial && (strcmp(what, "fractal") != 0 || argc - a != 5))
+		return usage(argv[0]);
+	if ((gallery || serial) && argc - a != 4)
+		return usage(argv[0]);
+
+	if (SIM_Open(image, sdhc) != 0) {
+		perror(image);
+		return 1;
+	}
+
+	// Botones sin pulsar (pull-up)
+	PINA = 0xFF;
+	PIND = 0xFF;
+
+	SIM_SetTimer1Isr(TIMER1_OVF_vect);
+	CYC_Init();
+
+	// Las esperas de main.c (idle_wait) cuentan los ticks del Timer0
+	SIM_SetTimer0Isr(TIMER0_COMP_vect);
+	BTN_Init();
+
+	SPI_Init(4);
+	TFT_Init();
+	if (!rgb565)
+		TFT_SetColorMode(gallery || serial ? VIEWER_COLOR_MODE : FRACTAL_COLOR_MODE);
+
+	if (serial) {
+		const char *pty = SIM_UartOpen();
+		if (!pty) {
+			perror("pty");
+			return 1;
+		}
+		printf("%s\n", pty);
+		fflush(stdout);
+
+		SIM_SetUsartRxIsr(USART_RXC_vect);
+		USTREAM_Init();
+
+		SIM_ResetStats();
+		while (!USTREAM_Waiting()) {
+			gallery_step();
+			idle_sleep();                // por si la galera est vaca
+		}
+		print_step("gallery");
+
+		stream_enter();
+		int total = atoi(argv[a + 2]);
+		SIM_ResetStats();
+		while (g_ustream_stats.frames + g_ustream_stats.errors < total) {
+			uint16_t ok = g_ustream_stats.frames, bad = g_ustream_stats.errors;
+
+			stream_step();
+			if (g_ustream_stats.frames != ok || g_ustream_stats.errors != bad) {
+				fprintf(stderr, "rx=%u ", g_sim.uart_rx_bytes);
+				print_step(g_ustream_stats.frames != ok ? "ok" : "rejected");
+				SIM_ResetStats();
+			}
+		}
+		fprintf(stderr, "stream frames=%u errors=%u overruns=%u xoffs=%u\n",
+		        g_ustream_stats.frames, g_ustream_stats.errors,
+		        g_ustream_stats.overruns, g_ustream_stats.xoffs);
+		SIM_UartClose();
+	} else if (gallery) {
+		for (const char *op = argv[a + 2]; *op && *op != '-'; op++) {
+			char name[2] = { *op, 0 };
+
+			SIM_ResetStats();
+			switch (*op) {
+			case 'n':
+				// Un tiempo de visualizacin completo: la imagen entra en
+				// el primer paso y los dems solo esperan
+				do gallery_step(); while (gallery_ticks != 0 || gallery_anim_on);
+				if (g_anim_stats.shown)
+					fprintf(stderr, "anim fps=%u.%u shown=%u dropped=%u\n",
+					        g_anim_stats.fps_x10 / 10, g_anim_stats.fps_x10 % 10,
+					        g_anim_stats.shown, g_anim_stats.dropped);
+				break;
+			case 'u': gallery_pan(-GALLERY_PAN_STEP); break;
+			case 'd': gallery_pan( GALLERY_PAN_STEP); break;
+			case 'h': hud_toggle(MODE_VIEWER); break;
+			default:
+				fprintf(stderr, "operacin desconocida: %c\n", *op);
+				break;
+			}
+			print_step(name);
+		}
+	} else {
+		FRACTAL_InitView(&fractal_view, (uint8_t)atoi(argv[a + 2]));
+
+		SIM_ResetStats();
+		fractal_step();
+		print_step("draw");
+
+		for (const char *op = argv[a + 3]; *op && *op != '-'; op++) {
+			char name[2] = { *op, 0 };
+
+			SIM_ResetStats();
+			switch (*op) {
+			case 'u': FRACTAL_Pan(&fractal_view, 0, -FRACTAL_PAN_STEP); break;
+			case 'd': FRACTAL_Pan(&fractal_view, 0,  FRACTAL_PAN_STEP); break;
+			case 'l': FRACTAL_Pan(&fractal_view, -FRACTAL_PAN_STEP, 0); break;
+			case 'r': FRACTAL_Pan(&fractal_view,  FRACTAL_PAN_STEP, 0); break;
+			case 'i': fractal_dirty = FRACTAL_Zoom(&fractal_view,  1); break;
+			case 'o': fractal_dirty = FRACTAL_Zoom(&fractal_view, -1); break;
+			case 'c': if (fractal_anim == RECOLOR_OFF) fractal_anim = RECOLOR_CYCLE; break;
+			case 'h': hud_toggle(MODE_FRACTAL); break;
+			case 'k': case 'm': case 'x': cursor_op(*op); break;
+			default:
+				fprintf(stderr, "operacin desconocida: %c\n", *op);
+				break;
+			}
+			fractal_step();
+			print_step(name);
+		}
+	}
+
+	SIM_DumpPPM(argv[argc - 1]);
+	SIM_Close();
+	return 0;
+}
@@ -0,0 +1,635 @@
+// host/spi_hal_sim.c - spi_hal.h para Linux: ST7735 virtual + SD sobre imagen
+//
+// Cada SPI_Transfer se entrega al dispositivo cuyo CS est activo:
+//  - TFT: se decodifica el flujo de comandos (CASET/RASET/RAMWR/MADCTL,
+//    COLMOD, VSCRDEF/VSCSAD) sobre una GRAM de 132x162.
+//  - SD: modelo del protocolo SPI (CMD0/8/12/16/17/18/24/55/58, ACMD41)
+//    que lee y escribe sectores en el archivo de imagen.
+
+#include "spi_hal.h"
+#include "sim.h"
+
+#include <string.h>
+
+#ifndef F_CPU
+#define F_CPU 8000000UL
+#endif
+
+// Registros "de mentira" que declara host/avr/io.h
+volatile uint8_t DDRA, PORTA, PINA;
+volatile uint8_t DDRB, PORTB, PINB;
+volatile uint8_t DDRC, PORTC, PINC;
+volatile uint8_t DDRD, PORTD, PIND;
+volatile uint8_t SPCR, SPSR, SPDR;
+volatile uint8_t SREG;
+volatile uint8_t  TCCR1A, TCCR1B, TIMSK, TIFR;
+volatile uint16_t TCNT1;
+volatile uint8_t  TCCR0, TCNT0, OCR0;
+volatile uint8_t UBRRH, UBRRL, UCSRB, UCSRC, UDR;
+volatile uint8_t UCSRA = (1 << UDRE);     // host/uart_sim.c
+
+SIM_Stats g_sim;
+
+static void (*timer1_isr)(void);
+static void (*tft_tap)(uint8_t data, uint8_t dc);
+static void (*timer0_isr)(void);
+static uint16_t timer0_prescaled;   // ciclos an sin llegar a un paso de TCNT0
+static uint32_t timer0_compares;    // interrupciones servidas
+static uint16_t spi_byte_cycles = 4 * 8 + SIM_SPI_LOOP_CYCLES;
+
+static uint8_t tft_cs_active;
+static uint8_t sd_cs_active;
+static uint8_t tft_dc_data;
+
+// =============================================================================
+// ST7735 virtual
+// =============================================================================
+
+#define GRAM_W 132
+#define GRAM_H 162
+
+#define ST_SWRESET 0x01
+#define ST_CASET   0x2A
+#define ST_RASET   0x2B
+#define ST_RAMWR   0x2C
+#define ST_VSCRDEF 0x33
+#define ST_MADCTL  0x36
+#define ST_VSCSAD  0x37
+#define ST_COLMOD  0x3A
+
+static struct {
+	uint16_t gram[GRAM_H][GRAM_W];
+	uint8_t  cmd;
+	uint8_t  nparam;
+	uint8_t  param[8];
+	uint16_t xs, xe, ys, ye;
+	uint16_t x, y;
+	uint8_t  madctl;
+	uint8_t  colmod;
+	uint16_t tfa, vsa, bfa;
+	uint16_t ssa;
+	uint8_t  pix[3];
+	uint8_t  npix;
+} st;
+
+static void ST_Reset(void)
+{
+	st.cmd = 0;
+	st.nparam = 0;
+	st.xs = 0; st.xe = GRAM_W - 1;
+	st.ys = 0; st.ye = GRAM_H - 1;
+	st.madctl = 0;
+	st.colmod = 0x06;
+	st.tfa = 0; st.vsa = GRAM_H; st.bfa = 0;
+	st.ssa = 0;
+	st.npix = 0;
+}
+
+static void ST_PutPixel(uint16_t rgb565)
+{
+	uint16_t px = st.x, py = st.y;
+
+	// MADCTL: MV intercambia ejes, MX/MY espejan
+	if (st.madctl & 0x20) { uint16_t t = px; px = py; py = t; }
+	if (st.madctl & 0x40) px = GRAM_W - 1 - px;
+	if (st.madctl & 0x80) py = GRAM_H - 1 - py;
+
+	if (px < GRAM_W && py < GRAM_H) st.gram[py][px] = rgb565;
+	g_sim.tft_pixels++;
+
+	// Avance dentro de la ventana, con vuelta al inicio como el chip real
+	if (++st.x > st.xe) {
+		st.x = st.xs;
+		if (++st.y > st.ye) st.y = st.ys;
+	}
+}
+
+static uint16_t RGB444_To565(uint16_t c)
+{
+	uint16_t r = (c >> 8) & 0x0F, g = (c >> 4) & 0x0F, b = c & 0x0F;
+	return (uint16_t)(((r << 1 | r >> 3) << 11) | ((g << 2 | g >> 2) << 5) | (b << 1 | b >> 3));
+}
+
+static void ST_Data(uint8_t d)
+{
+	if (st.cmd == ST_RAMWR) {
+		st.pix[st.npix++] = d;
+		if ((st.colmod & 0x07) == 0x03) {
+			// 12 bpp: 3 bytes = 2 pxeles RRRRGGGG BBBBRRRR GGGGBBBB.
+			// Cada pxel se escribe en cuanto llegan sus 12 bits.
+			if (st.npix == 2) {
+				ST_PutPixel(RGB444_To565((uint16_t)st.pix[0] << 4 | st.pix[1] >> 4));
+			} else if (st.npix == 3) {
+				ST_PutPixel(RGB444_To565((uint16_t)(st.pix[1] & 0x0F) << 8 | st.pix[2]));
+				st.npix = 0;
+			}
+		} else if (st.npix == 2) {
+			ST_PutPixel((uint16_t)st.pix[0] << 8 | st.pix[1]);
+			st.npix = 0;
+		}
+		return;
+	}
+
+	if (st.nparam < sizeof(st.param)) st.param[st.nparam] = d;
+	st.nparam++;
+
+	switch (st.cmd) {
+	case ST_CASET:
+		if (st.nparam == 4) {
+			st.xs = (uint16_t)st.param[0] << 8 | st.param[1];
+			st.xe = (uint16_t)st.param[2] << 8 | st.param[3];
+		}
+		break;
+	case ST_RASET:
+		if (st.nparam == 4) {
+			st.ys = (uint16_t)st.param[0] << 8 | st.param[1];
+			st.ye = (uint16_t)st.param[2] << 8 | st.param[3];
+		}
+		break;
+	case ST_MADCTL:
+		if (st.nparam == 1) st.madctl = d;
+		break;
+	case ST_COLMOD:
+		if (st.nparam == 1) st.colmod = d;
+		break;
+	case ST_VSCRDEF:
+		if (st.nparam == 6) {
+			st.tfa = (uint16_t)st.param[0] << 8 | st.param[1];
+			st.vsa = (uint16_t)st.param[2] << 8 | st.param[3];
+			st.bfa = (uint16_t)st.param[4] << 8 | st.param[5];
+		}
+		break;
+	case ST_VSCSAD:
+		if (st.nparam == 2) st.ssa = (uint16_t)st.param[0] << 8 | st.param[1];
+		break;
+	default:
+		break;
+	}
+}
+
+static void ST_Command(uint8_t c)
+{
+	g_sim.tft_commands++;
+	st.cmd = c;
+	st.nparam = 0;
+	st.npix = 0;
+
+	if (c == ST_RAMWR) {
+		st.x = st.xs;
+		st.y = st.ys;
+	} else if (c == ST_SWRESET) {
+		ST_Reset();
+	}
+}
+
+// Lnea de GRAM que se ve en la fila 'y' del panel
+static uint16_t ST_VisibleRow(uint16_t y)
+{
+	if (st.vsa == 0 || st.tfa + st.vsa + st.bfa != GRAM_H) return y;
+	if (y < st.tfa || y >= st.tfa + st.vsa) return y;
+
+	uint16_t first = (st.ssa >= st.tfa && st.ssa < st.tfa + st.vsa) ? st.ssa : st.tfa;
+	return st.tfa + (uint16_t)((first - st.tfa + (y - st.tfa)) % st.vsa);
+}
+
+uint16_t SIM_GetPixel(uint8_t x, uint8_t y)
+{
+	if (x >= GRAM_W || y >= GRAM_H) return 0;
+	return st.gram[ST_VisibleRow(y)][x];
+}
+
+int SIM_DumpPPM(const char *path)
+{
+	FILE *f = fopen(path, "wb");
+	if (!f) return -1;
+
+	fprintf(f, "P6\n%d %d\n255\n", GRAM_W, GRAM_H);
+	for (uint16_t y = 0; y < GRAM_H; y++) {
+		for (uint16_t x = 0; x < GRAM_W; x++) {
+			uint16_t c = SIM_GetPixel((uint8_t)x, (uint8_t)y);
+			uint8_t rgb[3];
+			rgb[0] = (uint8_t)(((c >> 11) & 0x1F) * 255 / 31);
+			rgb[1] = (uint8_t)(((c >> 5) & 0x3F) * 255 / 63);
+			rgb[2] = (uint8_t)((c & 0x1F) * 255 / 31);
+			fwrite(rgb, 1, 3, f);
+		}
+	}
+	return fclose(f);
+}
+
+// =============================================================================
+// Tarjeta SD en modo SPI
+// =============================================================================
+
+#define SD_QUEUE 1024
+
+static struct {
+	FILE    *img;
+	uint32_t blocks;
+	int      sdhc;
+	uint8_t  idle;
+	uint8_t  app_cmd;
+	uint8_t  acmd41_calls;
+
+	uint8_t  cmd[6];
+	uint8_t  ncmd;
+
+	uint8_t  q[SD_QUEUE];     // bytes pendientes hacia MISO
+	uint16_t q_head, q_len;
+
+	uint8_t  reading_multi;
+	uint32_t next_block;
+
+	uint8_t  writing;         // 1: esperando token, 2: recibiendo datos
+	uint32_t write_block;
+	uint8_t  wbuf[512 + 2];
+	uint16_t wpos;
+} sd;
+
+static void SD_Push(uint8_t b)
+{
+	if (sd.q_len < SD_QUEUE) sd.q[(sd.q_head + sd.q_len++) % SD_QUEUE] = b;
+}
+
+static uint8_t SD_Pop(void)
+{
+	if (!sd.q_len) return 0xFF;
+	uint8_t b = sd.q[sd.q_head];
+	sd.q_head = (sd.q_head + 1) % SD_QUEUE;
+	sd.q_len--;
+	return b;
+}
+
+static uint8_t SD_R1(uint8_t flags)
+{
+	return (uint8_t)(flags | (sd.idle ? 0x01 : 0x00));
+}
+
+static int SD_QueueBlock(uint32_t block)
+{
+	uint8_t data[512];
+
+	if (block >= sd.blocks) return -1;
+	fseek(sd.img, (long)block * 512L, SEEK_SET);
+	if (fread(data, 1, 512, sd.img) != 512) memset(data, 0, 512);
+
+	SD_Push(0xFF);                 // Nac
+	SD_Push(0xFE);                 // token de inicio
+	for (int i = 0; i < 512; i++) SD_Push(data[i]);
+	SD_Push(0xFF);                 // CRC
+	SD_Push(0xFF);
+	g_sim.sd_blocks_read++;
+	return 0;
+}
+
+static uint32_t SD_ArgToBlock(uint32_t arg)
+{
+	return sd.sdhc ? arg : arg / 512;
+}
+
+static void SD_Execute(void)
+{
+	uint8_t  cmd = sd.cmd[0] & 0x3F;
+	uint32_t arg = (uint32_t)sd.cmd[1] << 24 | (uint32_t)sd.cmd[2] << 16 |
+	(uint32_t)sd.cmd[3] << 8 | sd.cmd[4];
+	uint8_t  app = sd.app_cmd;
+
+	g_sim.sd_commands++;
+	sd.app_cmd = 0;
+	sd.q_len = 0;
+
+	SD_Push(0xFF);                 // Ncr
+
+	if (app && cmd == 41) {
+		// Dos respuestas "ocupada" antes de salir de idle
+		if (++sd.acmd41_calls >= 3) sd.idle = 0;
+		SD_Push(SD_R1(0));
+		return;
+	}
+
+	switch (cmd) {
+	case 0:
+		sd.idle = 1;
+		sd.acmd41_calls = 0;
+		sd.reading_multi = 0;
+		sd.writing = 0;
+		SD_Push(0x01);
+		break;
+	case 8:
+		SD_Push(SD_R1(0));
+		SD_Push(0x00); SD_Push(0x00);
+		SD_Push(sd.cmd[3]);
+		SD_Push(sd.cmd[4]);
+		break;
+	case 12:
+		sd.reading_multi = 0;
+		SD_Push(0xFF);             // byte de relleno tras CMD12
+		SD_Push(SD_R1(0));
+		SD_Push(0x00);             // ocupado un momento
+		break;
+	case 16:
+		SD_Push(SD_R1(arg == 512 || sd.sdhc ? 0 : 0x40));
+		break;
+	case 17:
+	case 18: {
+		uint32_t b = SD_ArgToBlock(arg);
+		if (sd.idle || b >= sd.blocks) { SD_Push(SD_R1(0x40)); break; }
+		SD_Push(0x00);
+		SD_QueueBlock(b);
+		if (cmd == 18) {
+			sd.reading_multi = 1;
+			sd.next_block = b + 1;
+		}
+		break;
+	}
+	case 24: {
+		uint32_t b = SD_ArgToBlock(arg);
+		if (sd.idle || b >= sd.blocks) { SD_Push(SD_R1(0x40)); break; }
+		SD_Push(0x00);
+		sd.writing = 1;
+		sd.write_block = b;
+		sd.wpos = 0;
+		break;
+	}
+	case 55:
+		sd.app_cmd = 1;
+		SD_Push(SD_R1(0));
+		break;
+	case 58:
+		SD_Push(SD_R1(0));
+		SD_Push((uint8_t)((sd.idle ? 0x00 : 0x80) | (sd.sdhc ? 0x40 : 0x00)));
+		SD_Push(0xFF); SD_Push(0x80); SD_Push(0x00);
+		break;
+	default:
+		SD_Push(SD_R1(0x04));      // comando ilegal
+		break;
+	}
+}
+
+static uint8_t SD_Byte(uint8_t mosi)
+{
+	uint8_t miso = SD_Pop();
+
+	if (sd.writing == 1) {
+		if (mosi == 0xFE) sd.writing = 2;
+		return miso;
+	}
+	if (sd.writing == 2) {
+		sd.wbuf[sd.wpos++] = mosi;
+		if (sd.wpos == sizeof(sd.wbuf)) {
+			fseek(sd.img, (long)sd.write_block * 512L, SEEK_SET);
+			fwrite(sd.wbuf, 1, 512, sd.img);
+			fflush(sd.img);
+			g_sim.sd_blocks_written++;
+			sd.writing = 0;
+			SD_Push(0x05);         // data accepted
+			SD_Push(0x00);         // programando...
+			SD_Push(0x00);
+		}
+		return miso;
+	}
+
+	if (sd.ncmd) {
+		sd.cmd[sd.ncmd++] = mosi;
+		if (sd.ncmd == 6) {
+			sd.ncmd = 0;
+			SD_Execute();
+		}
+	} else if ((mosi & 0xC0) == 0x40) {
+		sd.cmd[0] = mosi;
+		sd.ncmd = 1;
+	}
+
+	if (sd.reading_multi && sd.q_len == 0 && sd.ncmd == 0) {
+		if (SD_QueueBlock(sd.next_block) == 0) sd.next_block++;
+		else sd.reading_multi = 0;
+	}
+
+	return miso;
+}
+
+int SIM_Open(const char *image_path, int sdhc)
+{
+	memset(&sd, 0, sizeof(sd));
+	ST_Reset();
+
+	sd.img = fopen(image_path, "r+b");
+	if (!sd.img) return -1;
+
+	fseek(sd.img, 0, SEEK_END);
+	sd.blocks = (uint32_t)(ftell(sd.img) / 512);
+	sd.sdhc = sdhc;
+	sd.idle = 1;
+	return 0;
+}
+
+void SIM_Close(void)
+{
+	if (sd.img) fclose(sd.img);
+	sd.img = NULL;
+}
+
+void SIM_ResetStats(void)
+{
+	memset(&g_sim, 0, sizeof(g_sim));
+}
+
+void SIM_PrintStats(FILE *out)
+{
+	fprintf(out, "spi_bytes=%u\n",         g_sim.spi_bytes);
+	fprintf(out, "tft_bytes=%u\n",         g_sim.tft_bytes);
+	fprintf(out, "sd_bytes=%u\n",          g_sim.sd_bytes);
+	fprintf(out, "tft_transactions=%u\n",  g_sim.tft_transactions);
+	fprintf(out, "sd_transactions=%u\n",   g_sim.sd_transactions);
+	fprintf(out, "cs_toggles=%u\n",        g_sim.cs_toggles);
+	fprintf(out, "bus_conflicts=%u\n",     g_sim.bus_conflicts);
+	fprintf(out, "tft_commands=%u\n",      g_sim.tft_commands);
+	fprintf(out, "tft_pixels=%u\n",        g_sim.tft_pixels);
+	fprintf(out, "sd_commands=%u\n",       g_sim.sd_commands);
+	fprintf(out, "sd_blocks_read=%u\n",    g_sim.sd_blocks_read);
+	fprintf(out, "sd_blocks_written=%u\n", g_sim.sd_blocks_written);
+	fprintf(out, "uart_rx_bytes=%u\n",     g_sim.uart_rx_bytes);
+	fprintf(out, "uart_tx_bytes=%u\n",     g_sim.uart_tx_bytes);
+	fprintf(out, "uart_tx_lost=%u\n",      g_sim.uart_tx_lost);
+}
+
+// =============================================================================
+// Interfaz de spi_hal.h
+// =============================================================================
+
+void SPI_Init(uint8_t clock_div)
+{
+	tft_cs_active = 0;
+	sd_cs_active = 0;
+	SPI_SetClock(clock_div);
+}
+
+void SPI_SetClock(uint8_t clock_div)
+{
+	if (clock_div < 2 || clock_div > 128) clock_div = 128;
+	spi_byte_cycles = (uint16_t)(clock_div * 8 + SIM_SPI_LOOP_CYCLES);
+}
+
+void SIM_SetTimer1Isr(void (*isr)(void))
+{
+	timer1_isr = isr;
+}
+
+void SIM_SetTimer0Isr(void (*isr)(void))
+{
+	timer0_isr = isr;
+}
+
+// Divisor de CS02:CS00; 0 si est parado o con reloj externo
+static uint16_t timer0_div(void)
+{
+	static const uint16_t div[8] = { 0, 1, 8, 64, 256, 1024, 0, 0 };
+	return div[TCCR0 & ((1 << CS02) | (1 << CS01) | (1 << CS00))];
+}
+
+// Solo el modo CTC: al llegar a OCR0, vuelta a 0 y TIMER0_COMP_vect
+static void timer0_advance(uint32_t cycles)
+{
+	uint16_t div = timer0_div();
+	if (!div) return;
+
+	cycles += timer0_prescaled;
+	timer0_prescaled = (uint16_t)(cycles % div);
+
+	for (uint32_t steps = cycles / div; steps; ) {
+		uint32_t room = (uint32_t)(uint8_t)(OCR0 - TCNT0) + 1;
+		if (steps < room) {
+			TCNT0 = (uint8_t)(TCNT0 + steps);
+			return;
+		}
+		steps -= room;
+		TCNT0 = 0;
+		if ((TIMSK & (1 << OCIE0)) && timer0_isr) {
+			timer0_compares++;
+			timer0_isr();
+		}
+	}
+}
+
+// Despierta con la primera interrupcin: la comparacin del Timer0 o un
+// byte recibido (se mira cada SIM_SLEEP_STEP ciclos). 1 ms como mucho.
+#define SIM_SLEEP_STEP  (F_CPU / 100000UL)
+
+void SIM_Sleep(void)
+{
+	uint32_t compares = timer0_compares, rx = g_sim.uart_rx_bytes;
+
+	for (uint32_t t = 0; t < F_CPU / 1000UL; ) {
+		uint32_t step = SIM_SLEEP_STEP;
+		uint16_t div = timer0_div();
+
+		if (div) {
+			uint32_t left = ((uint32_t)(uint8_t)(OCR0 - TCNT0) + 1) * div - timer0_prescaled;
+			if (left < step) step = left;
+		}
+		SIM_Advance(step);
+		t += step;
+		if (timer0_compares != compares || g_sim.uart_rx_bytes != rx) return;
+	}
+}
+
+void SIM_Advance(uint32_t cycles)
+{
+	SIM_UartAdvance(cycles);
+	timer0_advance(cycles);
+
+	if (!(TCCR1B & (1 << CS10))) return;   // Timer1 parado
+
+	// La ISR corre en el acto: nunca queda un desborde pendiente (y en
+	// el AVR escribir 1 en TOV1 lo borra, aqu lo dejara puesto)
+	TIFR = 0;
+
+	while (cycles) {
+		uint32_t room = 0x10000UL - TCNT1;
+		if (cycles < room) {
+			TCNT1 = (uint16_t)(TCNT1 + cycles);
+			return;
+		}
+		cycles -= room;
+		TCNT1 = 0;
+		if (timer1_isr) timer1_isr();
+	}
+}
+
+uint8_t SPI_Transfer(uint8_t data)
+{
+	uint8_t miso = 0xFF;
+
+	SIM_Advance(spi_byte_cycles);
+	g_sim.spi_bytes++;
+	if (tft_cs_active && sd_cs_active) g_sim.bus_conflicts++;
+
+	if (tft_cs_active) {
+		g_sim.tft_bytes++;
+		if (tft_tap) tft_tap(data, tft_dc_data);
+		if (tft_dc_data) ST_Data(data);
+		else             ST_Command(data);
+	}
+	if (sd_cs_active) {
+		g_sim.sd_bytes++;
+		miso = SD_Byte(data);
+	}
+
+	return miso;
+}
+
+// El envo solapado del AVR aqu es una transferencia normal: sin el
+// registro de verdad no hay nada que esperar
+void SPI_Start(uint8_t data) { (void)SPI_Transfer(data); }
+void SPI_Wait(void)          { }
+void SPI_Finish(void)        { }
+
+void SIM_SetTftTap(void (*tap)(uint8_t data, uint8_t dc))
+{
+	tft_tap = tap;
+}
+
+void SPI_TFT_Select(void)
+{
+	if (!tft_cs_active) {
+		g_sim.tft_transactions++;
+		g_sim.cs_toggles++;
+	}
+	tft_cs_active = 1;
+}
+
+void SPI_TFT_Unselect(void)
+{
+	if (tft_cs_active) g_sim.cs_toggles++;
+	tft_cs_active = 0;
+}
+
+void SPI_SD_Select(void)
+{
+	if (!sd_cs_active) {
+		g_sim.sd_transactions++;
+		g_sim.cs_toggles++;
+	}
+	sd_cs_active = 1;
+}
+
+void SPI_SD_Unselect(void)
+{
+	if (sd_cs_active) g_sim.cs_toggles++;
+	sd_cs_active = 0;
+}
+
+void TFT_DC_Command(void)
+{
+	tft_dc_data = 0;
+}
+
+void TFT_DC_Data(void)
+{
+	tft_dc_data = 1;
+}
+
+void TFT_Reset_Pulse(void)
+{
+	ST_Reset();
+}
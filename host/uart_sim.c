@@ -0,0 +1,143 @@
+// host/uart_sim.c - uart.h para Linux: la USART sobre un pseudoterminal
+//
+// Sustituye a uart.c. Lo que transmite el firmware sale por el maestro
+// del pty (o se descarta si no hay ninguno abierto). Lo que el host
+// escribe en el esclavo llega a la ISR de recepcin (SIM_SetUsartRxIsr)
+// a UART_STREAM_BAUD: un byte cada 10 bits de reloj simulado, desde
+// SIM_Advance.
+//
+// El control de flujo se modela en el cable: tras mandar XOFF el firmware
+// an recibe SIM_UART_XOFF_LAG bytes (lo que tardara en parar el host)
+// y luego nada hasta el XON. El pty adems se lo pasa al emisor.
+
+#define _GNU_SOURCE        // posix_openpt, cfmakeraw
+#include "uart.h"
+#include "sim.h"
+#include <avr/io.h>
+
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <termios.h>
+#include <unistd.h>
+
+#ifndef F_CPU
+#define F_CPU 8000000UL
+#endif
+
+#define XON   0x11
+#define XOFF  0x13
+
+static int      uart_fd = -1;       // maestro del pty
+static int      uart_slave = -1;    // abierto aqu para que el maestro no vea EOF
+static uint32_t uart_byte_cycles;   // 0: recepcin apagada
+static uint32_t uart_elapsed;
+static uint8_t  uart_paused;
+static uint16_t uart_lag;
+static void   (*uart_rx_isr)(void);
+
+const char *SIM_UartOpen(void)
+{
+	uart_fd = posix_openpt(O_RDWR | O_NOCTTY);
+	if (uart_fd < 0 || grantpt(uart_fd) != 0 || unlockpt(uart_fd) != 0)
+		return NULL;
+
+	const char *name = ptsname(uart_fd);
+	uart_slave = open(name, O_RDWR | O_NOCTTY);
+	if (uart_slave < 0) return NULL;
+
+	struct termios t;
+	tcgetattr(uart_slave, &t);
+	cfmakeraw(&t);
+	tcsetattr(uart_slave, TCSANOW, &t);
+
+	fcntl(uart_fd, F_SETFL, fcntl(uart_fd, F_GETFL) | O_NONBLOCK);
+	return name;
+}
+
+void SIM_UartClose(void)
+{
+	if (uart_slave >= 0) close(uart_slave);
+	if (uart_fd >= 0) close(uart_fd);
+	uart_slave = uart_fd = -1;
+}
+
+void SIM_SetUsartRxIsr(void (*isr)(void))
+{
+	uart_rx_isr = isr;
+}
+
+void SIM_UartAdvance(uint32_t cycles)
+{
+	if (uart_fd < 0 || !uart_byte_cycles || !(UCSRB & (1<<RXEN))) return;
+
+	uart_elapsed += cycles;
+	while (uart_elapsed >= uart_byte_cycles) {
+		uint8_t b;
+
+		if (uart_paused && uart_lag == 0) break;
+		if (read(uart_fd, &b, 1) != 1) {
+			uart_elapsed = 0;            // lnea en reposo
+			return;
+		}
+		uart_elapsed -= uart_byte_cycles;
+		if (uart_paused) uart_lag--;
+
+		g_sim.uart_rx_bytes++;
+		UDR = b;
+		UCSRA |= (1<<RXC);
+		if ((UCSRB & (1<<RXCIE)) && uart_rx_isr) uart_rx_isr();
+		UCSRA &= (uint8_t)~(1<<RXC);
+	}
+	if (uart_elapsed > uart_byte_cycles) uart_elapsed = uart_byte_cycles;
+}
+
+void UART_Init(void)
+{
+	uart_byte_cycles = 0;
+}
+
+void UART_InitStream(void)
+{
+	UCSRA = (1<<UDRE);
+	UCSRB = (1<<RXCIE) | (1<<RXEN) | (1<<TXEN);
+	uart_byte_cycles = (uint32_t)(F_CPU * 10 / UART_STREAM_BAUD);
+	uart_elapsed = 0;
+	uart_paused = 0;
+}
+
+void UART_PutChar(char c)
+{
+	uint8_t b = (uint8_t)c;
+
+	if (b == XOFF) {
+		uart_paused = 1;
+		uart_lag = SIM_UART_XOFF_LAG;
+	} else if (b == XON) {
+		uart_paused = 0;
+	}
+
+	g_sim.uart_tx_bytes++;
+	if (uart_fd >= 0 && write(uart_fd, &b, 1) != 1)
+		g_sim.uart_tx_lost++;
+}
+
+void UART_PutString(const char *s)
+{
+	while (*s)
+		UART_PutChar(*s++);
+}
+
+void UART_PutU32(uint32_t v)
+{
+	char digits[10];
+	uint8_t n = 0;
+
+	do {
+		digits[n++] = (char)('0' + v % 10);
+		v /= 10;
+	} while (v);
+
+	while (n)
+		UART_PutChar(digits[--n]);
+}
@@ -0,0 +1,17 @@
+// host/util/crc16.h - _crc_ccitt_update de avr-libc en C
+//
+// La misma cuenta que la versin en ensamblador de <util/crc16.h>
+// (est as en su documentacin).
+#ifndef HOST_UTIL_CRC16_H_
+#define HOST_UTIL_CRC16_H_
+
+#include <stdint.h>
+
+static inline uint16_t _crc_ccitt_update(uint16_t crc, uint8_t data)
+{
+	data ^= (uint8_t)crc;
+	data ^= (uint8_t)(data << 4);
+	return (uint16_t)((((uint16_t)data << 8) | (crc >> 8)) ^ (uint8_t)(data >> 4) ^ ((uint16_t)data << 3));
+}
+
+#endif /* HOST_UTIL_CRC16_H_ */
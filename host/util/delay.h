@@ -0,0 +1,16 @@
+// host/util/delay.h - Retardos de avr-libc: solo adelantan el reloj simulado
+#ifndef HOST_UTIL_DELAY_H_
+#define HOST_UTIL_DELAY_H_
+
+#include <stdint.h>
+
+#ifndef F_CPU
+#define F_CPU 8000000UL
+#endif
+
+void SIM_Advance(uint32_t cycles);   // host/spi_hal_sim.c
+
+static inline void _delay_ms(double ms) { SIM_Advance((uint32_t)(ms * (F_CPU / 1000UL))); }
+static inline void _delay_us(double us) { SIM_Advance((uint32_t)(us * (F_CPU / 1000000UL))); }
+
+#endif /* HOST_UTIL_DELAY_H_ */
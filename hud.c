@@ -0,0 +1,97 @@
+// hud.c
+#include "hud.h"
+#include "cycles.h"
+#include "sd_spi.h"
+#include "frame_cache.h"
+#include "fractal.h"
+#include "anim.h"
+#include <avr/interrupt.h>
+
+#ifndef F_CPU
+#define F_CPU 8000000UL
+#endif
+
+#define HUD_CYCLES_PER_MS  (F_CPU / 1000UL)
+#define HUD_MAX_CHARS      (TFT_WIDTH / TFT_CHAR_W)
+
+static uint8_t  hud_on;
+static uint32_t hud_t0;
+static uint32_t hud_sd0;
+static uint32_t hud_it0;
+static uint32_t hud_an0;
+static uint32_t hud_dr0;
+
+void HUD_Init(void)
+{
+	CYC_Init();
+	sei();
+}
+
+void HUD_Enable(uint8_t on)
+{
+	hud_on = on;
+}
+
+uint8_t HUD_Enabled(void)
+{
+	return hud_on;
+}
+
+void HUD_Begin(void)
+{
+	hud_t0  = CYC_Now();
+	hud_sd0 = g_sd_stats.blocks_read;
+	hud_it0 = FRACTAL_IterCount();
+	hud_an0 = g_anim_stats.shown;
+	hud_dr0 = g_anim_stats.dropped;
+}
+
+// Aade 'c' y el nmero en decimal; devuelve la nueva posicin
+static uint8_t HUD_Field(char *out, uint8_t pos, char c, uint32_t v)
+{
+	char digits[10];
+	uint8_t n = 0;
+
+	do {
+		digits[n++] = (char)('0' + v % 10);
+		v /= 10;
+	} while (v);
+
+	if (pos + 2 + n > HUD_MAX_CHARS) return pos;
+
+	if (pos) out[pos++] = ' ';
+	out[pos++] = c;
+	while (n) out[pos++] = digits[--n];
+	return pos;
+}
+
+void HUD_End(void)
+{
+	if (!hud_on) return;
+
+	uint32_t ms    = (CYC_Now() - hud_t0) / HUD_CYCLES_PER_MS;
+	uint32_t iters = FRACTAL_IterCount() - hud_it0;
+	uint16_t hit   = g_fcache_stats.lookups
+	               ? (uint16_t)((uint32_t)g_fcache_stats.hits * 100 / g_fcache_stats.lookups)
+	               : 0;
+
+	char line[HUD_MAX_CHARS + 1];
+	uint8_t pos = 0;
+
+	pos = HUD_Field(line, pos, 'T', ms);
+	pos = HUD_Field(line, pos, 'S', g_sd_stats.blocks_read - hud_sd0);
+	if (g_anim_stats.shown != hud_an0) {
+		// Animacin: fps de la ltima vuelta y fotogramas saltados
+		pos = HUD_Field(line, pos, 'F', g_anim_stats.fps_x10 / 10);
+		pos = HUD_Field(line, pos, 'D', g_anim_stats.dropped - hud_dr0);
+	} else {
+		pos = HUD_Field(line, pos, 'H', hit);
+		pos = HUD_Field(line, pos, 'I', ms ? iters / ms : 0);   // iter/ms = miles/s
+	}
+
+	// Rellenar hasta el ancho de la banda: tapa el texto anterior
+	while (pos < HUD_MAX_CHARS) line[pos++] = ' ';
+	line[pos] = 0;
+
+	TFT_DrawString(0, 0, line, HUD_FG, HUD_BG);
+}
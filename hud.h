@@ -0,0 +1,29 @@
+// hud.h - Banda de diagnstico sobre la pantalla
+#ifndef HUD_H_
+#define HUD_H_
+
+#include <stdint.h>
+#include "tft_st7735.h"
+
+// Una lnea de texto en las filas de arriba de la pantalla:
+//   T<ms> S<sectores> H<aciertos %> I<miles de iteraciones/s>
+// T y S son del ltimo fotograma medido, H es la tasa de aciertos de la
+// cach de fotogramas desde el arranque. Si entre HUD_Begin y HUD_End se
+// mostr una animacin, H e I se cambian por F<fps> D<saltados>.
+#define HUD_ROWS  TFT_CHAR_H
+
+#define HUD_FG    0xFFE0   // amarillo
+#define HUD_BG    0x0000
+
+// Arranca el Timer1 (cycles.c); habilita interrupciones
+void HUD_Init(void);
+
+void    HUD_Enable(uint8_t on);
+uint8_t HUD_Enabled(void);
+
+// Marcan el principio y el final de un fotograma. HUD_End redibuja la
+// banda si el HUD est activo.
+void HUD_Begin(void);
+void HUD_End(void);
+
+#endif /* HUD_H_ */
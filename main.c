@@ -1,10 +1,12 @@
 /*
  * SD_TFT_TEST.c
- * main.c - SD + TFT + BMP dinmico + Mandelbrot/Julia estticos + botones PD0/PD1
+ * main.c - SD + TFT + BMP dinmico + Mandelbrot/Julia con pan/zoom + botones
  */
 
 #define F_CPU 8000000UL
 #include <avr/io.h>
+#include <avr/interrupt.h>
+#include <avr/sleep.h>
 #include <util/delay.h>
 #include <stdint.h>
 #include <string.h>
@@ -14,6 +16,15 @@
 #include "fat_fs.h"
 #include "bmp_stream.h"
 #include "tft_st7735.h"
+#include "frame_cache.h"
+#include "fractal.h"
+#include "prof.h"
+#include "hud.h"
+#include "anim.h"
+#include "pak.h"
+#include "uart_stream.h"
+#include "scratch.h"
+#include "buttons.h"
 
 /* ==========================================================
    DECLARACIN DE FUNCIN NUEVA DE fat_fs.c
@@ -27,400 +38,715 @@ uint8_t FAT_ListBMP(char names[][13], uint8_t max_files);
    BOTONES Y MODOS
    ========================================================== */
 
-// BOTN DE CAMBIO DE MODO GENERAL (viewer <-> fractal)
-#define BTN_MODE_PORT     PORTD
-#define BTN_MODE_PINREG   PIND
-#define BTN_MODE_DDR      DDRD
-#define BTN_MODE_BIT      PD0   // botn en PD0
-
-// BOTN DE CAMBIO DE TIPO DE FRACTAL (Mandelbrot <-> Julia)
-#define BTN_FRACTAL_PORT   PORTD
-#define BTN_FRACTAL_PINREG PIND
-#define BTN_FRACTAL_DDR    DDRD
-#define BTN_FRACTAL_BIT    PD1   // botn en PD1
+// Pines de los botones: board.h; eventos: buttons.h
 
 #define MODE_VIEWER    0
 #define MODE_FRACTAL   1
-
-#define FRACTAL_MANDEL 0
-#define FRACTAL_JULIA  1
-
-/* ==========================================================
-   COLORACIN MANDELBROT (paleta que ya tenas)
-   ========================================================== */
-
-static uint16_t color_from_iter_mandel(uint8_t iter, uint8_t max_iter)
+#define MODE_STREAM    2   // imgenes por la USART; se sale con el botn de modo
+
+// Formato de pxel de cada modo: TFT_COLOR_444 enva 1,5 bytes por pxel
+// en lugar de 2. Las fotos con degradados suaves se ven mejor en 565.
+#define VIEWER_COLOR_MODE   TFT_COLOR_444
+#define FRACTAL_COLOR_MODE  TFT_COLOR_444
+#define STREAM_COLOR_MODE   TFT_COLOR_565   // los pxeles llegan en 565
+
+// Espera sin nada que hacer: modo idle hasta la prxima interrupcin (el
+// tick de los botones, 1 ms, o un byte de la USART). Se comprueba con las
+// interrupciones cortadas para no dormirse con un evento ya en la cola.
+static void idle_sleep(void)
 {
-    if (iter >= max_iter) {
-        // Interior del conjunto: negro para mximo contraste
-        return 0x0000;
+    cli();
+    if (BTN_Pending() || USTREAM_Pending()) {
+        sei();
+        return;
     }
+    sleep_enable();
+    sei();                  // la instruccin siguiente se ejecuta siempre
+    sleep_cpu();
+    sleep_disable();
+}
 
-    // Normalizar iter a 0..255
-    uint16_t t0 = (uint16_t)iter * 255 / max_iter;  // 0..255
-    // Hacemos que el color "cicle" 3 veces a lo largo de las iteraciones
-    uint8_t t = (uint8_t)((t0 * 3) & 0xFF);         // 0..255, con 3 bandas
-
-    uint8_t r, g, b;
+// Hasta 'ms' durmiendo; 1 si la corta una pulsacin o un byte de la USART
+static uint8_t idle_wait(uint16_t ms)
+{
+    uint16_t t0 = BTN_Ticks();
 
-    if (t < 85) {
-        // Azul (0,0,128) -> Cian (0,255,255)
-        r = 0;
-        g = (uint8_t)(3 * t);                      // ~0..255
-        b = 128 + (uint8_t)(t * 127 / 85);         // 128..255
-    }
-    else if (t < 170) {
-        uint8_t tt = t - 85;
-        // Cian (0,255,255) -> Amarillo (255,255,0)
-        r = (uint8_t)(3 * tt);                     // 0..255
-        g = 255;
-        b = (uint8_t)(255 - 3 * tt);               // 255..0
+    while ((uint16_t)(BTN_Ticks() - t0) < ms) {
+        if (BTN_Pending() || USTREAM_Pending())
+            return 1;
+        idle_sleep();
     }
-    else {
-        uint8_t tt = t - 170;
-        // Amarillo (255,255,0) -> Blanco (255,255,255)
-        r = 255;
-        g = 255;
-        b = (uint8_t)(tt * 3);                     // 0..255
-    }
-
-    // Convertir a RGB565
-    uint16_t color =
-        ((r & 0xF8) << 8) |
-        ((g & 0xFC) << 3) |
-        ((b & 0xF8) >> 3);
-
-    return color;
+    return 0;
 }
 
 /* ==========================================================
-   COLORACIN JULIA (paleta clsica distinta)
+   ALMACENAMIENTO: SD + FAT, compartido por galera y fractal
    ========================================================== */
 
-static uint16_t color_from_iter_julia(uint8_t iter, uint8_t max_iter)
-{
-    if (iter >= max_iter)
-        return 0x0000; // interior negro
+static uint8_t okSD = 0, okFAT = 0;
 
-    // Normalizar 0..255
-    uint16_t t = (uint16_t)iter * 255 / max_iter;
+static void storage_init(void)
+{
+    static uint8_t init = 0;
+    if (init) return;
 
-    uint8_t r, g, b;
+    uint8_t s = SD_Init();
+    okSD = (s == SD_OK);
 
-    if (t < 32) {
-        // Negro -> violeta oscuro
-        r = 20;
-        g = 0;
-        b = (uint8_t)(t * 8);              // 0..255
+    if (okSD && FAT_Init() == 0) {
+        okFAT = 1;
+        FCACHE_Init();          // opcional: sin FRACTAL.CAC se calcula siempre
+        FRACTAL_InitStorage();  // opcional: sin FRACTAL.TMP no hay render progresivo
     }
-    else if (t < 64) {
-        // Violeta -> prpura brillante
-        uint8_t k = t - 32;
-        r = (uint8_t)(40 + k * 3);         // ~40..136
-        g = 0;
-        b = 255;
-    }
-    else if (t < 128) {
-        // Prpura -> rojo
-        uint8_t k = t - 64;
-        r = (uint8_t)(k * 4);              // 0..255
-        g = 0;
-        b = (uint8_t)(255 - k * 4);        // 255..0
-    }
-    else if (t < 192) {
-        // Rojo -> naranja -> amarillo
-        uint8_t k = t - 128;
-        r = 255;
-        g = (uint8_t)(k * 3);              // 0..192
-        b = 0;
-    }
-    else {
-        // Amarillo -> blanco
-        uint8_t k = t - 192;
-        r = 255;
-        g = 255;
-        b = (uint8_t)(k * 4);              // 0..255 (se satura a 255)
-        if (b > 255) b = 255;
-    }
-
-    // Pasar a RGB565
-    uint16_t color =
-        ((r & 0xF8) << 8) |
-        ((g & 0xFC) << 3) |
-        ((b & 0xF8) >> 3);
 
-    return color;
+    init = 1;
 }
 
 /* ==========================================================
-   PUNTO FIJO Q5.11
+   GALERA BMP: lista dinmica desde la SD
    ========================================================== */
 
-#define Q      11
-#define Q_ONE  (1 << Q)
-
-typedef int16_t q5_11_t;
-
-static inline q5_11_t qmul(q5_11_t a, q5_11_t b)
+// Lista, imgenes, paquete y animacin van en el arena (scratch.h): al
+// volver del fractal se rehacen si este lo ha usado
+#define MAX_BMP_FILES SCRATCH_MAX_FILES
+static SCRATCH_Gallery *const gallery = &g_scratch.gallery;
+static uint8_t bmp_count = 0;
+static uint8_t gallery_listed = 0;
+
+#define GALLERY_BG          0x0000
+#define GALLERY_SLIDE_STEP  9     // filas por paso de la transicin (162 = 18 x 9)
+#define GALLERY_PAN_STEP    16    // filas por pulsacin en imgenes altas
+#define GALLERY_TICK_MS     100
+#define GALLERY_DWELL_TICKS 8     // tiempo visible por imagen: 8 x 100 ms
+#define GALLERY_ANIM_LOOPS  3     // vueltas de cada animacin (.ANI)
+
+// Imagen en pantalla: un BMP suelto o una entrada de GALLERY.PAK
+#define GALLERY_SRC_NONE    0
+#define GALLERY_SRC_BMP     1
+#define GALLERY_SRC_PAK     2
+
+static uint8_t   gallery_pak_ok = 0;
+static uint8_t   gallery_src = GALLERY_SRC_NONE;
+static uint8_t   gallery_entry;       // con GALLERY_SRC_PAK
+
+// Siguiente elemento, preparado durante el tiempo visible del actual
+#define GALLERY_NEXT_NONE   0xFF
+static uint8_t   gallery_next_index = GALLERY_NEXT_NONE;
+static uint8_t   gallery_next_ok;
+static int16_t   gallery_top = 0;     // primera fila de la imagen alta en pantalla
+static uint8_t   gallery_ticks = 0;
+static uint16_t  gallery_fill = GALLERY_BG;   // color de pantalla sin imagen
+
+static uint8_t   gallery_anim_on = 0;
+static uint8_t   gallery_anim_loops;
+
+static uint8_t gallery_is_anim(const char *name)
 {
-    int32_t t = (int32_t)a * (int32_t)b;
-    return (q5_11_t)(t >> Q);
+    const char *dot = strrchr(name, '.');
+    return dot && strcmp(dot + 1, ANIM_EXT) == 0;
 }
 
-static inline q5_11_t q_from_int(int16_t n)
+static uint16_t gallery_height(void)
 {
-    return (q5_11_t)(n * Q_ONE);
+    if (gallery_src == GALLERY_SRC_PAK)
+        return gallery->pak.entry[gallery_entry].height;
+    return (uint16_t)gallery->img.height;
 }
 
-/* ==========================================================
-   PARMETROS DE FRACTAL: MANDELBROT Y JULIA
-   ========================================================== */
+// Fila de pantalla -> fila de la imagen, con la fila 'top' de la
+// composicin arriba. Las imgenes bajas se centran en una composicin
+// de TFT_HEIGHT filas. Devuelve -1 si es fondo.
+static int16_t gallery_image_row(int16_t top, uint8_t y)
+{
+    int16_t h = (int16_t)gallery_height();
+    int16_t r = top + y;
 
-typedef struct {
-    q5_11_t center_re;
-    q5_11_t center_im;
-    q5_11_t scale;
-    uint8_t max_iter;
-} FractalParams;
-
-// Mandelbrot: centrado en el cuerpo principal
-static const FractalParams FRACTAL_MANDEL_PARAMS = {
-    .center_re = (q5_11_t)(-1536),  // -0.75 * 2048
-    .center_im = (q5_11_t)(0),      // 0.0
-    .scale     = (q5_11_t)(3072),   // 1.5 * 2048
-    .max_iter  = 120
-};
-
-// Julia con C = -0.8 + 0.156i
-#define JULIA_C_RE  ((q5_11_t)-1638) // -0.8  * 2048
-#define JULIA_C_IM  ((q5_11_t)  319) //  0.156* 2048
-
-static const FractalParams FRACTAL_JULIA_PARAMS = {
-    .center_re = (q5_11_t)(0),      // centro 0+0i
-    .center_im = (q5_11_t)(0),
-    .scale     = (q5_11_t)(3072),   // +/-1.5
-    .max_iter  = 120
-};
+    if (h < TFT_HEIGHT)
+        r -= (TFT_HEIGHT - h) / 2;
 
-/* ==========================================================
-   RENDER DEL FRACTAL (MANDELBROT O JULIA)
-   ========================================================== */
-
-static uint8_t current_fractal_type = FRACTAL_MANDEL;
+    return (r >= 0 && r < h) ? r : -1;
+}
 
-static void draw_fractal(void)
+// Dibuja las filas de pantalla [y0, y1) de la imagen, con el fondo a los
+// lados incluido: filas de ancho completo en una sola ventana (dos si
+// cruzan la vuelta de la GRAM), en las lneas que el scroll muestra en
+// esas posiciones. Los pxeles van del sector de la SD al SPI sin pasar
+// por un buffer de fila; las del paquete, con un solo CMD18.
+static void draw_bmp_rows(int16_t top, uint8_t y0, uint8_t y1)
 {
-    const FractalParams *p;
+    BMP_Image *img = &gallery->img;
+    uint8_t    pak = (gallery_src == GALLERY_SRC_PAK);
+    uint8_t    reading = 0;
 
-    if (current_fractal_type == FRACTAL_JULIA)
-        p = &FRACTAL_JULIA_PARAMS;
-    else
-        p = &FRACTAL_MANDEL_PARAMS;
-
-    uint8_t  max_iter = p->max_iter;
-    q5_11_t  re_min   = p->center_re - p->scale;
-    q5_11_t  re_max   = p->center_re + p->scale;
-    q5_11_t  im_min   = p->center_im - p->scale;
-    q5_11_t  im_max   = p->center_im + p->scale;
-
-    q5_11_t re_step = (q5_11_t)((int32_t)(re_max - re_min) / (TFT_WIDTH  - 1));
-    q5_11_t im_step = (q5_11_t)((int32_t)(im_max - im_min) / (TFT_HEIGHT - 1));
+    if (img->width > TFT_WIDTH) img->width = TFT_WIDTH;
 
-    const q5_11_t escape2 = q_from_int(4); // |z|^2 > 4
+    // Las filas del paquete ya vienen al ancho del panel
+    uint8_t w  = pak ? TFT_WIDTH : (uint8_t)img->width;
+    uint8_t ox = (TFT_WIDTH - w) / 2;
 
-    for (uint16_t py = 0; py < TFT_HEIGHT; py++)
+    for (uint8_t y = y0; y < y1; )
     {
-        q5_11_t cy_pixel = im_min + (q5_11_t)((int32_t)im_step * py);
+        uint8_t mem = TFT_ScreenToGram(y);
+        uint8_t n   = y1 - y;
+        if (n > TFT_HEIGHT - mem) n = TFT_HEIGHT - mem;
 
-        TFT_SetAddrWindow(0, py, TFT_WIDTH - 1, py);
+        PROF_ENTER(PROF_TFT_WRITE);
+        TFT_SetAddrWindow(0, mem, TFT_WIDTH - 1, mem + n - 1);
         TFT_StartWrite();
-
-        q5_11_t cx_pixel = re_min;
-
-        for (uint16_t px = 0; px < TFT_WIDTH; px++)
-        {
-            q5_11_t zx, zy, cx, cy;
-
-            if (current_fractal_type == FRACTAL_MANDEL) {
-                // Mandelbrot: z0=0, c = punto
-                zx = 0;
-                zy = 0;
-                cx = cx_pixel;
-                cy = cy_pixel;
+        for (uint8_t end = y + n; y < end; y++) {
+            int16_t r = gallery_image_row(top, y);
+
+            if (r < 0) {
+                TFT_WriteColorRun(GALLERY_BG, TFT_WIDTH);
+            } else if (pak) {
+                // Filas seguidas: el CMD18 sigue abierto entre ventanas
+                if (!reading)
+                    reading = (PAK_RowsBegin(&gallery->pak, gallery_entry, (uint16_t)r) == PAK_OK);
+                if (reading)
+                    PAK_StreamRow();
+                else
+                    TFT_WriteColorRun(GALLERY_BG, TFT_WIDTH);
             } else {
-                // Julia: z0 = punto, c = constante fija
-                zx = cx_pixel;
-                zy = cy_pixel;
-                cx = JULIA_C_RE;
-                cy = JULIA_C_IM;
-            }
-
-            uint8_t iter = 0;
-
-            while (iter < max_iter)
-            {
-                q5_11_t zx2 = qmul(zx, zx);
-                q5_11_t zy2 = qmul(zy, zy);
-                q5_11_t zxy = qmul(zx, zy);
-
-                q5_11_t zx_new = zx2 - zy2 + cx;
-                q5_11_t zy_new = (q5_11_t)((int16_t)(zxy << 1) + cy);
-
-                zx = zx_new;
-                zy = zy_new;
-
-                q5_11_t mag2 = qmul(zx, zx) + qmul(zy, zy);
-                if (mag2 > escape2)
-                    break;
-
-                iter++;
+                TFT_WriteColorRun(GALLERY_BG, ox);
+                BMP_StreamRow(img, (uint32_t)r);
+                TFT_WriteColorRun(GALLERY_BG, TFT_WIDTH - ox - w);
             }
-
-            uint16_t color;
-            if (current_fractal_type == FRACTAL_MANDEL)
-                color = color_from_iter_mandel(iter, max_iter);
-            else
-                color = color_from_iter_julia(iter, max_iter);
-
-            TFT_WriteColor(color);
-
-            cx_pixel = (q5_11_t)(cx_pixel + re_step);
         }
-
         TFT_EndWrite();
+        PROF_EXIT(PROF_TFT_WRITE);
     }
+
+    if (reading) PAK_RowsEnd();
 }
 
-/* ==========================================================
-   GALERA BMP: lista dinmica desde la SD
-   ========================================================== */
+// Repinta un rectngulo sucio de la galera: filas enteras de la imagen
+// o el color de fondo de lo que haya en pantalla
+static void gallery_paint(uint8_t x, uint8_t y, uint8_t w, uint8_t h)
+{
+    if (gallery_src != GALLERY_SRC_NONE)
+        draw_bmp_rows(gallery_top, y, y + h);
+    else
+        TFT_FillRectScreen(x, y, w, h, gallery_fill);
+}
 
-#define MAX_BMP_FILES 16
-static char   bmp_list[MAX_BMP_FILES][13];
-static uint8_t bmp_count = 0;
+static void gallery_fill_screen(uint16_t color)
+{
+    gallery_fill = color;
+    TFT_FillScreen(color);
+}
 
-static void draw_bmp(BMP_Image *img)
+// Transicin: la imagen nueva entra desde abajo empujando a la anterior.
+// Cada paso sube el scroll y solo escribe la franja que queda expuesta.
+// Al terminar el scroll vuelve a su valor inicial (162 lneas).
+static void slide_in_bmp(void)
 {
-    if (img->width  > TFT_WIDTH)  img->width  = TFT_WIDTH;
-    if (img->height > TFT_HEIGHT) img->height = TFT_HEIGHT;
+    for (uint8_t done = 0; done < TFT_HEIGHT; done += GALLERY_SLIDE_STEP)
+    {
+        TFT_ScrollBy(GALLERY_SLIDE_STEP);
 
-    uint16_t buf[TFT_WIDTH];
+        // Filas de pantalla de abajo <- filas [done, done+paso) de la imagen
+        draw_bmp_rows((int16_t)done - (TFT_HEIGHT - GALLERY_SLIDE_STEP),
+                      TFT_HEIGHT - GALLERY_SLIDE_STEP, TFT_HEIGHT);
+    }
+}
 
-    uint8_t ox = (TFT_WIDTH  - img->width ) / 2;
-    uint8_t oy = (TFT_HEIGHT - img->height) / 2;
+// Prepara el elemento 'index' mientras se ve el actual: un BMP queda
+// abierto (directorio, cabecera y comprobado que no est fragmentado)
+// con el primer sector que pedir la transicin en el buffer de sector;
+// una animacin, abierta con sus tramos resueltos. Las entradas del paquete no lo necesitan: su ndice
+// ya est en RAM.
+static void gallery_prefetch(uint8_t index, uint8_t paks)
+{
+    gallery_next_index = index;
+    if (index < paks) return;
 
-    for (uint16_t y = 0; y < img->height; y++)
-    {
-        if (BMP_ReadRow(img, y, buf) != 0) break;
+    const char *name = gallery->list[index - paks];
 
-        TFT_SetAddrWindow(ox, oy + y, ox + img->width - 1, oy + y);
-        TFT_StartWrite();
-        for (uint16_t x = 0; x < img->width; x++)
-            TFT_WriteColor(buf[x]);
-        TFT_EndWrite();
+    if (gallery_is_anim(name)) {
+        gallery_next_ok = (ANIM_Open(&gallery->anim, name) == ANIM_OK);
+    } else {
+        gallery_next_ok = (BMP_Open(&gallery->next, name) == 0);
+        if (gallery_next_ok)
+            BMP_PrefetchRow(&gallery->next, 0);
     }
 }
 
+// Al entrar en el visor: si el arena ha sido de otro modo no queda nada
+// de lo que haba en l (ni la imagen en pantalla ni la preparada)
+static void gallery_enter(void)
+{
+    if (SCRATCH_Claim(SCRATCH_GALLERY)) {
+        gallery_listed = 0;
+        gallery_src = GALLERY_SRC_NONE;
+        gallery_next_index = GALLERY_NEXT_NONE;
+    }
+    gallery_ticks = 0;      // la galera entra con una imagen nueva
+    gallery_anim_on = 0;
+}
+
 static void gallery_step(void)
 {
-    static uint8_t init = 0;
-    static uint8_t okSD = 0, okFAT = 0;
     static uint8_t index = 0;
-    static BMP_Image img;
 
-    if (!init) {
-        uint8_t s = SD_Init();
-        okSD = (s == SD_OK);
+    if (!gallery_listed) {
+        storage_init();
 
-        if (okSD && FAT_Init() == 0) {
-            okFAT = 1;
-            // Construir lista de BMPs una sola vez
-            bmp_count = FAT_ListBMP(bmp_list, MAX_BMP_FILES);
+        // Construir lista de BMPs y animaciones (otra vez solo si el
+        // fractal ha usado el arena). Con GALLERY.PAK los BMP sueltos
+        // sobran: sus imgenes van primero y despus las animaciones.
+        if (okSD && okFAT) {
+            gallery_pak_ok = (PAK_Open(&gallery->pak, PAK_NAME) == PAK_OK);
+            bmp_count = FAT_ListFiles(gallery->list, MAX_BMP_FILES,
+                                      gallery_pak_ok ? ANIM_EXT : "BMP" ANIM_EXT);
         }
 
-        init = 1;
+        gallery_listed = 1;
     }
 
     if (!(okSD && okFAT)) {
-        TFT_FillScreen(0x2104); // gris oscuro
-        _delay_ms(300);
+        gallery_fill_screen(0x2104); // gris oscuro
+        idle_wait(300);
         return;
     }
 
-    if (bmp_count == 0) {
+    uint8_t paks  = gallery_pak_ok ? gallery->pak.count : 0;
+    uint8_t items = paks + bmp_count;
+
+    if (items == 0) {
         // No hay BMP en la SD
-        TFT_FillScreen(0x001F); // azul
-        _delay_ms(500);
+        gallery_fill_screen(0x001F); // azul
+        idle_wait(500);
         return;
     }
 
-    if (index >= bmp_count)
-        index = 0;
+    if (gallery_ticks == 0 && !gallery_anim_on) {
+        if (index >= items)
+            index = 0;
+
+        const char *name = (index >= paks) ? gallery->list[index - paks] : "";
+
+        HUD_Begin();
+        gallery_top = 0;
+        gallery_src = GALLERY_SRC_NONE;
+        gallery_anim_on = 0;
+        if (index < paks) {
+            // Del paquete: sin directorio ni cabecera que leer
+            gallery_src = GALLERY_SRC_PAK;
+            gallery_entry = index;
+            PROF_ENTER(PROF_FRAME);
+            slide_in_bmp();
+            PROF_EXIT(PROF_FRAME);
+            PROF_FLUSH();
+        } else if (gallery_is_anim(name)) {
+            if (gallery_next_index == index)
+                gallery_anim_on = gallery_next_ok;
+            else
+                gallery_anim_on = (ANIM_Open(&gallery->anim, name) == ANIM_OK);
+            gallery_anim_loops = 0;
+            if (gallery_anim_on) {
+                // Fondo solo alrededor: el primer fotograma tapa su rectngulo
+                ANIM_File *a = &gallery->anim;
+                gallery_fill = GALLERY_BG;
+                TFT_DirtyAdd(0, 0, TFT_WIDTH, a->y);
+                TFT_DirtyAdd(0, a->y + a->h, TFT_WIDTH, TFT_HEIGHT - a->y - a->h);
+                TFT_DirtyAdd(0, a->y, a->x, a->h);
+                TFT_DirtyAdd(a->x + a->w, a->y, TFT_WIDTH - a->x - a->w, a->h);
+                TFT_DirtyFlush(gallery_paint);
+                ANIM_Rewind(a);         // el primer fotograma cuenta desde aqu
+            }
+            else
+                gallery_fill_screen(0xF800); // rojo -> error al abrir
+        } else {
+            uint8_t ok;
+            if (gallery_next_index == index) {
+                gallery->img = gallery->next;
+                ok = gallery_next_ok;
+            } else {
+                ok = (BMP_Open(&gallery->img, name) == 0);
+            }
 
-    if (BMP_Open(&img, bmp_list[index]) == 0)
-        draw_bmp(&img);
-    else
-        TFT_FillScreen(0xF800); // rojo -> error al abrir
+            if (ok) {
+                gallery_src = GALLERY_SRC_BMP;
+                PROF_ENTER(PROF_FRAME);
+                slide_in_bmp();
+                PROF_EXIT(PROF_FRAME);
+                PROF_FLUSH();
+            }
+            else
+                gallery_fill_screen(0xF800); // rojo -> error al abrir
+        }
+
+        // La animacin mide cada vuelta completa
+        if (!gallery_anim_on)
+            HUD_End();
+
+        gallery_next_index = GALLERY_NEXT_NONE;
+        index++;
+        if (index >= items) index = 0;
+    }
+
+    // Animacin: el ritmo lo marca ANIM_Step, no el tiempo de visualizacin
+    if (gallery_anim_on) {
+        uint8_t r = ANIM_Step(&gallery->anim);
+
+        if (r == ANIM_IDLE) {
+            idle_wait(1);        // todava no toca: no ocupar el bus
+        } else if (r == ANIM_ERROR) {
+            // Fotograma ilegible: el siguiente DELTA saldra sobre una
+            // base equivocada, as que se deja y se pasa a la siguiente
+            HUD_End();
+            PROF_FLUSH();
+            gallery_anim_on = 0;
+        } else if (r == ANIM_LOOP) {
+            HUD_End();
+            PROF_FLUSH();
+            if (++gallery_anim_loops >= GALLERY_ANIM_LOOPS)
+                gallery_anim_on = 0;   // gallery_ticks sigue en 0: pasar a la siguiente
+            else
+                HUD_Begin();
+        }
+        return;
+    }
+
+    // Primer tick visible: adelantar el trabajo del siguiente
+    if (gallery_next_index != index)
+        gallery_prefetch(index, paks);
+
+    // Una pulsacin corta el tick: se atiende y se vuelve a esperar
+    if (idle_wait(GALLERY_TICK_MS))
+        return;
+    if (++gallery_ticks >= GALLERY_DWELL_TICKS)
+        gallery_ticks = 0;
+}
+
+// Pan vertical de una imagen ms alta que la pantalla (dy > 0: bajar).
+// Solo se leen de la SD y se escriben las filas que quedan expuestas.
+static void gallery_pan(int8_t dy)
+{
+    if (gallery_src == GALLERY_SRC_NONE || gallery_height() <= TFT_HEIGHT) return;
+
+    int16_t max_top = (int16_t)gallery_height() - TFT_HEIGHT;
+    int16_t top = gallery_top + dy;
+    if (top < 0) top = 0;
+    if (top > max_top) top = max_top;
+
+    int16_t n = top - gallery_top;
+    if (n == 0) return;
 
-    index++;
-    if (index >= bmp_count) index = 0;
+    HUD_Begin();
+    gallery_top = top;
+    TFT_ScrollBy(n);
+    if (n > 0) {
+        TFT_DirtyAdd(0, TFT_HEIGHT - n, TFT_WIDTH, (uint8_t)n);
+    } else {
+        TFT_DirtyAdd(0, 0, TFT_WIDTH, (uint8_t)-n);
+        // La banda del HUD baj con el contenido (se funde con la anterior)
+        if (HUD_Enabled())
+            TFT_DirtyAdd(0, (uint8_t)-n, TFT_WIDTH, HUD_ROWS);
+    }
+    TFT_DirtyFlush(gallery_paint);
+    HUD_End();
 
-    _delay_ms(800); // tiempo visible por imagen
+    gallery_ticks = 1;    // seguir mirando: reinicia el tiempo visible
 }
 
 /* ==========================================================
-   FRACTAL STEP: esttico, redibuja solo si cambia tipo
+   FRACTAL STEP: redibuja solo cuando cambia la vista
    ========================================================== */
 
+// Animacin de paleta (recolorea desde el plano de iteraciones, sin
+// recalcular): quieta, girando su paleta o girando la del otro fractal
+#define RECOLOR_OFF     0
+#define RECOLOR_CYCLE   1
+#define RECOLOR_SWAP    2
+
+static FractalView fractal_view;
+static uint8_t     fractal_dirty = 1;
+static uint8_t     fractal_anim  = RECOLOR_OFF;
+static uint8_t     fractal_phase = 0;
+
+// Repinta un rectngulo sucio del fractal (filas enteras). Si va a haber
+// un dibujo completo no hace falta.
+static void fractal_paint(uint8_t x, uint8_t y, uint8_t w, uint8_t h)
+{
+    (void)x; (void)w;
+    if (!fractal_dirty)
+        FRACTAL_DrawBand(&fractal_view, y, y + h);
+}
+
 static void fractal_step(void)
 {
-    static uint8_t drawn = 0;
-    static uint8_t last_type = 0xFF;
+    if (fractal_dirty) {
+        storage_init();
+        HUD_Begin();
+        PROF_ENTER(PROF_FRAME);
+        FRACTAL_Draw(&fractal_view);
+        PROF_EXIT(PROF_FRAME);
+        PROF_FLUSH();
+        HUD_End();
+        fractal_dirty = 0;
+    } else if (fractal_anim != RECOLOR_OFF) {
+        uint8_t palette = fractal_view.type;
+        if (fractal_anim == RECOLOR_SWAP) palette ^= 1;
+
+        // Sin FRACTAL.ITR no hay animacin posible
+        HUD_Begin();
+        if (FRACTAL_Recolor(&fractal_view, palette, fractal_phase) != 0)
+            fractal_anim = RECOLOR_OFF;
+        HUD_End();
+
+        if (++fractal_phase >= fractal_view.max_iter)
+            fractal_phase = 0;
+    } else {
+        idle_wait(100);
+    }
+}
+
+// HUD: al encenderlo mide un dibujo completo; al apagarlo solo se repinta
+// la banda que tapaba
+static void hud_toggle(uint8_t mode)
+{
+    HUD_Enable(!HUD_Enabled());
+    FRACTAL_SetOverlay(HUD_Enabled() ? HUD_ROWS : 0);
 
-    if (!drawn || last_type != current_fractal_type) {
-        draw_fractal();
-        drawn = 1;
-        last_type = current_fractal_type;
+    if (HUD_Enabled()) {
+        fractal_dirty = 1;
     } else {
-        _delay_ms(100);
+        TFT_DirtyAdd(0, 0, TFT_WIDTH, HUD_ROWS);
+        TFT_DirtyFlush(mode == MODE_FRACTAL ? fractal_paint : gallery_paint);
     }
 }
 
 /* ==========================================================
-   GESTIN DE BOTONES (flanco de bajada)
+   STREAM: imgenes por la USART (uart_stream.h)
    ========================================================== */
 
-static uint8_t button_pressed_edge_PD0(void)
+// Entra en cuanto llega el sincronismo de una trama, desde cualquier modo
+static void stream_enter(void)
+{
+    TFT_SetColorMode(STREAM_COLOR_MODE);
+    TFT_ScrollTo(0);              // las tramas van en coordenadas de pantalla
+    TFT_FillScreen(0x0000);       // pueden no cubrirla entera
+}
+
+static void stream_step(void)
+{
+    // USTREAM_Poll vaca el buffer antes de volver: hasta que llegue ms
+    // (o se pulse un botn) no hay nada que hacer
+    if (USTREAM_Poll() != USTREAM_FRAME)
+        idle_sleep();
+}
+
+/* ==========================================================
+   BENCHMARK (compilar con -DBENCH_BUILD)
+   ==========================================================
+   Mide con el Timer1 los mismos caminos que usa el visor y el fractal
+   sobre la SD que haya (ver host/bench_avr.c para el corpus y el
+   simulador) y los manda por la USART, una lnea por medida:
+       BENCH <nombre> <mtrica> <ciclos>
+   Al terminar duerme con las interrupciones cortadas: simavr lo toma
+   como fin del programa. */
+
+#ifdef BENCH_BUILD
+#include "cycles.h"
+#include "uart.h"
+#include "fractal_kernel.h"
+
+#define BENCH_SD_SECTORS  32
+#define BENCH_KERNEL_N    16      // rejilla de cada vista del ncleo Q5.11
+
+static void bench_line(const char *name, const char *metric, uint32_t value)
+{
+    UART_PutString("BENCH ");
+    UART_PutString(name);
+    UART_PutChar(' ');
+    UART_PutString(metric);
+    UART_PutChar(' ');
+    UART_PutU32(value);
+    UART_PutChar('\n');
+}
+
+static void bench_halt(void)
+{
+    UART_PutString("BENCH done\n");
+    _delay_ms(10);          // vaciar el ltimo byte de la USART
+    cli();
+    sleep_enable();
+    sleep_cpu();
+    while (1);
+}
+
+static void bench_fractal(const char *name, uint8_t type, uint8_t zoom)
+{
+    FractalView v;
+    FRACTAL_InitView(&v, type);
+    v.zoom = zoom;
+
+    TFT_ScrollTo(0);
+    uint32_t t0 = CYC_Now();
+    FRACTAL_Draw(&v);
+    uint32_t t = CYC_Now() - t0;
+
+    bench_line(name, "frame_cycles", t);
+    bench_line(name, "row_cycles", t / TFT_HEIGHT);
+}
+
+// Punto (i, j) de la rejilla de cada vista del benchmark del ncleo.
+// Vista 0: Mandelbrot, c en [-2, 0.5) x [-1.25, 1.25); vista 1: Julia
+// de c = -0.8 + 0.156i, z0 en [-1.5, 1.5) x [-1.5, 1.5). Todo en Q5.11.
+static void bench_point(uint8_t view, uint8_t i, uint8_t j, int16_t p[4])
+{
+    if (view == 0) {
+        p[0] = 0;                p[1] = 0;
+        p[2] = -4096 + i * 320;  p[3] = -2560 + j * 320;
+    } else {
+        p[0] = -3072 + i * 384;  p[1] = -3072 + j * 384;
+        p[2] = -1638;            p[3] = 319;
+    }
+}
+
+// Solo el bucle de iteracin, sin TFT: ciclos por vuelta (con la
+// llamada repartida) de FK_Iterate, que en AVR es el .S, y del mismo
+// bucle en C sobre los mismos puntos, fila a fila. Cada punto tiene que
+// dar lo mismo con los dos: los distintos salen en "mismatch".
+static void bench_kernel(void)
 {
-    static uint8_t prev = 1;
-    uint8_t now = (BTN_MODE_PINREG & (1 << BTN_MODE_BIT)) ? 1 : 0;
-    uint8_t pressed = 0;
-
-    if (prev == 1 && now == 0) {
-        _delay_ms(20);
-        if (!(BTN_MODE_PINREG & (1 << BTN_MODE_BIT)))
-            pressed = 1;
+    uint8_t  got[BENCH_KERNEL_N];
+    int16_t  p[4];
+    uint32_t iters = 0, t_asm = 0, t_c = 0, bad = 0;
+
+    for (uint8_t view = 0; view < 2; view++) {
+        for (uint8_t j = 0; j < BENCH_KERNEL_N; j++) {
+            uint32_t t0 = CYC_Now();
+            for (uint8_t i = 0; i < BENCH_KERNEL_N; i++) {
+                bench_point(view, i, j, p);
+                got[i] = FK_Iterate(FK_Q5_11, p[0], p[1], p[2], p[3], 64);
+            }
+            t_asm += CYC_Now() - t0;
+
+            t0 = CYC_Now();
+            for (uint8_t i = 0; i < BENCH_KERNEL_N; i++) {
+                bench_point(view, i, j, p);
+                if (FK_IterateQ511C(p[0], p[1], p[2], p[3], 64) != got[i]) bad++;
+            }
+            t_c += CYC_Now() - t0;
+
+            for (uint8_t i = 0; i < BENCH_KERNEL_N; i++) iters += got[i];
+        }
     }
 
-    prev = now;
-    return pressed;
+    bench_line("kernel/q5_11", "iters", iters);
+    bench_line("kernel/q5_11", "iter_cycles", t_asm / iters);
+    bench_line("kernel/q5_11", "c_iter_cycles", t_c / iters);
+    bench_line("kernel/q5_11", "mismatch", bad);
 }
 
-static uint8_t button_pressed_edge_PD1(void)
+static void bench_run(void)
 {
-    static uint8_t prev = 1;
-    uint8_t now = (BTN_FRACTAL_PINREG & (1 << BTN_FRACTAL_BIT)) ? 1 : 0;
-    uint8_t pressed = 0;
-
-    if (prev == 1 && now == 0) {
-        _delay_ms(20);
-        if (!(BTN_FRACTAL_PINREG & (1 << BTN_FRACTAL_BIT)))
-            pressed = 1;
+    UART_Init();
+    CYC_Init();
+    sei();
+
+    uint32_t t0 = CYC_Now();
+    storage_init();
+    bench_line("storage_init", "cycles", CYC_Now() - t0);
+
+    if (!(okSD && okFAT)) {
+        bench_line("storage_init", "error", 1);
+        bench_halt();
     }
+    bench_line("storage_init", "sd_type", SD_CardType());
+    bench_line("storage_init", "fat_type", g_fat.fat_type);
 
-    prev = now;
-    return pressed;
+    SCRATCH_Claim(SCRATCH_GALLERY);
+    bmp_count = FAT_ListBMP(gallery->list, MAX_BMP_FILES);
+
+    for (uint8_t i = 0; i < bmp_count; i++)
+    {
+        BMP_Image *img = &gallery->img;
+        FAT_File f;
+
+        t0 = CYC_Now();
+        uint8_t err = FAT_Open(&f, gallery->list[i]);
+        bench_line(gallery->list[i], "fat_open_cycles", CYC_Now() - t0);
+        if (err) continue;
+
+        // Lectura de sectores sueltos del archivo (el camino de FAT_Read)
+        uint32_t nsec = (f.size_bytes + 511) / 512;
+        if (nsec > BENCH_SD_SECTORS) nsec = BENCH_SD_SECTORS;
+        t0 = CYC_Now();
+        for (uint32_t s = 0; s < nsec; s++)
+            SD_ReadBlock(FAT_FileSector(&f, s * 512), FAT_SectorBuffer());
+        if (nsec)
+            bench_line(gallery->list[i], "sd_sector_cycles", (CYC_Now() - t0) / nsec);
+
+        t0 = CYC_Now();
+        err = BMP_Open(img, gallery->list[i]);
+        bench_line(gallery->list[i], "bmp_open_cycles", CYC_Now() - t0);
+        if (err) continue;
+        gallery_src = GALLERY_SRC_BMP;
+
+        t0 = CYC_Now();
+        draw_bmp_rows(0, 0, TFT_HEIGHT);
+        uint32_t t = CYC_Now() - t0;
+        bench_line(gallery->list[i], "frame_cycles", t);
+        bench_line(gallery->list[i], "row_cycles", t / TFT_HEIGHT);
+
+        TFT_SetColorMode(TFT_COLOR_444);
+        t0 = CYC_Now();
+        draw_bmp_rows(0, 0, TFT_HEIGHT);
+        bench_line(gallery->list[i], "frame444_cycles", CYC_Now() - t0);
+        TFT_SetColorMode(TFT_COLOR_565);
+    }
+
+    // Paquete: abrir (ndice incluido) y dibujar cada entrada
+    t0 = CYC_Now();
+    if (PAK_Open(&gallery->pak, PAK_NAME) == PAK_OK) {
+        bench_line(PAK_NAME, "pak_open_cycles", CYC_Now() - t0);
+        gallery_src = GALLERY_SRC_PAK;
+
+        for (gallery_entry = 0; gallery_entry < gallery->pak.count; gallery_entry++) {
+            bench_line(PAK_NAME, "entry", gallery_entry);
+
+            t0 = CYC_Now();
+            draw_bmp_rows(0, 0, TFT_HEIGHT);
+            bench_line(PAK_NAME, "frame_cycles", CYC_Now() - t0);
+
+            TFT_SetColorMode(TFT_COLOR_444);
+            t0 = CYC_Now();
+            draw_bmp_rows(0, 0, TFT_HEIGHT);
+            bench_line(PAK_NAME, "frame444_cycles", CYC_Now() - t0);
+            TFT_SetColorMode(TFT_COLOR_565);
+        }
+    }
+
+    // Animaciones: una vuelta con el regulador, fps conseguidos y saltados
+    bmp_count = FAT_ListFiles(gallery->list, MAX_BMP_FILES, ANIM_EXT);
+
+    for (uint8_t i = 0; i < bmp_count; i++)
+    {
+        uint32_t dropped = g_anim_stats.dropped;
+
+        if (ANIM_Open(&gallery->anim, gallery->list[i]) != ANIM_OK) {
+            bench_line(gallery->list[i], "error", 1);
+            continue;
+        }
+        while (ANIM_Step(&gallery->anim) != ANIM_LOOP);
+
+        bench_line(gallery->list[i], "fps_x10", g_anim_stats.fps_x10);
+        bench_line(gallery->list[i], "dropped", g_anim_stats.dropped - dropped);
+    }
+
+    // Vista inicial y un nivel de zoom por ncleo (Q5.11 / Q4.27 / Q8.56)
+    bench_kernel();
+    bench_fractal("fractal/mandel/z0",  FRACTAL_MANDEL, 0);
+    bench_fractal("fractal/mandel/z20", FRACTAL_MANDEL, 20);
+    bench_fractal("fractal/mandel/z40", FRACTAL_MANDEL, 40);
+    bench_fractal("fractal/julia/z0",   FRACTAL_JULIA,  0);
+
+    bench_halt();
 }
+#endif /* BENCH_BUILD */
 
 /* ==========================================================
    MAIN
@@ -431,32 +757,101 @@ int main(void)
     SPI_Init(4);
     TFT_Init();
 
-    // Botn PD0 (modo) -> entrada con pull-up
-    BTN_MODE_DDR  &= ~(1 << BTN_MODE_BIT);
-    BTN_MODE_PORT |=  (1 << BTN_MODE_BIT);
+#ifdef BENCH_BUILD
+    bench_run();
+#endif
+    TFT_SetColorMode(FRACTAL_COLOR_MODE);
+    PROF_INIT();   // solo con -DPROF_ENABLE
+    HUD_Init();
+    USTREAM_Init();
 
-    // Botn PD1 (tipo de fractal) -> entrada con pull-up
-    BTN_FRACTAL_DDR  &= ~(1 << BTN_FRACTAL_BIT);
-    BTN_FRACTAL_PORT |=  (1 << BTN_FRACTAL_BIT);
+    // Botones con pull-up, muestreados por el Timer0 (buttons.h)
+    BTN_Init();
+    set_sleep_mode(SLEEP_MODE_IDLE);   // el Timer0 y la USART siguen vivos
+    sei();
 
     uint8_t mode = MODE_FRACTAL;  // arrancamos mostrando fractal
+    FRACTAL_InitView(&fractal_view, FRACTAL_MANDEL);
 
     while (1)
     {
-        // Botn PD0: cambiar entre visor y fractal
-        if (button_pressed_edge_PD0()) {
-            mode = (mode == MODE_FRACTAL) ? MODE_VIEWER : MODE_FRACTAL;
-            TFT_FillScreen(0x0000); // limpiar pantalla al cambiar
+        // Una trama por la USART toma la pantalla
+        if (mode != MODE_STREAM && USTREAM_Waiting()) {
+            mode = MODE_STREAM;
+            stream_enter();
         }
 
-        // Botn PD1: solo tiene efecto en modo fractal
-        if (mode == MODE_FRACTAL && button_pressed_edge_PD1()) {
-            current_fractal_type ^= 1;   // toggle Mandelbrot/Julia
-            TFT_FillScreen(0x0000);      // limpiar para redibujo
+        // Una pulsacin por vuelta; las dems esperan en la cola
+        uint8_t ev = BTN_GetEvent();
+
+        // Botn de modo: cambiar entre visor y fractal (del stream, al visor)
+        if (ev == BTN_EV_MODE) {
+            if (mode == MODE_STREAM)
+                USTREAM_Abort();
+            mode = (mode == MODE_VIEWER) ? MODE_FRACTAL : MODE_VIEWER;
+            TFT_SetColorMode(mode == MODE_FRACTAL ? FRACTAL_COLOR_MODE
+                                                  : VIEWER_COLOR_MODE);
+            TFT_ScrollTo(0);        // volver a la GRAM sin desplazar
+            // Sin limpiar: los dos modos entran pintando la pantalla entera
+            fractal_dirty = 1;
+            if (mode == MODE_VIEWER)
+                gallery_enter();
         }
 
-        if (mode == MODE_VIEWER)
+        // Botn de fractal: solo tiene efecto en modo fractal
+        if (mode == MODE_FRACTAL && ev == BTN_EV_FRACTAL) {
+            // toggle Mandelbrot/Julia, volviendo a su vista inicial
+            FRACTAL_InitView(&fractal_view, fractal_view.type ^ 1);
+            fractal_dirty = 1;           // se redibuja entera, sin limpiar
+        }
+
+        if (mode == MODE_STREAM) {
+            stream_step();
+            continue;
+        }
+
+        if (ev == BTN_EV_HUD)
+            hud_toggle(mode);
+
+        // Pan / zoom: el pan vertical redibuja solo la franja nueva
+        if (mode == MODE_FRACTAL && !fractal_dirty) {
+            int8_t dx = 0, dy = 0;
+
+            if (ev == BTN_EV_UP)
+                dy = -FRACTAL_PAN_STEP;
+            else if (ev == BTN_EV_DOWN)
+                dy = FRACTAL_PAN_STEP;
+            else if (ev == BTN_EV_LEFT)
+                dx = -FRACTAL_PAN_STEP;
+            else if (ev == BTN_EV_RIGHT)
+                dx = FRACTAL_PAN_STEP;
+            else if (ev == BTN_EV_ZOOM_IN)
+                fractal_dirty = FRACTAL_Zoom(&fractal_view, 1);
+            else if (ev == BTN_EV_ZOOM_OUT)
+                fractal_dirty = FRACTAL_Zoom(&fractal_view, -1);
+            else if (ev == BTN_EV_PALETTE) {
+                fractal_anim = (fractal_anim == RECOLOR_SWAP) ? RECOLOR_OFF : fractal_anim + 1;
+                fractal_phase = 0;
+                // Al parar, volver a los colores normales (desde la cach)
+                fractal_dirty = (fractal_anim == RECOLOR_OFF);
+            }
+
+            if (dx || dy) {
+                HUD_Begin();
+                FRACTAL_Pan(&fractal_view, dx, dy);
+                HUD_End();
+            }
+        }
+
+        // Visor: arriba / abajo recorren las imgenes ms altas que la pantalla
+        if (mode == MODE_VIEWER) {
+            if (ev == BTN_EV_UP)
+                gallery_pan(-GALLERY_PAN_STEP);
+            else if (ev == BTN_EV_DOWN)
+                gallery_pan(GALLERY_PAN_STEP);
+
             gallery_step();
+        }
         else
             fractal_step();
     }
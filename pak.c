@@ -0,0 +1,208 @@
+// pak.c - Lectura del paquete de imgenes de la galera
+//
+// El ndice se carga una vez en PAK_Open; dibujar una imagen es buscar
+// su entrada y leer sus filas con CMD18 (un comando por tramo contiguo
+// del archivo), envindolas al TFT desde el buffer de sector de fat_fs.c.
+
+#include "pak.h"
+#include "sd_spi.h"
+#include "tft_st7735.h"
+
+static uint16_t PAK_U16(const uint8_t *p)
+{
+	return p[0] | ((uint16_t)p[1] << 8);
+}
+
+static uint32_t PAK_U32(const uint8_t *p)
+{
+	return PAK_U16(p) | ((uint32_t)PAK_U16(p + 2) << 16);
+}
+
+// Bytes de una fila en la SD
+static uint16_t PAK_RowBytes(uint8_t format)
+{
+	return (format == PAK_FMT_RGB444) ? TFT_WIDTH * 3 / 2 : TFT_WIDTH * 2;
+}
+
+// Sector del archivo -> LBA, y cuntos sectores contiguos quedan desde ah
+static uint32_t PAK_SectorLBA(const PAK_File *p, uint32_t sector, uint32_t *run)
+{
+	for (uint8_t i = 0; i < p->n_ext; i++) {
+		if (sector < p->ext[i].sectors) {
+			*run = p->ext[i].sectors - sector;
+			return p->ext[i].lba + sector;
+		}
+		sector -= p->ext[i].sectors;
+	}
+	*run = 0;
+	return 0;
+}
+
+static uint8_t PAK_ReadSector(const PAK_File *p, uint32_t sector)
+{
+	uint32_t run;
+	uint32_t lba = PAK_SectorLBA(p, sector, &run);
+	if (run == 0) return PAK_ERR_FORMAT;
+	return (SD_ReadBlock(lba, FAT_SectorBuffer()) == SD_OK) ? PAK_OK : PAK_ERR_IO;
+}
+
+uint8_t PAK_Open(PAK_File *p, const char *name)
+{
+	FAT_File f;
+	if (FAT_Open(&f, name) != 0) return PAK_ERR_OPEN;
+
+	p->count = 0;
+	p->n_ext = FAT_GetExtents(&f, p->ext, PAK_MAX_EXTENTS);
+	if (p->n_ext == 0) return PAK_ERR_FRAG;
+
+	uint8_t *buf = FAT_SectorBuffer();
+	uint8_t  r = PAK_ReadSector(p, 0);
+	if (r != PAK_OK) return r;
+
+	if (buf[0] != 'P' || buf[1] != 'A' || buf[2] != 'K' || buf[3] != '1')
+		return PAK_ERR_FORMAT;
+
+	uint16_t count = PAK_U16(&buf[4]);
+	if (count > PAK_MAX_ENTRIES) count = PAK_MAX_ENTRIES;
+
+	uint32_t loaded = 0;
+	for (uint8_t i = 0; i < count; i++) {
+		uint16_t at = 32 + 32 * i;
+		uint32_t sector = at / 512;
+
+		if (sector != loaded) {
+			r = PAK_ReadSector(p, sector);
+			if (r != PAK_OK) return r;
+			loaded = sector;
+		}
+
+		const uint8_t *e = &buf[at % 512];
+		PAK_Entry *pe = &p->entry[i];
+		pe->height = PAK_U16(&e[14]);
+		pe->format = e[16];
+		pe->sector = PAK_U32(&e[20]);
+
+		// Solo imgenes ya compuestas al ancho del panel y enteras en el archivo
+		if (PAK_U16(&e[12]) != TFT_WIDTH || pe->height == 0 ||
+		    (pe->format != PAK_FMT_RGB565 && pe->format != PAK_FMT_RGB444) ||
+		    pe->sector * 512 + (uint32_t)pe->height * PAK_RowBytes(pe->format) > f.size_bytes)
+			return PAK_ERR_FORMAT;
+	}
+
+	p->count = (uint8_t)count;
+	return PAK_OK;
+}
+
+/* ---------- Lectura de filas ---------- */
+
+// Un CMD18 abierto mientras el tramo del archivo siga siendo contiguo
+static const PAK_File *pak_cur;
+static uint32_t pak_sector;      // siguiente sector del archivo por leer
+static uint32_t pak_run;         // sectores que quedan en el CMD18 abierto
+static uint16_t pak_pos;         // bytes ya usados del buffer de sector
+static uint8_t  pak_loaded;      // el buffer tiene un sector de la imagen
+static uint8_t  pak_reading;     // hay un CMD18 sin cerrar
+static uint8_t  pak_format;
+
+static uint8_t PAK_NextSector(void)
+{
+	if (pak_run == 0) {
+		PAK_RowsEnd();
+		uint32_t lba = PAK_SectorLBA(pak_cur, pak_sector, &pak_run);
+		if (pak_run == 0 || SD_ReadMultiStart(lba) != SD_OK) {
+			pak_run = 0;
+			return PAK_ERR_IO;
+		}
+		pak_reading = 1;
+	}
+
+	if (SD_ReadMultiNext(FAT_SectorBuffer()) != SD_OK) {
+		PAK_RowsEnd();
+		return PAK_ERR_IO;
+	}
+	pak_run--;
+	pak_sector++;
+	return PAK_OK;
+}
+
+uint8_t PAK_RowsBegin(const PAK_File *p, uint8_t i, uint16_t row)
+{
+	PAK_RowsEnd();
+	if (i >= p->count || row >= p->entry[i].height) return PAK_ERR_FORMAT;
+
+	uint32_t offset = (uint32_t)row * PAK_RowBytes(p->entry[i].format);
+
+	pak_cur    = p;
+	pak_format = p->entry[i].format;
+	pak_sector = p->entry[i].sector + offset / 512;
+	pak_pos    = (uint16_t)(offset % 512);
+	pak_loaded = 0;
+	return PAK_OK;
+}
+
+void PAK_RowsEnd(void)
+{
+	if (pak_reading) SD_ReadMultiStop();
+	pak_reading = 0;
+	pak_run = 0;
+}
+
+// 'n' unidades enteras (un pxel en 565, un par en 444)
+static void PAK_Send(const uint8_t *data, uint16_t n)
+{
+	if (pak_format == PAK_FMT_RGB444)
+		TFT_WritePacked444(data, n);
+	else
+		TFT_WriteBytes(data, n * 2);
+}
+
+uint8_t PAK_StreamRow(void)
+{
+	uint8_t  unit  = (pak_format == PAK_FMT_RGB444) ? 3 : 2;
+	uint16_t left  = PAK_RowBytes(pak_format);
+	uint8_t *sec   = FAT_SectorBuffer();
+	uint8_t  carry[3];   // par de 444 partido entre dos sectores (512 % 3 != 0)
+	uint8_t  nc = 0;
+
+	while (left > 0) {
+		if (!pak_loaded || pak_pos == 512) {
+			uint16_t skip = pak_loaded ? 0 : pak_pos;
+
+			// La SD y el TFT comparten el bus: pausar la rfaga para leer
+			TFT_EndWrite();
+			uint8_t r = PAK_NextSector();
+			TFT_StartWrite();
+			if (r != PAK_OK) {
+				// Completar la fila en negro para no desbordar la ventana
+				TFT_WriteColorRun(0x0000, (left + nc) / unit * (unit == 3 ? 2 : 1));
+				pak_loaded = 0;
+				return r;
+			}
+			pak_pos = skip;
+			pak_loaded = 1;
+		}
+
+		uint16_t avail = 512 - pak_pos;
+		if (avail > left) avail = left;
+
+		const uint8_t *p = sec + pak_pos;
+		uint16_t k = avail;
+
+		if (nc) {
+			while (nc < unit) { carry[nc++] = *p++; k--; }
+			PAK_Send(carry, 1);
+			nc = 0;
+		}
+
+		uint16_t whole = k / unit;
+		PAK_Send(p, whole);
+		p += whole * unit;
+		k -= whole * unit;
+		while (k--) carry[nc++] = *p++;
+
+		pak_pos += avail;
+		left    -= avail;
+	}
+
+	return PAK_OK;
+}
@@ -0,0 +1,72 @@
+// pak.h - Paquete de imgenes de la galera (GALLERY.PAK)
+#ifndef PAK_H_
+#define PAK_H_
+
+#include <stdint.h>
+#include "fat_fs.h"
+
+// Formato .PAK (little endian). Un solo archivo con un ndice al
+// principio y las imgenes detrs, cada una empezando en sector nuevo:
+//   cabecera (32 bytes):
+//     0  "PAK1"
+//     4  u16 entradas
+//   entrada i en el byte 32 + 32 * i (nunca cruza un sector):
+//     0  nombre "NAME.BMP" (12 bytes, con ceros detrs si es ms corto)
+//     12 u16 ancho, u16 alto
+//     16 u8 formato
+//     20 u32 primer sector de la imagen (desde el inicio del archivo)
+//     24 u32 sectores
+// Las filas van de arriba abajo, seguidas y sin relleno, ya compuestas
+// al ancho del panel (TFT_WIDTH): el host centra o recorta cada imagen
+// igual que el visor con un BMP suelto.
+//   PAK_FMT_RGB565: 2 bytes por pxel, MSB primero
+//   PAK_FMT_RGB444: dos pxeles cada 3 bytes, tal cual van al bus en
+//                   TFT_COLOR_444 (1,5 bytes por pxel que leer de la SD)
+// host/mkpak.c lo genera a partir de BMPs.
+
+#define PAK_NAME          "GALLERY.PAK"
+#define PAK_MAX_ENTRIES   16
+#define PAK_MAX_EXTENTS   8     // el archivo puede estar fragmentado
+
+#define PAK_FMT_RGB565    0
+#define PAK_FMT_RGB444    1
+
+#define PAK_OK            0
+#define PAK_ERR_OPEN      1
+#define PAK_ERR_FORMAT    2
+#define PAK_ERR_FRAG      3     // ms tramos que PAK_MAX_EXTENTS
+#define PAK_ERR_IO        4
+
+// Lo que hace falta de cada entrada para dibujarla (8 bytes en RAM)
+typedef struct {
+	uint32_t sector;
+	uint16_t height;
+	uint8_t  format;
+} PAK_Entry;
+
+typedef struct {
+	FAT_Extent ext[PAK_MAX_EXTENTS];
+	uint8_t    n_ext;
+	uint8_t    count;
+	PAK_Entry  entry[PAK_MAX_ENTRIES];
+} PAK_File;
+
+// Abre el paquete, resuelve sus tramos y carga el ndice: despus no
+// hace falta leer ningn directorio. Si hay ms de PAK_MAX_ENTRIES
+// imgenes se usan las primeras.
+uint8_t PAK_Open(PAK_File *p, const char *name);
+
+// Lectura de filas seguidas de la entrada 'i' desde la fila 'row' con
+// un solo CMD18. Entre Begin y End se puede dibujar cualquier cosa en el
+// TFT, pero no usar la SD.
+uint8_t PAK_RowsBegin(const PAK_File *p, uint8_t i, uint16_t row);
+
+// Enva la fila siguiente (TFT_WIDTH pxeles) a la rfaga TFT abierta.
+// Pausa la rfaga (TFT_EndWrite / TFT_StartWrite) en cada sector nuevo.
+// Si una lectura falla el resto de la fila sale en negro. Usa
+// FAT_SectorBuffer().
+uint8_t PAK_StreamRow(void);
+
+void PAK_RowsEnd(void);
+
+#endif /* PAK_H_ */
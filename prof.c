@@ -0,0 +1,103 @@
+// prof.c - Acumuladores de las sondas de prof.h
+//
+// En vez de guardar cada evento (un fotograma de la galera tiene miles)
+// se acumula por fase: ciclos totales y nmero de entradas. El volcado
+// por fotograma queda en un paquete de tamao fijo.
+//
+// Las sondas activas forman una pila: al salir de una, su tiempo total
+// se suma a las hijas de la de debajo y ella se queda con el total menos
+// el de sus hijas (tiempo exclusivo).
+//
+// La USART es la de uart_stream.c, a UART_STREAM_BAUD: el paquete no
+// puede parecerse a nada de ese protocolo. Lleva su propio sincronismo y
+// escapa XON/XOFF (el host los consumira como control de flujo), el
+// sincronismo y el propio escape. Mientras el host manda algo no se
+// vuelca: espera la respuesta de una trama y la tomara por ella.
+
+#include "prof.h"
+
+#ifdef PROF_ENABLE
+
+#include <avr/interrupt.h>
+#include "cycles.h"
+#include "uart.h"
+#include "uart_stream.h"
+
+#define PROF_SYNC0  0xC3
+#define PROF_SYNC1  'P'
+#define PROF_ESC    0x7D    // el byte siguiente va XOR PROF_ESC_XOR
+#define PROF_ESC_XOR 0x20
+
+static uint32_t prof_start[PROF_IDS];    // por nivel de la pila
+static uint32_t prof_inner[PROF_IDS];    // ciclos de las hijas, por nivel
+static uint8_t  prof_depth;
+static uint32_t prof_total[PROF_IDS];
+static uint16_t prof_count[PROF_IDS];
+
+void PROF_Init(void)
+{
+	UART_InitStream();        // la misma que deja USTREAM_Init
+	CYC_Init();
+	sei();
+}
+
+void PROF_Enter(uint8_t id)
+{
+	(void)id;
+	prof_inner[prof_depth] = 0;
+	prof_start[prof_depth] = CYC_Now();
+	prof_depth++;
+}
+
+void PROF_Exit(uint8_t id)
+{
+	uint32_t t = CYC_Now() - prof_start[--prof_depth];
+
+	prof_total[id] += t - prof_inner[prof_depth];
+	prof_count[id]++;
+	if (prof_depth) prof_inner[prof_depth - 1] += t;
+}
+
+static void PROF_PutEscaped(uint8_t b)
+{
+	if (b == USTREAM_XON || b == USTREAM_XOFF || b == PROF_SYNC0 || b == PROF_ESC) {
+		UART_PutChar((char)PROF_ESC);
+		b ^= PROF_ESC_XOR;
+	}
+	UART_PutChar((char)b);
+}
+
+static uint8_t PROF_PutByte(uint8_t b, uint8_t sum)
+{
+	PROF_PutEscaped(b);
+	return sum + b;
+}
+
+void PROF_Flush(void)
+{
+	uint8_t sum = 0;
+
+	// Lo acumulado sale en el siguiente volcado
+	if (USTREAM_Pending()) return;
+
+	UART_PutChar((char)PROF_SYNC0);
+	UART_PutChar(PROF_SYNC1);
+	sum = PROF_PutByte(PROF_IDS, sum);
+
+	for (uint8_t i = 0; i < PROF_IDS; i++) {
+		uint32_t t = prof_total[i];
+		for (uint8_t k = 0; k < 4; k++) {
+			sum = PROF_PutByte((uint8_t)t, sum);
+			t >>= 8;
+		}
+		sum = PROF_PutByte((uint8_t)prof_count[i], sum);
+		sum = PROF_PutByte((uint8_t)(prof_count[i] >> 8), sum);
+
+		prof_total[i] = 0;
+		prof_count[i] = 0;
+	}
+
+	PROF_PutEscaped(sum);
+}
+
+#endif /* PROF_ENABLE */
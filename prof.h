@@ -0,0 +1,55 @@
+// prof.h - Sondas de perfilado por fase (opcionales en compilacin)
+#ifndef PROF_H_
+#define PROF_H_
+
+#include <stdint.h>
+
+// Fases medidas. Pueden anidarse entre s (una lectura SD ocurre dentro
+// de BMP_StreamRow), pero una misma fase no se anida consigo misma. Cada
+// fase cuenta solo su tiempo propio: lo que pasa dentro de otra sonda se
+// le descuenta, as las fases de un fotograma suman el fotograma.
+#define PROF_FRAME        0   // resto del fotograma (galera o fractal)
+#define PROF_SD_WAIT      1   // comando SD + espera del token de datos
+#define PROF_SD_DATA      2   // 512 bytes + CRC de un sector
+#define PROF_FAT_COPY     3   // memcpy del buffer de sector en FAT_Read
+#define PROF_BMP_CONVERT  4   // BGR888 -> pxel TFT y su envo en BMP_StreamRow
+#define PROF_TFT_WRITE    5   // ventanas, rellenos y rfagas al TFT
+#define PROF_FRACTAL_ITER 6   // iteracin de rbitas
+#define PROF_IDS          7
+
+#ifdef PROF_ENABLE
+
+// Timer1 (cycles.c) + USART a UART_STREAM_BAUD (uart.c, la misma
+// configuracin que uart_stream.c); habilita interrupciones
+void PROF_Init(void);
+void PROF_Enter(uint8_t id);
+void PROF_Exit(uint8_t id);
+
+// Manda por la USART el total de ciclos y de entradas de cada fase
+// desde el ltimo volcado y los pone a cero. Llamar fuera de cualquier
+// transaccin SPI (la USART no comparte pines con el bus, pero el
+// paquete, de 46 bytes, tarda ~1 ms a 500 kbaud; ~2 ms si hay que
+// escapar muchos). Si hay bytes del host sin procesar (uart_stream.h)
+// no manda nada y sigue acumulando.
+//
+// Paquete: 0xC3 'P' n, luego n veces [ciclos u32 LE][entradas u16 LE],
+// y un byte de suma (mod 256) de todo lo que sigue a 0xC3 'P'. Tras
+// esos dos, 0x11, 0x13, 0xC3 y 0x7D van como 0x7D, byte ^ 0x20.
+void PROF_Flush(void);
+
+#define PROF_INIT()       PROF_Init()
+#define PROF_ENTER(id)    PROF_Enter(id)
+#define PROF_EXIT(id)     PROF_Exit(id)
+#define PROF_FLUSH()      PROF_Flush()
+
+#else
+
+// Compilado sin PROF_ENABLE: las sondas no generan cdigo
+#define PROF_INIT()       do { } while (0)
+#define PROF_ENTER(id)    do { } while (0)
+#define PROF_EXIT(id)     do { } while (0)
+#define PROF_FLUSH()      do { } while (0)
+
+#endif /* PROF_ENABLE */
+
+#endif /* PROF_H_ */
@@ -0,0 +1,13 @@
+// scratch.c - Memoria de trabajo compartida entre los modos
+#include "scratch.h"
+
+SCRATCH_Arena g_scratch;
+
+static uint8_t scratch_owner = SCRATCH_NONE;
+
+uint8_t SCRATCH_Claim(uint8_t owner)
+{
+	uint8_t lost = (scratch_owner != owner);
+	scratch_owner = owner;
+	return lost;
+}
@@ -0,0 +1,56 @@
+// scratch.h - Memoria de trabajo compartida entre los modos
+#ifndef SCRATCH_H_
+#define SCRATCH_H_
+
+#include <stdint.h>
+#include "bmp_stream.h"
+#include "pak.h"
+#include "anim.h"
+#include "fractal.h"
+
+// Lo que un modo solo necesita mientras est activo va en su regin de
+// g_scratch, y todas las regiones ocupan los mismos bytes: el visor y el
+// fractal nunca estn a la vez. Lo que tiene que sobrevivir a un cambio
+// de modo (la vista del fractal, el sector de la FAT, el buffer de la
+// USART) sigue en su mdulo.
+//
+// El arena mide lo que su regin mayor, sin reserva aparte. An no hay
+// cifras de avr-gcc de lo que queda libre por modo: si las pilas del
+// visor, del fractal y del stream caben en el resto de los 2 KB est
+// sin medir. Antes de agrandar una regin, pasar host/ramplan.c sobre
+// la salida de avr-gcc (-fcallgraph-info=su y avr-nm -S).
+
+#define SCRATCH_MAX_FILES 16
+
+// Dueos del arena
+#define SCRATCH_NONE      0
+#define SCRATCH_GALLERY   1
+#define SCRATCH_FRACTAL   2
+
+// Visor: lista de archivos, imagen actual y siguiente, paquete y
+// animacin
+typedef struct {
+	char      list[SCRATCH_MAX_FILES][13];
+	BMP_Image img;
+	BMP_Image next;
+	PAK_File  pak;
+	ANIM_File anim;
+} SCRATCH_Gallery;
+
+// Fractal: tabla de colores de FRACTAL_Recolor (258 bytes; antes en pila)
+typedef struct {
+	uint16_t lut[FRACTAL_RECOLOR_MAX_ITER + 1];
+} SCRATCH_Fractal;
+
+typedef union {
+	SCRATCH_Gallery gallery;
+	SCRATCH_Fractal fractal;
+} SCRATCH_Arena;
+
+extern SCRATCH_Arena g_scratch;
+
+// Pasa el arena a 'owner'. Devuelve 1 si antes era de otro (o de nadie):
+// su regin no conserva nada y el modo tiene que rehacer su estado.
+uint8_t SCRATCH_Claim(uint8_t owner);
+
+#endif /* SCRATCH_H_ */
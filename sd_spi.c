@@ -1,8 +1,12 @@
 // sd_spi.c
 #include "sd_spi.h"
 #include "spi_hal.h"
+#include "prof.h"
 
 #define SD_TOKEN_START_BLOCK  0xFE
+#define SD_DATA_ACCEPTED      0x05
+
+SD_Stats g_sd_stats;
 
 // Enva mltiples clocks con MOSI=1 para despertar la SD
 static void SD_SendDummyClocks(uint8_t n)
@@ -30,6 +34,9 @@ static uint8_t SD_SendCommand(uint8_t cmd, uint32_t arg, uint8_t crc)
 	SPI_Transfer((uint8_t)(arg));
 	SPI_Transfer(crc | 0x01);
 
+	// Tras CMD12 llega un byte de relleno antes de la respuesta
+	if (cmd == 12) SPI_Transfer(0xFF);
+
 	// Esperar respuesta (bit7=0)
 	do {
 		response = SPI_Transfer(0xFF);
@@ -47,9 +54,33 @@ static uint8_t SD_SendACMD(uint8_t cmd, uint32_t arg, uint8_t crc)
 	return SD_SendCommand(cmd, arg, crc);
 }
 
-uint8_t SD_Init(void)
+// Lee los 4 bytes que siguen a R1 en las respuestas R3 (OCR) y R7
+static uint32_t SD_ReadR3R7(void)
+{
+	uint32_t v = 0;
+	for (uint8_t i = 0; i < 4; i++)
+		v = (v << 8) | SPI_Transfer(0xFF);
+	return v;
+}
+
+static uint8_t sd_type = SD_TYPE_NONE;
+
+uint8_t SD_CardType(void)
+{
+	return sd_type;
+}
+
+// Direccin que lleva el argumento de CMD17/18/24: en bytes (SDSC) o en
+// bloques de 512 (SDHC/SDXC)
+static uint32_t SD_Address(uint32_t lba)
+{
+	return (sd_type == SD_TYPE_SDHC) ? lba : lba * 512UL;
+}
+
+static uint8_t SD_Identify(void)
 {
-	uint8_t i, r;
+	uint8_t  r;
+	uint16_t i;
 
 	SPI_SD_Unselect();
 	SD_SendDummyClocks(10);   // al menos 74 ciclos
@@ -66,41 +97,88 @@ uint8_t SD_Init(void)
 		return SD_ERR_INIT;
 	}
 
-	// Intentar inicializar con ACMD41 (SDC)
+	// CMD8: solo las tarjetas v2 lo entienden, y devuelven el patrn
+	// 0xAA con el rango de tensin aceptado
+	uint32_t acmd41_arg = 0;
+	r = SD_SendCommand(8, 0x1AA, 0x87);
+	if (r & 0x04) {
+		sd_type = SD_TYPE_SDSC1;            // comando ilegal: SD v1
+	} else {
+		uint32_t r7 = SD_ReadR3R7();
+		if (r != 0x01 || (r7 & 0xFFF) != 0x1AA) {
+			SPI_SD_Unselect();
+			return SD_ERR_INIT;
+		}
+		sd_type = SD_TYPE_SDSC2;
+		acmd41_arg = 0x40000000UL;          // HCS: el host admite SDHC
+	}
+
+	// ACMD41 hasta que sale de idle (puede tardar hasta 1 s)
 	i = 0;
 	do {
-		r = SD_SendACMD(41, 0, 0x01);
+		r = SD_SendACMD(41, acmd41_arg, 0x01);
 		i++;
-	} while ((r != 0x00) && (i < 200));
+	} while ((r != 0x00) && (i < 1000));
 
-	SPI_SD_Unselect();
-	SPI_Transfer(0xFF);
+	if (r != 0x00) {
+		SPI_SD_Unselect();
+		return SD_ERR_INIT;
+	}
 
-	if (r != 0x00) return SD_ERR_INIT;
+	// CMD58: el bit CCS del OCR dice si direcciona por bloques
+	if (sd_type == SD_TYPE_SDSC2) {
+		r = SD_SendCommand(58, 0, 0x01);
+		uint32_t ocr = SD_ReadR3R7();
+		if (r != 0x00) {
+			SPI_SD_Unselect();
+			return SD_ERR_INIT;
+		}
+		if (ocr & 0x40000000UL) sd_type = SD_TYPE_SDHC;
+	}
 
-	// Opcional: fijar tamao de bloque a 512 con CMD16
-	SPI_SD_Select();
-	r = SD_SendCommand(16, 512, 0x01);
 	SPI_SD_Unselect();
 	SPI_Transfer(0xFF);
-	if (r != 0x00) return SD_ERR_INIT;
+
+	// Bloques de 512 con CMD16 (las SDHC ya los tienen fijos)
+	if (sd_type != SD_TYPE_SDHC) {
+		SPI_SD_Select();
+		r = SD_SendCommand(16, 512, 0x01);
+		SPI_SD_Unselect();
+		SPI_Transfer(0xFF);
+		if (r != 0x00) return SD_ERR_INIT;
+	}
 
 	return SD_OK;
 }
 
-uint8_t SD_ReadBlock(uint32_t lba, uint8_t *buffer)
+uint8_t SD_Init(void)
+{
+	// La identificacin va a < 400 kHz; despus, el bus a tope (tambin
+	// para el TFT, que lo comparte)
+	sd_type = SD_TYPE_NONE;
+	SPI_SetClock(SD_INIT_CLOCK_DIV);
+
+	uint8_t r = SD_Identify();
+	if (r != SD_OK) sd_type = SD_TYPE_NONE;
+
+	SPI_SetClock(SPI_CLOCK_MAX);
+	return r;
+}
+
+uint8_t SD_ReadPartial(uint32_t lba, uint8_t *buffer, uint16_t offset, uint16_t count)
 {
 	uint8_t r;
 	uint16_t i;
 	uint16_t timeout;
 
-	// Para SDSC asumimos lba*512 = direccin byte.
-	uint32_t addr = lba * 512UL;
+	uint32_t addr = SD_Address(lba);
 
+	PROF_ENTER(PROF_SD_WAIT);
 	SPI_SD_Select();
 	r = SD_SendCommand(17, addr, 0x01);
 	if (r != 0x00) {
 		SPI_SD_Unselect();
+		PROF_EXIT(PROF_SD_WAIT);
 		return SD_ERR_INIT;
 	}
 
@@ -110,12 +188,71 @@ uint8_t SD_ReadBlock(uint32_t lba, uint8_t *buffer)
 		r = SPI_Transfer(0xFF);
 	} while ((r != SD_TOKEN_START_BLOCK) && --timeout);
 
+	PROF_EXIT(PROF_SD_WAIT);
+
 	if (!timeout) {
 		SPI_SD_Unselect();
 		return SD_ERR_TIMEOUT;
 	}
 
-	// Leer 512 bytes
+	// Leer 512 bytes; solo se guardan los de [offset, offset+count)
+	PROF_ENTER(PROF_SD_DATA);
+	for (i = 0; i < 512; i++) {
+		uint8_t b = SPI_Transfer(0xFF);
+		if (i >= offset && i - offset < count)
+			*buffer++ = b;
+	}
+
+	// CRC (2 bytes, ignorados)
+	SPI_Transfer(0xFF);
+	SPI_Transfer(0xFF);
+
+	SPI_SD_Unselect();
+	SPI_Transfer(0xFF);
+	PROF_EXIT(PROF_SD_DATA);
+
+	g_sd_stats.blocks_read++;
+	return SD_OK;
+}
+
+uint8_t SD_ReadBlock(uint32_t lba, uint8_t *buffer)
+{
+	return SD_ReadPartial(lba, buffer, 0, 512);
+}
+
+uint8_t SD_ReadMultiStart(uint32_t lba)
+{
+	uint32_t addr = SD_Address(lba);
+
+	SPI_SD_Select();
+	uint8_t r = SD_SendCommand(18, addr, 0x01);
+	SPI_SD_Unselect();
+
+	return (r == 0x00) ? SD_OK : SD_ERR_INIT;
+}
+
+uint8_t SD_ReadMultiNext(uint8_t *buffer)
+{
+	uint8_t r;
+	uint16_t i;
+	uint16_t timeout;
+
+	PROF_ENTER(PROF_SD_WAIT);
+	SPI_SD_Select();
+
+	timeout = 0xFFFF;
+	do {
+		r = SPI_Transfer(0xFF);
+	} while ((r != SD_TOKEN_START_BLOCK) && --timeout);
+
+	PROF_EXIT(PROF_SD_WAIT);
+
+	if (!timeout) {
+		SPI_SD_Unselect();
+		return SD_ERR_TIMEOUT;
+	}
+
+	PROF_ENTER(PROF_SD_DATA);
 	for (i = 0; i < 512; i++) {
 		buffer[i] = SPI_Transfer(0xFF);
 	}
@@ -124,8 +261,74 @@ uint8_t SD_ReadBlock(uint32_t lba, uint8_t *buffer)
 	SPI_Transfer(0xFF);
 	SPI_Transfer(0xFF);
 
+	SPI_SD_Unselect();
+	PROF_EXIT(PROF_SD_DATA);
+
+	g_sd_stats.blocks_read++;
+	return SD_OK;
+}
+
+uint8_t SD_ReadMultiStop(void)
+{
+	uint16_t timeout;
+
+	SPI_SD_Select();
+	uint8_t r = SD_SendCommand(12, 0, 0x01);
+
+	// La tarjeta puede quedar ocupada (MISO a 0) un momento
+	timeout = 0xFFFF;
+	while (SPI_Transfer(0xFF) == 0x00 && --timeout);
+
+	SPI_SD_Unselect();
+	SPI_Transfer(0xFF);
+
+	if (!timeout) return SD_ERR_TIMEOUT;
+	return (r == 0x00) ? SD_OK : SD_ERR_INIT;
+}
+
+uint8_t SD_WriteBlock(uint32_t lba, const uint8_t *buffer)
+{
+	uint8_t r;
+	uint16_t i;
+	uint16_t timeout;
+
+	uint32_t addr = SD_Address(lba);
+
+	SPI_SD_Select();
+	r = SD_SendCommand(24, addr, 0x01);
+	if (r != 0x00) {
+		SPI_SD_Unselect();
+		return SD_ERR_INIT;
+	}
+
+	// Un byte de separacin y luego el token de inicio
+	SPI_Transfer(0xFF);
+	SPI_Transfer(SD_TOKEN_START_BLOCK);
+
+	for (i = 0; i < 512; i++) {
+		SPI_Transfer(buffer[i]);
+	}
+
+	// CRC (2 bytes, ignorados en modo SPI)
+	SPI_Transfer(0xFF);
+	SPI_Transfer(0xFF);
+
+	// Data response: xxx0sss1, sss=010 -> aceptado
+	r = SPI_Transfer(0xFF);
+	if ((r & 0x1F) != SD_DATA_ACCEPTED) {
+		SPI_SD_Unselect();
+		return SD_ERR_WRITE;
+	}
+
+	// La tarjeta mantiene MISO a 0 mientras programa
+	timeout = 0xFFFF;
+	while (SPI_Transfer(0xFF) == 0x00 && --timeout);
+
 	SPI_SD_Unselect();
 	SPI_Transfer(0xFF);
 
+	if (!timeout) return SD_ERR_TIMEOUT;
+
+	g_sd_stats.blocks_written++;
 	return SD_OK;
 }
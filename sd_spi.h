@@ -7,14 +7,50 @@
 #define SD_OK          0
 #define SD_ERR_INIT    1
 #define SD_ERR_TIMEOUT 2
+#define SD_ERR_WRITE   3
 
-// Inicializa la SD en modo SPI.
+// Tipo de tarjeta detectado por SD_Init
+#define SD_TYPE_NONE   0
+#define SD_TYPE_SDSC1  1     // v1, direcciones en bytes
+#define SD_TYPE_SDSC2  2     // v2 de capacidad estndar, en bytes
+#define SD_TYPE_SDHC   3     // SDHC/SDXC, direcciones en bloques de 512
+
+// Divisor del SPI mientras se identifica la tarjeta (< 400 kHz)
+#define SD_INIT_CLOCK_DIV  128
+
+// Contadores de sectores transferidos (para diagnstico, no se reinician)
+typedef struct {
+	uint32_t blocks_read;
+	uint32_t blocks_written;
+} SD_Stats;
+
+extern SD_Stats g_sd_stats;
+
+// Inicializa la SD en modo SPI (CMD0, CMD8, ACMD41, CMD58, CMD16) con el
+// SPI a SD_INIT_CLOCK_DIV y al terminar lo deja en SPI_CLOCK_MAX.
 // Devuelve SD_OK si todo bien.
 uint8_t SD_Init(void);
+uint8_t SD_CardType(void);
 
 // Lee un bloque (sector) de 512 bytes.
-// lba = nmero de sector lgico (para SDSC, sector = bloque).
+// lba = nmero de sector de 512 bytes; se pasa a direccin en bytes o
+// en bloques segn el tipo de tarjeta.
 // buffer debe ser de 512 bytes.
 uint8_t SD_ReadBlock(uint32_t lba, uint8_t *buffer);
 
+// Lee un sector pero guarda solo 'count' bytes a partir de 'offset'
+// (buffer recibe count bytes). El sector entero pasa igual por el bus.
+uint8_t SD_ReadPartial(uint32_t lba, uint8_t *buffer, uint16_t offset, uint16_t count);
+
+// Lectura de sectores consecutivos con CMD18: un solo comando y una
+// sola espera de acceso para todo el tramo. Entre bloques la SD se
+// deselecciona, as el bus queda libre (p.ej. para el TFT).
+uint8_t SD_ReadMultiStart(uint32_t lba);
+uint8_t SD_ReadMultiNext(uint8_t *buffer);   // siguiente bloque de 512 bytes
+uint8_t SD_ReadMultiStop(void);              // CMD12
+
+// Escribe un bloque (sector) de 512 bytes con CMD24.
+// Espera a que la tarjeta termine de programar antes de volver.
+uint8_t SD_WriteBlock(uint32_t lba, const uint8_t *buffer);
+
 #endif /* SD_SPI_H_ */
@@ -1,11 +1,14 @@
 // spi_hal.c
+//
+// Las funciones de bus y pines son envoltorios de las versiones inline
+// de spi_hal.h; el nombre entre parntesis evita que se expanda la macro.
 #include "spi_hal.h"
 
 // Inicializa SPI como maestro
 void SPI_Init(uint8_t clock_div)
 {
-	// MOSI, SCK y TFT_CS, SD_CS, DC, RST como salida
-	SPI_DDR |= (1<<SPI_MOSI) | (1<<SPI_SCK);
+	// MOSI, SCK, SS y TFT_CS, SD_CS, DC, RST como salida
+	SPI_DDR |= (1<<SPI_MOSI) | (1<<SPI_SCK) | (1<<SPI_SS);
 	TFT_CS_DDR |= (1<<TFT_CS_PIN);
 	SD_CS_DDR  |= (1<<SD_CS_PIN);
 	TFT_DC_DDR |= (1<<TFT_DC_PIN);
@@ -18,6 +21,11 @@ void SPI_Init(uint8_t clock_div)
 	// MISO como entrada
 	SPI_DDR &= ~(1<<SPI_MISO);
 
+	SPI_SetClock(clock_div);
+}
+
+void SPI_SetClock(uint8_t clock_div)
+{
 	// Configuracin base: Maestro, habilitado
 	uint8_t spr = 0;
 	uint8_t spi2x = 0;
@@ -40,42 +48,27 @@ void SPI_Init(uint8_t clock_div)
 }
 
 // Enva y recibe un byte por SPI
-uint8_t SPI_Transfer(uint8_t data)
+uint8_t (SPI_Transfer)(uint8_t data)
 {
-	SPDR = data;
-	while(!(SPSR & (1<<SPIF)));
-	return SPDR;
+	return spi_transfer(data);
 }
 
+// Envo solapado (ver spi_hal.h)
+void (SPI_Start)(uint8_t data) { spi_start(data); }
+void (SPI_Wait)(void)          { spi_wait(); }
+void (SPI_Finish)(void)        { spi_finish(); }
+
 // Seleccionar / deseleccionar TFT
-void SPI_TFT_Select(void)
-{
-	TFT_CS_PORT &= ~(1<<TFT_CS_PIN);
-}
-void SPI_TFT_Unselect(void)
-{
-	TFT_CS_PORT |= (1<<TFT_CS_PIN);
-}
+void (SPI_TFT_Select)(void)   { spi_tft_select(); }
+void (SPI_TFT_Unselect)(void) { spi_tft_unselect(); }
 
 // Seleccionar / deseleccionar SD
-void SPI_SD_Select(void)
-{
-	SD_CS_PORT &= ~(1<<SD_CS_PIN);
-}
-void SPI_SD_Unselect(void)
-{
-	SD_CS_PORT |= (1<<SD_CS_PIN);
-}
+void (SPI_SD_Select)(void)    { spi_sd_select(); }
+void (SPI_SD_Unselect)(void)  { spi_sd_unselect(); }
 
-// DC: comando o dato
-void TFT_DC_Command(void)
-{
-	TFT_DC_PORT &= ~(1<<TFT_DC_PIN); // DC=0
-}
-void TFT_DC_Data(void)
-{
-	TFT_DC_PORT |= (1<<TFT_DC_PIN);  // DC=1
-}
+// DC: comando (0) o dato (1)
+void (TFT_DC_Command)(void)   { spi_dc_command(); }
+void (TFT_DC_Data)(void)      { spi_dc_data(); }
 
 // Reset corto del TFT
 void TFT_Reset_Pulse(void)
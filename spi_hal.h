@@ -4,39 +4,25 @@
 
 #include <avr/io.h>
 #include <stdint.h>
+#include "board.h"
 
-// Pines SPI del ATmega32
-// MOSI = PB5, MISO = PB6, SCK = PB7 (hardware SPI)
-#define SPI_DDR      DDRB
-#define SPI_PORT     PORTB
-#define SPI_PIN_REG  PINB
-
-#define SPI_MOSI     PB5
-#define SPI_MISO     PB6
-#define SPI_SCK      PB7
-
-// Chip Select del TFT (antes era tu SS_PIN)
-#define TFT_CS_DDR   DDRB
-#define TFT_CS_PORT  PORTB
-#define TFT_CS_PIN   PB4
-
-// Chip Select de la SD (ejemplo: PD2)
-#define SD_CS_DDR    DDRD
-#define SD_CS_PORT   PORTD
-#define SD_CS_PIN    PD2
-
-// Pines de control del TFT
-#define TFT_DC_DDR   DDRB
-#define TFT_DC_PORT  PORTB
-#define TFT_DC_PIN   PB1
-
-#define TFT_RST_DDR  DDRB
-#define TFT_RST_PORT PORTB
-#define TFT_RST_PIN  PB0
+// Pines: board.h
 
 void SPI_Init(uint8_t clock_div);      // clock_div: 2,4,8,16,32,64,128 (aprox)
+// Cambia solo el divisor del reloj SPI (p.ej. lento para identificar la
+// SD y al mximo despus)
+void SPI_SetClock(uint8_t clock_div);
+#define SPI_CLOCK_MAX  2                // F_CPU/2, lo ms rpido del ATmega32
 uint8_t SPI_Transfer(uint8_t data);
 
+// Envo solapado para rfagas: SPI_Start deja un byte saliendo y vuelve
+// en el acto, as el siguiente se prepara mientras tanto; antes de otro
+// SPI_Start hay que esperar con SPI_Wait. SPI_Finish espera el ltimo y
+// deja SPIF limpio para el prximo SPI_Transfer.
+void SPI_Start(uint8_t data);
+void SPI_Wait(void);
+void SPI_Finish(void);
+
 void SPI_TFT_Select(void);
 void SPI_TFT_Unselect(void);
 
@@ -48,4 +34,41 @@ void TFT_DC_Data(void);
 
 void TFT_Reset_Pulse(void);
 
+// Las mismas operaciones inline, con los pines de board.h resueltos al
+// compilar. En AVR las llamadas de arriba se convierten en estas (las
+// funciones de spi_hal.c siguen existiendo como envoltorios); en el
+// simulador no, para que host/spi_hal_sim.c vea cada byte y cada pin.
+// -DSPI_HAL_CALLS vuelve a las llamadas (para comparar en el benchmark).
+
+static inline uint8_t spi_transfer(uint8_t data)
+{
+	SPDR = data;
+	while (!(SPSR & (1<<SPIF)));
+	return SPDR;
+}
+
+static inline void spi_start(uint8_t data) { SPDR = data; }
+static inline void spi_wait(void)          { while (!(SPSR & (1<<SPIF))); }
+static inline void spi_finish(void)        { spi_wait(); (void)SPDR; }
+
+static inline void spi_tft_select(void)   { TFT_CS_PORT &= (uint8_t)~(1<<TFT_CS_PIN); }
+static inline void spi_tft_unselect(void) { TFT_CS_PORT |= (1<<TFT_CS_PIN); }
+static inline void spi_sd_select(void)    { SD_CS_PORT &= (uint8_t)~(1<<SD_CS_PIN); }
+static inline void spi_sd_unselect(void)  { SD_CS_PORT |= (1<<SD_CS_PIN); }
+static inline void spi_dc_command(void)   { TFT_DC_PORT &= (uint8_t)~(1<<TFT_DC_PIN); }
+static inline void spi_dc_data(void)      { TFT_DC_PORT |= (1<<TFT_DC_PIN); }
+
+#if defined(__AVR__) && !defined(SPI_HAL_CALLS)
+#define SPI_Transfer(d)     spi_transfer(d)
+#define SPI_Start(d)        spi_start(d)
+#define SPI_Wait()          spi_wait()
+#define SPI_Finish()        spi_finish()
+#define SPI_TFT_Select()    spi_tft_select()
+#define SPI_TFT_Unselect()  spi_tft_unselect()
+#define SPI_SD_Select()     spi_sd_select()
+#define SPI_SD_Unselect()   spi_sd_unselect()
+#define TFT_DC_Command()    spi_dc_command()
+#define TFT_DC_Data()       spi_dc_data()
+#endif
+
 #endif /* SPI_HAL_H_ */
@@ -0,0 +1,217 @@
+// sprite.c - Sprites con transparencia por tramos opacos
+//
+// Cada tramo opaco de una fila es una ventana de una fila en el TFT: lo
+// transparente ni se lee de la fuente ni se enva. Los pxeles se leen
+// en trozos de SPR_CHUNK_PX a un buffer en pila y se envan en una
+// rfaga, as la SD y el TFT no comparten nunca el bus a la vez.
+
+#include "sprite.h"
+#include "tft_st7735.h"
+#include <avr/pgmspace.h>
+#include <string.h>
+
+static SPR_Sprite *spr_src;
+static uint16_t    spr_pos;          // bytes de las filas ya ledos
+
+static uint8_t SPR_Check(SPR_Sprite *s, const uint8_t *h)
+{
+	if (h[0] != 'S' || h[1] != 'P' || h[2] != 'R' || h[3] != '1' ||
+	    h[4] == 0 || h[4] > SPR_MAX_W || h[5] == 0)
+		return SPR_ERR_FORMAT;
+
+	s->w    = h[4];
+	s->h    = h[5];
+	s->size = h[6] | ((uint16_t)h[7] << 8);
+	return SPR_OK;
+}
+
+uint8_t SPR_FromFlash(SPR_Sprite *s, const uint8_t *data)
+{
+	uint8_t h[SPR_HEADER];
+
+	memcpy_P(h, data, SPR_HEADER);
+	s->flash = data;
+	return SPR_Check(s, h);
+}
+
+uint8_t SPR_Open(SPR_Sprite *s, const char *name)
+{
+	uint8_t h[SPR_HEADER];
+
+	if (FAT_Open(&s->file, name) != 0) return SPR_ERR_OPEN;
+	if (FAT_Read(&s->file, h, SPR_HEADER) != SPR_HEADER) return SPR_ERR_FORMAT;
+
+	s->flash = 0;
+	uint8_t r = SPR_Check(s, h);
+	if (r == SPR_OK && s->file.size_bytes < (uint32_t)SPR_HEADER + s->size)
+		r = SPR_ERR_FORMAT;
+	return r;
+}
+
+static void SPR_Rewind(SPR_Sprite *s)
+{
+	spr_src = s;
+	spr_pos = 0;
+	if (!s->flash) s->file.current_pos = SPR_HEADER;
+}
+
+static uint8_t SPR_Read(uint8_t *buf, uint16_t n)
+{
+	if (n > spr_src->size - spr_pos) return SPR_ERR_FORMAT;
+
+	if (spr_src->flash)
+		memcpy_P(buf, spr_src->flash + SPR_HEADER + spr_pos, n);
+	else if (FAT_Read(&spr_src->file, buf, n) != (int16_t)n)
+		return SPR_ERR_IO;
+
+	spr_pos += n;
+	return SPR_OK;
+}
+
+uint8_t SPR_Blit(SPR_Sprite *s, uint8_t x, uint8_t y)
+{
+	uint8_t buf[SPR_CHUNK_PX * 2];
+	uint8_t r = SPR_OK;
+
+	SPR_Rewind(s);
+
+	for (uint8_t row = 0; row < s->h && r == SPR_OK; row++) {
+		uint16_t sy = (uint16_t)y + row;
+		uint8_t  spans;
+
+		if (sy >= TFT_HEIGHT) break;     // el resto queda fuera
+		if ((r = SPR_Read(&spans, 1)) != SPR_OK) break;
+
+		uint8_t gram = TFT_ScreenToGram((uint8_t)sy);
+
+		for (; spans && r == SPR_OK; spans--) {
+			uint8_t span[2];
+			if ((r = SPR_Read(span, 2)) != SPR_OK) break;
+
+			// Recorte por la derecha: se leen igual, no se envan
+			uint16_t sx  = (uint16_t)x + span[0];
+			uint8_t  vis = 0;
+			if (sx < TFT_WIDTH)
+				vis = (span[1] < TFT_WIDTH - sx) ? span[1] : (uint8_t)(TFT_WIDTH - sx);
+			if (vis)
+				TFT_SetAddrWindow((uint8_t)sx, gram, (uint8_t)(sx + vis - 1), gram);
+
+			for (uint8_t done = 0; done < span[1]; ) {
+				uint8_t n = span[1] - done;
+				if (n > SPR_CHUNK_PX) n = SPR_CHUNK_PX;
+				if ((r = SPR_Read(buf, 2 * n)) != SPR_OK) break;
+
+				if (done < vis) {
+					uint8_t k = (vis - done < n) ? vis - done : n;
+					TFT_StartWrite();
+					TFT_WriteBytes(buf, 2 * k);
+					TFT_EndWrite();
+				}
+				done += n;
+			}
+		}
+	}
+
+	TFT_FlushHalf();    // un tramo impar en 12 bits
+	return r;
+}
+
+/* ==========================================================
+   FONDO GUARDADO
+   ========================================================== */
+
+// Posicin ajustada para que el sprite quepa entero: as el fondo
+// guardado es siempre de w x h y un movimiento es un desplazamiento
+// fijo dentro del buffer
+static void SPR_Place(const SPR_Sprite *s, uint8_t *x, uint8_t *y)
+{
+	if (*x > TFT_WIDTH - s->w)  *x = TFT_WIDTH - s->w;
+	if (*y > TFT_HEIGHT - s->h) *y = TFT_HEIGHT - s->h;
+}
+
+// Fila del buffer -> pantalla
+static void SPR_PutRow(uint8_t x, uint8_t y, uint8_t w, const uint16_t *px)
+{
+	uint8_t gram = TFT_ScreenToGram(y);
+
+	TFT_SetAddrWindow(x, gram, x + w - 1, gram);
+	TFT_StartWrite();
+	for (uint8_t i = 0; i < w; i++)
+		TFT_WriteColor(px[i]);
+	TFT_EndWrite();
+}
+
+void SPR_Hide(SPR_Save *save)
+{
+	if (!save->shown) return;
+
+	for (uint8_t r = 0; r < save->h; r++)
+		SPR_PutRow(save->x, save->y + r, save->w, save->px + (uint16_t)r * save->w);
+	TFT_FlushHalf();
+	save->shown = 0;
+}
+
+uint8_t SPR_Show(SPR_Sprite *s, SPR_Save *save, uint8_t x, uint8_t y, SPR_BackFn back)
+{
+	if (s->w > TFT_WIDTH || s->h > TFT_HEIGHT ||
+	    (uint16_t)s->w * s->h > save->cap)
+		return SPR_ERR_SPACE;
+
+	SPR_Hide(save);
+	SPR_Place(s, &x, &y);
+
+	save->x = x;
+	save->y = y;
+	save->w = s->w;
+	save->h = s->h;
+	for (uint8_t r = 0; r < s->h; r++)
+		back(x, y + r, s->w, save->px + (uint16_t)r * s->w);
+	save->shown = 1;
+
+	return SPR_Blit(s, x, y);
+}
+
+uint8_t SPR_Move(SPR_Sprite *s, SPR_Save *save, uint8_t x, uint8_t y, SPR_BackFn back)
+{
+	if (!save->shown || save->w != s->w || save->h != s->h)
+		return SPR_Show(s, save, x, y, back);
+
+	SPR_Place(s, &x, &y);
+
+	uint8_t  ox = save->x, oy = save->y, w = s->w, h = s->h;
+	uint16_t total = (uint16_t)w * h;
+
+	// Todo el rectngulo viejo: donde se solapa con el nuevo el sprite
+	// puede tener transparente lo que antes era opaco
+	SPR_Hide(save);
+
+	// Lo comn a los dos rectngulos pasa a su sitio nuevo: el pxel
+	// (X, Y) va del ndice (Y - oy) * w + (X - ox) al (Y - y) * w + (X - x)
+	int16_t d = (int16_t)((oy - y) * w + (ox - x));
+	uint16_t ad = (d < 0) ? (uint16_t)-d : (uint16_t)d;
+	if (ad < total) {
+		if (d > 0) memmove(save->px + ad, save->px, (total - ad) * sizeof(uint16_t));
+		else       memmove(save->px, save->px + ad, (total - ad) * sizeof(uint16_t));
+	}
+
+	// El resto del rectngulo nuevo se pide a la fuente
+	for (uint8_t r = 0; r < h; r++) {
+		uint8_t   sy  = y + r;
+		uint16_t *row = save->px + (uint16_t)r * w;
+
+		if (sy < oy || sy >= oy + h || x >= ox + w || ox >= x + w) {
+			back(x, sy, w, row);
+			continue;
+		}
+		if (x < ox)
+			back(x, sy, ox - x, row);
+		if (x > ox)
+			back(ox + w, sy, x - ox, row + (ox + w - x));
+	}
+
+	save->x = x;
+	save->y = y;
+	save->shown = 1;
+
+	return SPR_Blit(s, x, y);
+}
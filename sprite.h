@@ -0,0 +1,75 @@
+// sprite.h - Sprites con transparencia por tramos opacos
+#ifndef SPRITE_H_
+#define SPRITE_H_
+
+#include <stdint.h>
+#include "fat_fs.h"
+
+// Formato .SPR (el mismo en la SD y en flash; u16 little endian salvo
+// los pxeles):
+//   0  "SPR1"
+//   4  u8 ancho, u8 alto
+//   6  u16 bytes de las filas que siguen
+//   8  por cada fila, de arriba abajo:
+//        u8 tramos
+//        por tramo, de izquierda a derecha y sin solaparse:
+//          u8 x (desde el borde izquierdo del sprite), u8 pxeles
+//          los pxeles en RGB565, MSB primero
+// Lo transparente no est en el archivo: cada tramo es una ventana del
+// TFT y una rfaga, sin leer nada de la pantalla.
+// host/mkspr.c los genera a partir de BMPs con un color clave.
+
+#define SPR_EXT           "SPR"
+#define SPR_HEADER        8
+#define SPR_MAX_W         64
+#define SPR_CHUNK_PX      16    // pxeles ledos de la fuente por rfaga
+
+#define SPR_OK            0
+#define SPR_ERR_OPEN      1
+#define SPR_ERR_FORMAT    2
+#define SPR_ERR_IO        3
+#define SPR_ERR_SPACE     4     // el fondo no cabe en el buffer
+
+typedef struct {
+	uint8_t        w, h;
+	uint16_t       size;        // bytes de las filas
+	const uint8_t *flash;       // en flash (PROGMEM), o NULL si est en la SD
+	FAT_File       file;
+} SPR_Sprite;
+
+// Fondo bajo un sprite, para moverlo o quitarlo sin repintar la pantalla.
+// El buffer lo pone quien llama (w x h pxeles como mucho) y solo se
+// guarda el rectngulo del sprite.
+typedef struct {
+	uint16_t *px;
+	uint16_t  cap;              // pxeles
+	uint8_t   x, y, w, h;       // rectngulo guardado (pantalla)
+	uint8_t   shown;
+} SPR_Save;
+
+// El TFT no se puede leer: el fondo lo da el modo que pint la pantalla.
+// 'w' pxeles RGB565 de la fila 'y' desde 'x' (coordenadas de pantalla).
+typedef void (*SPR_BackFn)(uint8_t x, uint8_t y, uint8_t w, uint16_t *out);
+
+// Sprite guardado en flash (array generado con mkspr -c)
+uint8_t SPR_FromFlash(SPR_Sprite *s, const uint8_t *data);
+
+// Sprite en un archivo de la SD. Se lee en cada dibujo, a trozos, a
+// travs del buffer de sector de fat_fs.c.
+uint8_t SPR_Open(SPR_Sprite *s, const char *name);
+
+// Dibuja el sprite con su esquina en (x, y) de pantalla; lo que se
+// salga por la derecha o por abajo no se dibuja.
+uint8_t SPR_Blit(SPR_Sprite *s, uint8_t x, uint8_t y);
+
+// Guarda el fondo del rectngulo del sprite en (x, y) y lo dibuja
+uint8_t SPR_Show(SPR_Sprite *s, SPR_Save *save, uint8_t x, uint8_t y, SPR_BackFn back);
+
+// Lo lleva a (x, y): repone desde el buffer el fondo que queda al
+// descubierto y solo pide a 'back' lo que no estaba ya guardado
+uint8_t SPR_Move(SPR_Sprite *s, SPR_Save *save, uint8_t x, uint8_t y, SPR_BackFn back);
+
+// Repone el fondo guardado
+void SPR_Hide(SPR_Save *save);
+
+#endif /* SPRITE_H_ */
@@ -1,6 +1,7 @@
 // tft_st7735.c
 #include "tft_st7735.h"
 #include "spi_hal.h"
+#include "font5x7.h"
 
 // Comandos ST7735
 #define ST7735_SWRESET  0x01
@@ -11,6 +12,15 @@
 #define ST7735_RASET    0x2B
 #define ST7735_RAMWR    0x2C
 #define ST7735_MADCTL   0x36
+#define ST7735_VSCRDEF  0x33
+#define ST7735_VSCSAD   0x37
+
+static uint8_t tft_scroll = 0;
+static uint8_t tft_colmod = TFT_COLOR_565;
+
+// 12 bits: primer pxel de un par a la espera del segundo
+static uint16_t tft_half;
+static uint8_t  tft_half_pending = 0;
 
 static void TFT_WriteCommand(uint8_t cmd)
 {
@@ -49,22 +59,55 @@ void TFT_Init(void)
 	TFT_WriteCommand(ST7735_SLPOUT);
 	for (volatile uint32_t i=0; i<80000; i++);
 
-	// Modo 16 bits por pxel
+	// Formato de pxel (16 bits salvo que se haya pedido otro)
 	TFT_WriteCommand(ST7735_COLMOD);
-	TFT_WriteData(0x05); // 16-bit color
+	TFT_WriteData(tft_colmod);
 
 	// Direccin (MADCTL) bsica
 	TFT_WriteCommand(ST7735_MADCTL);
 	TFT_WriteData(0x00); // ajustar luego segn rotacin
 
+	// Toda la pantalla como rea de scroll, sin desplazamiento
+	TFT_ScrollArea(0, TFT_HEIGHT, 0);
+	TFT_ScrollTo(0);
+
 	// Encender display
 	TFT_WriteCommand(ST7735_DISPON);
 	for (volatile uint32_t i=0; i<80000; i++);
 }
 
+// 12 bits: cierra un par incompleto. Los 4 bits de relleno no llegan a
+// formar un pxel; el siguiente comando los descarta.
+void TFT_FlushHalf(void)
+{
+	if (!tft_half_pending) return;
+
+	TFT_DC_Data();
+	SPI_TFT_Select();
+	SPI_Transfer((uint8_t)(tft_half >> 4));
+	SPI_Transfer((uint8_t)(tft_half << 4));
+	SPI_TFT_Unselect();
+	tft_half_pending = 0;
+}
+
+void TFT_SetColorMode(uint8_t mode)
+{
+	TFT_FlushHalf();
+	TFT_WriteCommand(ST7735_COLMOD);
+	TFT_WriteData(mode);
+	tft_colmod = mode;
+}
+
+uint8_t TFT_GetColorMode(void)
+{
+	return tft_colmod;
+}
+
 // Define regin de escritura (x0..x1, y0..y1)
 void TFT_SetAddrWindow(uint8_t x0, uint8_t y0, uint8_t x1, uint8_t y1)
 {
+	TFT_FlushHalf();
+
 	TFT_WriteCommand(ST7735_CASET);
 	TFT_DC_Data();
 	SPI_TFT_Select();
@@ -93,27 +136,389 @@ void TFT_StartWrite(void)
 	SPI_TFT_Select();
 }
 
+// 12 bits, dos pxeles en 3 bytes: RRRRGGGG BBBBRRRR GGGGBBBB
+void TFT_WriteColor444(uint16_t c444)
+{
+	if (!tft_half_pending) {
+		tft_half = c444;
+		tft_half_pending = 1;
+		return;
+	}
+
+	SPI_Transfer((uint8_t)(tft_half >> 4));
+	SPI_Transfer((uint8_t)(tft_half << 4) | (uint8_t)(c444 >> 8));
+	SPI_Transfer((uint8_t)c444);
+	tft_half_pending = 0;
+}
+
 void TFT_WriteColor(uint16_t color)
 {
+	if (tft_colmod == TFT_COLOR_444) {
+		TFT_WriteColor444(TFT_To444(color));
+		return;
+	}
+
 	SPI_Transfer(color >> 8);
 	SPI_Transfer(color & 0xFF);
 }
 
+void TFT_WriteBytes(const uint8_t *data, uint16_t len)
+{
+	if (tft_colmod == TFT_COLOR_444) {
+		for (uint16_t i = 0; i < len; i += 2)
+			TFT_WriteColor444(TFT_To444((uint16_t)data[i] << 8 | data[i + 1]));
+		return;
+	}
+
+	for (uint16_t i = 0; i < len; i++) {
+		SPI_Transfer(data[i]);
+	}
+}
+
+void TFT_WriteColorRun(uint16_t color, uint16_t count)
+{
+	if (count == 0) return;
+
+	if (tft_colmod == TFT_COLOR_444) {
+		uint16_t c = TFT_To444(color);
+
+		// Completar el par pendiente y luego pares enteros (3 bytes fijos)
+		if (tft_half_pending) {
+			TFT_WriteColor444(c);
+			count--;
+		}
+
+		uint8_t b0 = (uint8_t)(c >> 4);
+		uint8_t b1 = (uint8_t)(c << 4) | (uint8_t)(c >> 8);
+		uint8_t b2 = (uint8_t)c;
+
+		for (uint16_t n = count >> 1; n; n--) {
+			SPI_Transfer(b0);
+			SPI_Transfer(b1);
+			SPI_Transfer(b2);
+		}
+		if (count & 1) TFT_WriteColor444(c);
+		return;
+	}
+
+	uint8_t hi = color >> 8;
+	uint8_t lo = color & 0xFF;
+
+	while (count--) {
+		SPI_Transfer(hi);
+		SPI_Transfer(lo);
+	}
+}
+
+// RGB444 (0x0RGB) -> RGB565, repitiendo los bits altos en los bajos
+static uint16_t TFT_From444(uint16_t c)
+{
+	uint16_t r = (c >> 8) & 0xF, g = (c >> 4) & 0xF, b = c & 0xF;
+	return (uint16_t)((r << 12) | (r << 8 & 0x0800) | (g << 7) | (g << 3 & 0x0060) |
+	                  (b << 1) | (b >> 3));
+}
+
+void TFT_WritePacked444(const uint8_t *data, uint16_t pairs)
+{
+	uint16_t len = pairs * 3;
+
+	if (tft_colmod == TFT_COLOR_444 && !tft_half_pending) {
+		for (uint16_t i = 0; i < len; i++) {
+			SPI_Transfer(data[i]);
+		}
+		return;
+	}
+
+	for (uint16_t i = 0; i < len; i += 3) {
+		uint16_t c0 = (uint16_t)data[i] << 4 | data[i + 1] >> 4;
+		uint16_t c1 = (uint16_t)(data[i + 1] & 0xF) << 8 | data[i + 2];
+		if (tft_colmod == TFT_COLOR_444) {
+			TFT_WriteColor444(c0);
+			TFT_WriteColor444(c1);
+		} else {
+			TFT_WriteColor(TFT_From444(c0));
+			TFT_WriteColor(TFT_From444(c1));
+		}
+	}
+}
+
+// BGR888 -> RGB565, byte alto y bajo
+static inline uint8_t TFT_BGRHi(uint8_t g, uint8_t r)
+{
+	return (uint8_t)((r & 0xF8) | (g >> 5));
+}
+
+static inline uint8_t TFT_BGRLo(uint8_t b, uint8_t g)
+{
+	return (uint8_t)(((g << 3) & 0xE0) | (b >> 3));
+}
+
+void TFT_WriteBGR888(const uint8_t *bgr, uint16_t n)
+{
+	if (n == 0) return;
+
+	if (tft_colmod == TFT_COLOR_444) {
+		for (; n; n--, bgr += 3)
+			TFT_WriteColor444(((uint16_t)(bgr[2] & 0xF0) << 4) |
+			                  (bgr[1] & 0xF0) | (bgr[0] >> 4));
+		return;
+	}
+
+	// Envo solapado: el pxel siguiente se lee y se empaqueta mientras
+	// sale el byte actual (32 ciclos de CPU por byte con SPI_Init(4)), y
+	// solo se espera SPIF justo antes del byte siguiente. En el simulador
+	// SPI_Start es una transferencia ms: host/bgrcheck.c comprueba este
+	// mismo bucle byte a byte.
+	uint8_t lo = TFT_BGRLo(bgr[0], bgr[1]);
+	SPI_Start(TFT_BGRHi(bgr[1], bgr[2]));
+	bgr += 3;
+
+	while (--n) {
+		uint8_t b = bgr[0], g = bgr[1], r = bgr[2];
+		uint8_t nhi = TFT_BGRHi(g, r);
+		uint8_t nlo = TFT_BGRLo(b, g);
+		bgr += 3;
+
+		SPI_Wait();
+		SPI_Start(lo);
+		lo = nlo;
+		SPI_Wait();
+		SPI_Start(nhi);
+	}
+
+	SPI_Wait();
+	SPI_Start(lo);
+	SPI_Finish();
+}
+
 void TFT_EndWrite(void)
 {
 	SPI_TFT_Unselect();
 }
 
+// -----------------------------------------------------------------------------
+// Scroll vertical
+// -----------------------------------------------------------------------------
+void TFT_ScrollArea(uint8_t top, uint8_t height, uint8_t bottom)
+{
+	TFT_WriteCommand(ST7735_VSCRDEF);
+	TFT_WriteData16(top);
+	TFT_WriteData16(height);
+	TFT_WriteData16(bottom);
+}
+
+void TFT_ScrollTo(uint8_t line)
+{
+	TFT_WriteCommand(ST7735_VSCSAD);
+	TFT_WriteData16(line);
+	tft_scroll = line;
+}
+
+uint8_t TFT_GetScroll(void)
+{
+	return tft_scroll;
+}
+
+void TFT_ScrollBy(int16_t lines)
+{
+	int16_t line = ((int16_t)tft_scroll + lines) % TFT_HEIGHT;
+	if (line < 0) line += TFT_HEIGHT;
+	TFT_ScrollTo((uint8_t)line);
+}
+
+uint8_t TFT_ScreenToGram(uint8_t y)
+{
+	return (uint8_t)((tft_scroll + y) % TFT_HEIGHT);
+}
+
+void TFT_FillRect(uint8_t x, uint8_t y, uint8_t w, uint8_t h, uint16_t color)
+{
+	if (w == 0 || h == 0) return;
+
+	TFT_SetAddrWindow(x, y, x + w - 1, y + h - 1);
+	TFT_StartWrite();
+	TFT_WriteColorRun(color, (uint16_t)w * h);
+	TFT_EndWrite();
+	TFT_FlushHalf();
+}
+
 // Llenar toda la pantalla (ejemplo para 128x160)
 void TFT_FillScreen(uint16_t color)
 {
-	uint16_t x, y;
-	TFT_SetAddrWindow(0,0,TFT_WIDTH - 1,TFT_HEIGHT - 1);
+	TFT_FillRect(0, 0, TFT_WIDTH, TFT_HEIGHT, color);
+}
+
+void TFT_FillRectScreen(uint8_t x, uint8_t y, uint8_t w, uint8_t h, uint16_t color)
+{
+	uint8_t mem  = TFT_ScreenToGram(y);
+	uint8_t fits = TFT_HEIGHT - mem;
+
+	if (h <= fits) {
+		TFT_FillRect(x, mem, w, h, color);
+	} else {
+		TFT_FillRect(x, mem, w, fits, color);
+		TFT_FillRect(x, 0, w, h - fits, color);
+	}
+}
+
+// -----------------------------------------------------------------------------
+// Rectngulos sucios
+// -----------------------------------------------------------------------------
+
+typedef struct {
+	uint8_t x0, y0, x1, y1;     // inclusivos
+} TFT_Rect;
+
+static TFT_Rect tft_dirty[TFT_DIRTY_MAX];
+static uint8_t  tft_ndirty;
+
+static uint16_t TFT_RectArea(const TFT_Rect *r)
+{
+	return (uint16_t)(r->x1 - r->x0 + 1) * (r->y1 - r->y0 + 1);
+}
+
+// Caja que contiene a y b en *m; devuelve los pxeles que pintara de
+// ms respecto a a y b por separado
+static uint16_t TFT_RectMerge(const TFT_Rect *a, const TFT_Rect *b, TFT_Rect *m)
+{
+	m->x0 = (a->x0 < b->x0) ? a->x0 : b->x0;
+	m->y0 = (a->y0 < b->y0) ? a->y0 : b->y0;
+	m->x1 = (a->x1 > b->x1) ? a->x1 : b->x1;
+	m->y1 = (a->y1 > b->y1) ? a->y1 : b->y1;
+
+	uint16_t both = TFT_RectArea(a) + TFT_RectArea(b);
+
+	// Lo que se solapa se contara dos veces
+	TFT_Rect i;
+	i.x0 = (a->x0 > b->x0) ? a->x0 : b->x0;
+	i.y0 = (a->y0 > b->y0) ? a->y0 : b->y0;
+	i.x1 = (a->x1 < b->x1) ? a->x1 : b->x1;
+	i.y1 = (a->y1 < b->y1) ? a->y1 : b->y1;
+	if (i.x0 <= i.x1 && i.y0 <= i.y1) both -= TFT_RectArea(&i);
+
+	return TFT_RectArea(m) - both;
+}
+
+// Se solapan o estn pegados
+static uint8_t TFT_RectTouch(const TFT_Rect *a, const TFT_Rect *b)
+{
+	return a->x0 <= b->x1 + 1 && b->x0 <= a->x1 + 1 &&
+	       a->y0 <= b->y1 + 1 && b->y0 <= a->y1 + 1;
+}
+
+void TFT_DirtyAdd(uint8_t x, uint8_t y, uint8_t w, uint8_t h)
+{
+	if (w == 0 || h == 0 || x >= TFT_WIDTH || y >= TFT_HEIGHT) return;
+	if (w > TFT_WIDTH - x)  w = TFT_WIDTH - x;
+	if (h > TFT_HEIGHT - y) h = TFT_HEIGHT - y;
+
+	TFT_Rect r = { x, y, (uint8_t)(x + w - 1), (uint8_t)(y + h - 1) };
+	TFT_Rect m;
+
+	// Fundir con los que toca; la unin puede tocar a otros, as que se
+	// vuelve a empezar cada vez
+	for (uint8_t i = 0; i < tft_ndirty; ) {
+		if (TFT_RectTouch(&tft_dirty[i], &r) &&
+		    TFT_RectMerge(&tft_dirty[i], &r, &m) <= TFT_DIRTY_SLACK) {
+			r = m;
+			tft_dirty[i] = tft_dirty[--tft_ndirty];
+			i = 0;
+		} else {
+			i++;
+		}
+	}
+
+	if (tft_ndirty < TFT_DIRTY_MAX) {
+		tft_dirty[tft_ndirty++] = r;
+		return;
+	}
+
+	// Lista llena: con el que menos pxeles aada
+	uint8_t  best = 0;
+	uint16_t best_waste = 0xFFFF;
+	for (uint8_t i = 0; i < tft_ndirty; i++) {
+		uint16_t waste = TFT_RectMerge(&tft_dirty[i], &r, &m);
+		if (waste < best_waste) {
+			best_waste = waste;
+			best = i;
+		}
+	}
+	TFT_RectMerge(&tft_dirty[best], &r, &m);
+	tft_dirty[best] = m;
+}
+
+void TFT_DirtyFlush(TFT_PaintFn paint)
+{
+	uint32_t area = 0;
+	for (uint8_t i = 0; i < tft_ndirty; i++)
+		area += TFT_RectArea(&tft_dirty[i]);
+
+	if (area * 100 >= (uint32_t)TFT_WIDTH * TFT_HEIGHT * TFT_DIRTY_FULL_PCT) {
+		paint(0, 0, TFT_WIDTH, TFT_HEIGHT);
+	} else {
+		for (uint8_t i = 0; i < tft_ndirty; i++) {
+			const TFT_Rect *r = &tft_dirty[i];
+			paint(r->x0, r->y0, r->x1 - r->x0 + 1, r->y1 - r->y0 + 1);
+		}
+	}
+	tft_ndirty = 0;
+}
+
+// -----------------------------------------------------------------------------
+// Texto 5x7 (celdas de 6x8: una columna y una fila de separacin)
+// -----------------------------------------------------------------------------
+
+// Filas [r0, r1) de la celda de texto, empezando en la lnea de GRAM y.
+// Los pxeles de cada fila se agrupan en tramos del mismo color.
+static void TFT_DrawTextRows(uint8_t x, uint8_t y, const char *s, uint8_t n,
+uint16_t fg, uint16_t bg, uint8_t r0, uint8_t r1)
+{
+	TFT_SetAddrWindow(x, y, x + n * TFT_CHAR_W - 1, y + (r1 - r0) - 1);
 	TFT_StartWrite();
-	for (y = 0; y < TFT_HEIGHT; y++) {
-		for (x = 0; x < TFT_WIDTH; x++) {
-			TFT_WriteColor(color);
+
+	for (uint8_t r = r0; r < r1; r++) {
+		uint16_t run = 0;
+		uint8_t  on  = 0;
+
+		for (uint8_t i = 0; i < n; i++) {
+			uint8_t c = (uint8_t)s[i];
+			if (c < FONT_FIRST || c >= FONT_FIRST + FONT_COUNT) c = '?';
+			const uint8_t *glyph = &font5x7[(c - FONT_FIRST) * FONT_WIDTH];
+
+			for (uint8_t col = 0; col < TFT_CHAR_W; col++) {
+				uint8_t bit = 0;
+				if (col < FONT_WIDTH && r < FONT_HEIGHT)
+					bit = (pgm_read_byte(&glyph[col]) >> r) & 1;
+
+				if (bit != on && run) {
+					TFT_WriteColorRun(on ? fg : bg, run);
+					run = 0;
+				}
+				on = bit;
+				run++;
+			}
 		}
+		TFT_WriteColorRun(on ? fg : bg, run);
 	}
+
 	TFT_EndWrite();
 }
+
+void TFT_DrawString(uint8_t x, uint8_t y, const char *s, uint16_t fg, uint16_t bg)
+{
+	uint8_t n = 0;
+	while (s[n] && x + (n + 1) * TFT_CHAR_W <= TFT_WIDTH) n++;
+	if (n == 0 || y + TFT_CHAR_H > TFT_HEIGHT) return;
+
+	// Fila de pantalla -> lnea de GRAM. Si la celda cruza el final de
+	// la GRAM hacen falta dos ventanas.
+	uint8_t mem  = TFT_ScreenToGram(y);
+	uint8_t fits = TFT_HEIGHT - mem;
+
+	if (fits >= TFT_CHAR_H) {
+		TFT_DrawTextRows(x, mem, s, n, fg, bg, 0, TFT_CHAR_H);
+	} else {
+		TFT_DrawTextRows(x, mem, s, n, fg, bg, 0, fits);
+		TFT_DrawTextRows(x, 0, s, n, fg, bg, fits, TFT_CHAR_H);
+	}
+}
@@ -4,14 +4,83 @@
 #define TFT_WIDTH 132
 #define TFT_HEIGHT 162
 
+// Celda de texto (fuente 5x7 + separacin)
+#define TFT_CHAR_W 6
+#define TFT_CHAR_H 8
+
 #include <stdint.h>
 
+// Formato de pxel en el bus (COLMOD). Los colores de la API son siempre
+// RGB565; en TFT_COLOR_444 se recortan a 4 bits por canal y se envan
+// dos pxeles cada 3 bytes.
+#define TFT_COLOR_565  0x05
+#define TFT_COLOR_444  0x03
+
+// RGB565 -> RGB444 (0x0RGB): los 4 bits altos de cada canal
+static inline uint16_t TFT_To444(uint16_t c)
+{
+	return (uint16_t)(((c >> 4) & 0xF00) | ((c >> 3) & 0x0F0) | ((c >> 1) & 0x00F));
+}
+
 void TFT_Init(void);
+// Cambia el formato en caliente; lo ya dibujado no cambia
+void TFT_SetColorMode(uint8_t mode);
+uint8_t TFT_GetColorMode(void);
 void TFT_FillScreen(uint16_t color);
+void TFT_FillRect(uint8_t x, uint8_t y, uint8_t w, uint8_t h, uint16_t color);
 
+// En 12 bits un pxel suelto queda pendiente hasta el siguiente, tambin
+// a travs de EndWrite/StartWrite; si la ventana tiene un nmero impar de
+// pxeles sale (con relleno) en la siguiente TFT_SetAddrWindow.
 void TFT_SetAddrWindow(uint8_t x0, uint8_t y0, uint8_t x1, uint8_t y1);
 void TFT_StartWrite(void);
 void TFT_WriteColor(uint16_t color);
+void TFT_WriteColor444(uint16_t c444);                 // solo en TFT_COLOR_444
+void TFT_WriteBytes(const uint8_t *data, uint16_t len); // RGB565 ya empaquetado (MSB primero), len par
+void TFT_WriteColorRun(uint16_t color, uint16_t count);  // el mismo color 'count' veces
+// 'pairs' pares de pxeles ya empaquetados en 12 bits (3 bytes cada uno,
+// como en el bus). En TFT_COLOR_444 y sin pxel pendiente salen tal cual;
+// si no, se convierten.
+void TFT_WritePacked444(const uint8_t *data, uint16_t pairs);
+// 'n' pxeles BGR888 (3 bytes, orden de BMP) convertidos al vuelo al
+// formato activo. En AVR y 565 escribe SPDR directamente, sin buffer.
+void TFT_WriteBGR888(const uint8_t *bgr, uint16_t n);
 void TFT_EndWrite(void);
+// Saca ya el pxel pendiente (12 bits), para cuando tras una ventana
+// impar no viene otra: si no, no se ve hasta el siguiente dibujo
+void TFT_FlushHalf(void);
+
+// Scroll vertical por hardware (VSCRDEF / VSCSAD).
+// top + height + bottom debe sumar TFT_HEIGHT.
+void TFT_ScrollArea(uint8_t top, uint8_t height, uint8_t bottom);
+// Lnea de GRAM que se muestra en la primera fila del rea de scroll
+void TFT_ScrollTo(uint8_t line);
+uint8_t TFT_GetScroll(void);
+// Mueve el scroll 'lines' filas (> 0: el contenido sube). La GRAM es
+// circular: las filas que entran por el borde hay que escribirlas.
+void TFT_ScrollBy(int16_t lines);
+// Fila de pantalla -> lnea de GRAM con el scroll actual
+uint8_t TFT_ScreenToGram(uint8_t y);
+// TFT_FillRect en coordenadas de pantalla: se parte en dos ventanas si
+// cruza la vuelta de la GRAM
+void TFT_FillRectScreen(uint8_t x, uint8_t y, uint8_t w, uint8_t h, uint16_t color);
+
+// Rectngulos sucios (coordenadas de pantalla). Se acumulan y se funden
+// los que se tocan o se solapan si la unin no pinta casi nada de ms.
+// TFT_DirtyFlush llama a 'paint' una vez por rectngulo resultante, o
+// una sola con la pantalla entera si cubren TFT_DIRTY_FULL_PCT o ms.
+#define TFT_DIRTY_MAX       6     // 4 bytes cada uno
+#define TFT_DIRTY_SLACK     64    // pxeles de ms aceptados al fundir dos
+#define TFT_DIRTY_FULL_PCT  90
+
+typedef void (*TFT_PaintFn)(uint8_t x, uint8_t y, uint8_t w, uint8_t h);
+
+void TFT_DirtyAdd(uint8_t x, uint8_t y, uint8_t w, uint8_t h);
+void TFT_DirtyFlush(TFT_PaintFn paint);
+
+// Texto ASCII en una sola ventana y una sola rfaga. x, y en pxeles de
+// pantalla (y ya tiene en cuenta el scroll vertical). Se corta en el
+// borde derecho.
+void TFT_DrawString(uint8_t x, uint8_t y, const char *s, uint16_t fg, uint16_t bg);
 
 #endif /* TFT_ST7735_H_ */
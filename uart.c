@@ -0,0 +1,55 @@
+// uart.c
+#include "uart.h"
+#include <avr/io.h>
+
+#ifndef F_CPU
+#define F_CPU 8000000UL
+#endif
+
+void UART_Init(void)
+{
+	uint16_t ubrr = (uint16_t)(F_CPU / (16UL * UART_BAUD) - 1);
+
+	UBRRH = (uint8_t)(ubrr >> 8);
+	UBRRL = (uint8_t)ubrr;
+	UCSRB = (1<<TXEN);
+	UCSRC = (1<<URSEL) | (1<<UCSZ1) | (1<<UCSZ0);   // 8N1
+}
+
+void UART_InitStream(void)
+{
+	// Con U2X el divisor es 8: 500 kbaud exactos a 8 MHz
+	uint16_t ubrr = (uint16_t)(F_CPU / (8UL * UART_STREAM_BAUD) - 1);
+
+	UBRRH = (uint8_t)(ubrr >> 8);
+	UBRRL = (uint8_t)ubrr;
+	UCSRA = (1<<U2X);
+	UCSRB = (1<<RXCIE) | (1<<RXEN) | (1<<TXEN);
+	UCSRC = (1<<URSEL) | (1<<UCSZ1) | (1<<UCSZ0);   // 8N1
+}
+
+void UART_PutChar(char c)
+{
+	while (!(UCSRA & (1<<UDRE)));
+	UDR = (uint8_t)c;
+}
+
+void UART_PutString(const char *s)
+{
+	while (*s)
+		UART_PutChar(*s++);
+}
+
+void UART_PutU32(uint32_t v)
+{
+	char digits[10];
+	uint8_t n = 0;
+
+	do {
+		digits[n++] = (char)('0' + v % 10);
+		v /= 10;
+	} while (v);
+
+	while (n)
+		UART_PutChar(digits[--n]);
+}
@@ -0,0 +1,26 @@
+// uart.h - USART: salida de texto y recepcin para uart_stream.c
+#ifndef UART_H_
+#define UART_H_
+
+#include <stdint.h>
+
+#define UART_BAUD         38400UL
+#define UART_STREAM_BAUD  500000UL   // U2X y UBRR = 1 a 8 MHz: error 0 %
+
+// La USART ocupa RXD/TXD (PD0/PD1): los botones van en PD3/PD4.
+
+// 8N1 a UART_BAUD, solo transmisin.
+void UART_Init(void);
+
+// 8N1 a UART_STREAM_BAUD, con la recepcin por interrupcin
+// (USART_RXC_vect, en uart_stream.c) y la transmisin para el control de
+// flujo y las respuestas.
+void UART_InitStream(void);
+
+void UART_PutChar(char c);
+void UART_PutString(const char *s);
+
+// Entero sin signo en decimal
+void UART_PutU32(uint32_t v);
+
+#endif /* UART_H_ */
@@ -0,0 +1,255 @@
+// uart_stream.c - Imgenes por la USART, sin pasar por la SD
+//
+// La ISR solo guarda bytes en un buffer circular; la decodificacin
+// (cabecera, RLE, CRC) y el envo al TFT se hacen en USTREAM_Poll, desde
+// el bucle principal. A UART_STREAM_BAUD llega un byte cada 160 ciclos,
+// de sobra para el CRC y un pxel por SPI cada dos bytes.
+
+#include "uart_stream.h"
+#include "uart.h"
+#include "tft_st7735.h"
+#include "cycles.h"
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#include <util/crc16.h>
+
+#ifndef F_CPU
+#define F_CPU 8000000UL
+#endif
+
+#define USTREAM_RX_MASK         (USTREAM_RX_SIZE - 1)
+#define USTREAM_TIMEOUT_CYCLES  ((uint32_t)USTREAM_TIMEOUT_MS * (F_CPU / 1000UL))
+
+USTREAM_Stats g_ustream_stats;
+
+/* ---------- Recepcin ---------- */
+
+static volatile uint8_t us_rx_buf[USTREAM_RX_SIZE];
+static volatile uint8_t us_rx_head;    // lo escribe la ISR
+static volatile uint8_t us_rx_tail;    // lo escribe USTREAM_Get
+static volatile uint8_t us_xoff;       // XOFF mandado, falta el XON
+
+ISR(USART_RXC_vect)
+{
+	uint8_t dor  = UCSRA & (1<<DOR);     // antes de leer UDR
+	uint8_t b    = UDR;
+	uint8_t head = us_rx_head;
+	uint8_t next = (head + 1) & USTREAM_RX_MASK;
+
+	if (dor) g_ustream_stats.overruns++;
+
+	if (next == us_rx_tail) {
+		g_ustream_stats.overruns++;
+	} else {
+		us_rx_buf[head] = b;
+		us_rx_head = next;
+	}
+
+	if (!us_xoff && ((next - us_rx_tail) & USTREAM_RX_MASK) >= USTREAM_XOFF_AT) {
+		UART_PutChar(USTREAM_XOFF);
+		us_xoff = 1;
+		g_ustream_stats.xoffs++;
+	}
+}
+
+// Fuera de la ISR: sin interrupciones para que un XOFF no se cuele entre
+// la espera de UDRE y la escritura de UDR
+static void USTREAM_Send(uint8_t c)
+{
+	uint8_t sreg = SREG;
+	cli();
+	UART_PutChar((char)c);
+	SREG = sreg;
+}
+
+static uint8_t USTREAM_Get(uint8_t *b)
+{
+	uint8_t tail = us_rx_tail;
+	if (tail == us_rx_head) return 0;
+
+	*b = us_rx_buf[tail];
+	tail = (tail + 1) & USTREAM_RX_MASK;
+	us_rx_tail = tail;
+
+	// Con el buffer casi vaco la ISR no puede volver a mandar XOFF
+	// mientras tanto: USTREAM_XON_AT queda muy por debajo de USTREAM_XOFF_AT
+	if (us_xoff && ((us_rx_head - tail) & USTREAM_RX_MASK) <= USTREAM_XON_AT) {
+		us_xoff = 0;
+		USTREAM_Send(USTREAM_XON);
+	}
+	return 1;
+}
+
+/* ---------- Decodificacin ---------- */
+
+#define US_SYNC     0
+#define US_HEADER   1
+#define US_CTRL     2     // byte de control RLE
+#define US_PIX_HI   3
+#define US_PIX_LO   4
+#define US_CRC_LO   5
+#define US_CRC_HI   6
+
+static uint8_t  us_state;
+static uint8_t  us_hdr[5];     // tipo, x, y, ancho, alto
+static uint8_t  us_n;
+static uint16_t us_crc;
+static uint16_t us_left;       // pxeles que faltan de la trama
+static uint8_t  us_count;      // pxeles que faltan del paquete RLE
+static uint8_t  us_run;        // el paquete es una repeticin
+static uint8_t  us_hi;
+static uint32_t us_last;       // CYC_Now de la ltima vez que lleg algo
+
+void USTREAM_Init(void)
+{
+	us_rx_head = us_rx_tail = 0;
+	us_xoff  = 0;
+	us_state = US_SYNC;
+	UART_InitStream();
+}
+
+uint8_t USTREAM_Waiting(void)
+{
+	uint8_t tail = us_rx_tail;
+
+	while (tail != us_rx_head && us_rx_buf[tail] != USTREAM_SYNC) {
+		uint8_t b;
+		USTREAM_Get(&b);
+		tail = us_rx_tail;
+	}
+	return tail != us_rx_head;
+}
+
+uint8_t USTREAM_Pending(void)
+{
+	return us_rx_tail != us_rx_head;
+}
+
+void USTREAM_Abort(void)
+{
+	if (us_state >= US_CTRL && us_state <= US_PIX_LO)
+		TFT_EndWrite();
+	us_state = US_SYNC;
+}
+
+static uint8_t USTREAM_Reject(uint8_t reply)
+{
+	USTREAM_Abort();
+	g_ustream_stats.errors++;
+	USTREAM_Send(reply);
+	return USTREAM_FRAME;
+}
+
+static uint8_t USTREAM_BeginFrame(void)
+{
+	uint8_t type = us_hdr[0], x = us_hdr[1], y = us_hdr[2];
+	uint8_t w = us_hdr[3], h = us_hdr[4];
+
+	if (type > USTREAM_RLE || w == 0 || h == 0 ||
+	    x + w > TFT_WIDTH || y + h > TFT_HEIGHT)
+		return 0;
+
+	us_left  = (uint16_t)w * h;
+	us_count = 0;
+	us_run   = 0;
+	TFT_SetAddrWindow(x, y, x + w - 1, y + h - 1);
+	TFT_StartWrite();
+	us_state = (type == USTREAM_RLE) ? US_CTRL : US_PIX_HI;
+	return 1;
+}
+
+// Tras cada pxel (o repeticin) pintado
+static void USTREAM_NextPixel(void)
+{
+	if (us_left == 0) {
+		TFT_EndWrite();
+		us_state = US_CRC_LO;
+	} else if (us_hdr[0] == USTREAM_RAW || us_count) {
+		us_state = US_PIX_HI;
+	} else {
+		us_state = US_CTRL;
+	}
+}
+
+uint8_t USTREAM_Poll(void)
+{
+	uint8_t b, got = 0;
+
+	while (USTREAM_Get(&b)) {
+		got = 1;
+		if (us_state != US_SYNC && us_state < US_CRC_LO)
+			us_crc = _crc_ccitt_update(us_crc, b);
+
+		switch (us_state) {
+		case US_SYNC:
+			if (b == USTREAM_SYNC) {
+				us_state = US_HEADER;
+				us_n = 0;
+				us_crc = 0xFFFF;
+			}
+			break;
+
+		case US_HEADER:
+			us_hdr[us_n++] = b;
+			if (us_n == sizeof(us_hdr) && !USTREAM_BeginFrame())
+				return USTREAM_Reject(USTREAM_NAK_FORMAT);
+			break;
+
+		case US_CTRL:
+			us_run   = b & 0x80;
+			us_count = (b & 0x7F) + 1;
+			if (us_count > us_left)
+				return USTREAM_Reject(USTREAM_NAK_FORMAT);
+			us_state = US_PIX_HI;
+			break;
+
+		case US_PIX_HI:
+			us_hi = b;
+			us_state = US_PIX_LO;
+			break;
+
+		case US_PIX_LO: {
+			uint16_t color = (uint16_t)us_hi << 8 | b;
+			if (us_run) {
+				TFT_WriteColorRun(color, us_count);
+				us_left -= us_count;
+				us_count = 0;
+			} else {
+				TFT_WriteColor(color);
+				us_left--;
+				if (us_count) us_count--;
+			}
+			USTREAM_NextPixel();
+			break;
+		}
+
+		case US_CRC_LO:
+			us_hi = b;
+			us_state = US_CRC_HI;
+			break;
+
+		case US_CRC_HI:
+			us_state = US_SYNC;
+			if (((uint16_t)b << 8 | us_hi) != us_crc) {
+				g_ustream_stats.errors++;
+				USTREAM_Send(USTREAM_NAK_CRC);
+			} else {
+				g_ustream_stats.frames++;
+				USTREAM_Send(USTREAM_ACK);
+			}
+			return USTREAM_FRAME;
+		}
+	}
+
+	if (us_state == US_SYNC) return USTREAM_IDLE;
+
+	uint32_t now = CYC_Now();
+	if (got) us_last = now;
+
+	// El host call a mitad de trama: descartarla para no quedarse
+	// esperando para siempre con la rfaga del TFT abierta
+	if (now - us_last > USTREAM_TIMEOUT_CYCLES)
+		return USTREAM_Reject(USTREAM_NAK_TIMEOUT);
+
+	return USTREAM_BUSY;
+}
@@ -0,0 +1,77 @@
+// uart_stream.h - Imgenes por la USART, sin pasar por la SD
+#ifndef UART_STREAM_H_
+#define UART_STREAM_H_
+
+#include <stdint.h>
+
+// Protocolo (host/sendimg.c es el otro extremo). Cada trama:
+//   0  0xA5 (sincronismo)
+//   1  u8 tipo: USTREAM_RAW o USTREAM_RLE
+//   2  u8 x, u8 y, u8 ancho, u8 alto  (rectngulo en coordenadas de pantalla)
+//   6  pxeles RGB565, MSB primero, fila a fila
+//      RAW: ancho * alto pxeles tal cual
+//      RLE: paquetes con un byte de control c
+//           bit 7 a 1: el pxel que sigue, (c & 0x7F) + 1 veces
+//           bit 7 a 0: c + 1 pxeles literales
+//           Pueden cruzar filas; tienen que sumar ancho * alto.
+//   .. u16 CRC (little endian) de los bytes 1 al ltimo de pxeles: la de
+//      _crc_ccitt_update de <util/crc16.h> (polinomio 0x8408 reflejado,
+//      valor inicial 0xFFFF)
+// Al acabar cada trama el AVR contesta un byte: USTREAM_ACK o uno de los
+// USTREAM_NAK_*. Los pxeles van al TFT segn llegan, as que una trama
+// rechazada ya est pintada (mal): el host espera USTREAM_TIMEOUT_MS y la
+// repite.
+//
+// Control de flujo XON/XOFF del AVR al host: XOFF cuando el buffer de
+// recepcin llega a USTREAM_XOFF_AT bytes y XON al bajar a USTREAM_XON_AT.
+// Los bytes que quedan libres detrs de XOFF son los que el host puede
+// seguir mandando mientras reacciona (el FIFO de un adaptador USB incluido).
+
+#define USTREAM_SYNC        0xA5
+#define USTREAM_RAW         0
+#define USTREAM_RLE         1
+
+#define USTREAM_ACK         'K'
+#define USTREAM_NAK_CRC     'E'
+#define USTREAM_NAK_FORMAT  'F'   // rectngulo fuera del panel o RLE que se pasa
+#define USTREAM_NAK_TIMEOUT 'T'   // la trama se cort a medias
+#define USTREAM_XON         0x11
+#define USTREAM_XOFF        0x13
+
+#define USTREAM_RX_SIZE     128   // potencia de 2
+#define USTREAM_XOFF_AT     32
+#define USTREAM_XON_AT      8
+#define USTREAM_TIMEOUT_MS  50    // sin bytes a mitad de trama: se descarta
+
+// Resultado de USTREAM_Poll
+#define USTREAM_IDLE        0     // no hay trama a medias
+#define USTREAM_BUSY        1     // a mitad de trama, esperando bytes
+#define USTREAM_FRAME       2     // acaba de terminar una (buena o no)
+
+typedef struct {
+	uint16_t frames;      // tramas pintadas con el CRC bien
+	uint16_t errors;      // tramas rechazadas (CRC, formato o tiempo)
+	uint16_t overruns;    // bytes perdidos: buffer lleno o DOR
+	uint16_t xoffs;       // veces que se pidi al host que parase
+} USTREAM_Stats;
+
+extern USTREAM_Stats g_ustream_stats;
+
+// UART_InitStream y buffer vaco. Hacen falta las interrupciones (sei()).
+void USTREAM_Init(void);
+
+// 1 si el siguiente byte recibido es un sincronismo. Descarta lo que
+// haya antes (ruido, restos de una trama cortada).
+uint8_t USTREAM_Waiting(void);
+
+// 1 si hay bytes recibidos sin procesar
+uint8_t USTREAM_Pending(void);
+
+// Procesa todo lo recibido y pinta los pxeles en el TFT. Entre tramas
+// no deja ninguna rfaga abierta: el bus queda libre para la SD.
+uint8_t USTREAM_Poll(void);
+
+// Deja la trama en curso (si la hay) sin contestar
+void USTREAM_Abort(void);
+
+#endif /* UART_STREAM_H_ */